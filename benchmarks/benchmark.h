@@ -0,0 +1,258 @@
+#ifndef DCGP_BENCHMARK_H
+#define DCGP_BENCHMARK_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace dcgp_benchmark {
+
+/// Keeps the compiler from optimizing away a result
+template <typename T>
+inline void do_not_optimize(const T& value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+/// Hardware counters of the calling thread (cycles, instructions, cache misses), read through perf_event_open
+/**
+ * The counters are not available when the kernel does not allow them (e.g. perf_event_paranoid, containers):
+ * dcgp_benchmark::hardware_counters::available is then false and the benchmarks only report times.
+ */
+class hardware_counters {
+public:
+    hardware_counters() : m_fd{-1, -1, -1}
+    {
+#ifdef __linux__
+        const std::uint64_t config[3] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES};
+        for (auto k = 0u; k < 3u; ++k)
+        {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = config[k];
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            m_fd[k] = static_cast<int>(::syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+            if (m_fd[k] < 0)
+            {
+                close_all();
+                return;
+            }
+        }
+#endif
+    }
+    ~hardware_counters()
+    {
+        close_all();
+    }
+    hardware_counters(const hardware_counters&) = delete;
+    hardware_counters& operator=(const hardware_counters&) = delete;
+
+    bool available() const {return m_fd[0] >= 0;}
+
+    void start()
+    {
+#ifdef __linux__
+        for (auto fd : m_fd)
+        {
+            ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    /// Stops counting and gets the counts since dcgp_benchmark::hardware_counters::start
+    std::vector<double> stop()
+    {
+        std::vector<double> retval(3, 0.);
+#ifdef __linux__
+        for (auto k = 0u; k < 3u; ++k)
+        {
+            ::ioctl(m_fd[k], PERF_EVENT_IOC_DISABLE, 0);
+            std::uint64_t count = 0u;
+            if (::read(m_fd[k], &count, sizeof(count)) == static_cast<ssize_t>(sizeof(count))) retval[k] = static_cast<double>(count);
+        }
+#endif
+        return retval;
+    }
+
+private:
+    void close_all()
+    {
+#ifdef __linux__
+        for (auto &fd : m_fd)
+        {
+            if (fd >= 0) ::close(fd);
+            fd = -1;
+        }
+#endif
+    }
+
+    int m_fd[3];
+};
+
+/// Statistics of one benchmark
+struct result
+{
+    std::string m_name;
+    // work units (e.g. node evaluations) done by one operation
+    double m_work;
+    // operations timed in each repetition
+    unsigned long m_batch;
+    // seconds per operation, one per repetition, sorted
+    std::vector<double> m_times;
+    // cycles, instructions and cache misses per operation (empty if not available)
+    std::vector<double> m_counters;
+
+    double percentile(double p) const
+    {
+        const double pos = p / 100. * static_cast<double>(m_times.size() - 1u);
+        const std::size_t lo = static_cast<std::size_t>(pos);
+        const std::size_t hi = std::min(lo + 1u, m_times.size() - 1u);
+        return m_times[lo] + (pos - static_cast<double>(lo)) * (m_times[hi] - m_times[lo]);
+    }
+    double median() const {return percentile(50.);}
+    double mean() const
+    {
+        double sum = 0.;
+        for (auto t : m_times) sum += t;
+        return sum / static_cast<double>(m_times.size());
+    }
+    double stddev() const
+    {
+        const double mu = mean();
+        double sum = 0.;
+        for (auto t : m_times) sum += (t - mu) * (t - mu);
+        return (m_times.size() > 1u) ? std::sqrt(sum / static_cast<double>(m_times.size() - 1u)) : 0.;
+    }
+    /// Work units per second, at the median
+    double throughput() const {return m_work / median();}
+};
+
+/// Options of the benchmark runner
+struct options
+{
+    options() : m_repetitions(30u), m_warmup(3u), m_min_time(0.01), m_filter(), m_json() {};
+    // number of timed repetitions
+    unsigned int m_repetitions;
+    // number of untimed repetitions run first
+    unsigned int m_warmup;
+    // minimum duration of one repetition (seconds), the batch size is grown until it is reached
+    double m_min_time;
+    // only the benchmarks whose name contains it are run
+    std::string m_filter;
+    // file the results are written to (JSON), none if empty
+    std::string m_json;
+};
+
+/// Runs benchmarks: calibration, warm-up, repetitions and statistics
+class runner {
+public:
+    explicit runner(const options& opt) : m_options(opt), m_results() {};
+
+    /// Times an operation
+    /**
+     * \param[in] name the name of the benchmark
+     * \param[in] work the work units (e.g. node evaluations) done by one call of op
+     * \param[in] op the operation, called batch times per repetition
+     */
+    void run(const std::string& name, double work, const std::function<void(unsigned long)>& op)
+    {
+        if (!m_options.m_filter.empty() && name.find(m_options.m_filter) == std::string::npos) return;
+        result r;
+        r.m_name = name;
+        r.m_work = work;
+        // calibration: the batch is doubled until one repetition lasts at least m_min_time
+        r.m_batch = 1u;
+        while (time(op, r.m_batch) < m_options.m_min_time && r.m_batch < (1ul << 40))
+        {
+            r.m_batch *= 2u;
+        }
+        for (auto k = 0u; k < m_options.m_warmup; ++k)
+        {
+            time(op, r.m_batch);
+        }
+        hardware_counters counters;
+        if (counters.available())
+        {
+            r.m_counters.assign(3u, 0.);
+        }
+        for (auto k = 0u; k < m_options.m_repetitions; ++k)
+        {
+            if (counters.available()) counters.start();
+            r.m_times.push_back(time(op, r.m_batch) / static_cast<double>(r.m_batch));
+            if (counters.available())
+            {
+                std::vector<double> c = counters.stop();
+                for (auto j = 0u; j < 3u; ++j)
+                {
+                    r.m_counters[j] += c[j] / static_cast<double>(r.m_batch) / static_cast<double>(m_options.m_repetitions);
+                }
+            }
+        }
+        std::sort(r.m_times.begin(), r.m_times.end());
+        std::cout << name << ": median " << r.median() * 1e9 << " ns [p5 " << r.percentile(5.) * 1e9 << ", p95 "
+                  << r.percentile(95.) * 1e9 << "], " << r.throughput() << " work/s" << std::endl;
+        m_results.push_back(r);
+    }
+
+    /// Gets the results as JSON
+    std::string json() const
+    {
+        std::ostringstream os;
+        os.precision(17);
+        os << "{\n  \"repetitions\": " << m_options.m_repetitions << ",\n  \"benchmarks\": [";
+        for (auto k = 0u; k < m_results.size(); ++k)
+        {
+            const result& r = m_results[k];
+            os << (k ? "," : "") << "\n    {\"name\": \"" << r.m_name << "\", \"batch\": " << r.m_batch
+               << ", \"median\": " << r.median() << ", \"mean\": " << r.mean() << ", \"stddev\": " << r.stddev()
+               << ", \"min\": " << r.m_times.front() << ", \"max\": " << r.m_times.back()
+               << ", \"p5\": " << r.percentile(5.) << ", \"p25\": " << r.percentile(25.)
+               << ", \"p75\": " << r.percentile(75.) << ", \"p95\": " << r.percentile(95.)
+               << ", \"work\": " << r.m_work << ", \"throughput\": " << r.throughput();
+            if (!r.m_counters.empty())
+            {
+                os << ", \"cycles\": " << r.m_counters[0] << ", \"instructions\": " << r.m_counters[1] << ", \"cache_misses\": " << r.m_counters[2];
+            }
+            os << "}";
+        }
+        os << "\n  ]\n}\n";
+        return os.str();
+    }
+
+    const std::vector<result>& results() const {return m_results;}
+
+private:
+    static double time(const std::function<void(unsigned long)>& op, unsigned long batch)
+    {
+        const auto begin = std::chrono::steady_clock::now();
+        op(batch);
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(end - begin).count();
+    }
+
+    options m_options;
+    std::vector<result> m_results;
+};
+
+} // end of namespace dcgp_benchmark
+
+#endif // DCGP_BENCHMARK_H
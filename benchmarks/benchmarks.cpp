@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/dcgp.h"
+#include "benchmark.h"
+
+namespace {
+
+struct shape
+{
+    unsigned int n, m, r, c, l;
+};
+
+// The shapes of the former profiling executables
+const shape shapes[] = {{2, 4, 2, 3, 4}, {2, 4, 10, 10, 11}, {2, 4, 20, 20, 21}, {1, 1, 1, 100, 101}, {1, 1, 2, 100, 101}, {1, 1, 3, 100, 101}};
+
+std::string shape_name(const shape& s)
+{
+    return std::to_string(s.n) + "x" + std::to_string(s.m) + "_r" + std::to_string(s.r) + "c" + std::to_string(s.c) + "l" + std::to_string(s.l);
+}
+
+// Random points, cycled through by the benchmarks
+std::vector<std::vector<double> > make_points(unsigned int n, unsigned int seed)
+{
+    std::default_random_engine re(seed);
+    std::vector<std::vector<double> > retval(1024u, std::vector<double>(n));
+    for (auto &point : retval)
+    {
+        for (auto &x : point) x = std::uniform_real_distribution<double>(-1, 1)(re);
+    }
+    return retval;
+}
+
+// Number of function nodes evaluated by the expression
+double active_functions(const dcgp::expression& ex)
+{
+    double retval = 0.;
+    for (auto i : ex.get_active_nodes())
+    {
+        if (i >= ex.get_n()) retval += 1.;
+    }
+    return retval;
+}
+
+void expression_benchmarks(dcgp_benchmark::runner& bench, const std::string& set_name, const dcgp::function_set& set)
+{
+    for (const auto &s : shapes)
+    {
+        const std::string suffix = "/" + set_name + "/" + shape_name(s);
+        dcgp::expression ex(s.n, s.m, s.r, s.c, s.l, set(), 123);
+        const std::vector<std::vector<double> > points = make_points(s.n, 123);
+        const double nodes = active_functions(ex);
+        dcgp::workspace ws;
+        // outputs, or coefficients of the second order derivatives
+        std::vector<double> out(3u * s.m);
+
+        bench.run("evaluate" + suffix, nodes, [&](unsigned long batch) {
+            for (auto i = 0ul; i < batch; ++i) dcgp_benchmark::do_not_optimize(ex(points[i % points.size()]));
+        });
+        bench.run("eval_into" + suffix, nodes, [&](unsigned long batch) {
+            for (auto i = 0ul; i < batch; ++i)
+            {
+                ex.eval_into(points[i % points.size()].data(), out.data(), ws);
+                dcgp_benchmark::do_not_optimize(out[0]);
+            }
+        });
+        if (s.m > 1u)
+        {
+            // only the first output, work is still all the active nodes
+            const unsigned int first = 0u;
+            bench.run("eval_outputs_into" + suffix, nodes, [&](unsigned long batch) {
+                for (auto i = 0ul; i < batch; ++i)
+                {
+                    ex.eval_outputs_into(points[i % points.size()].data(), &first, 1u, out.data(), ws);
+                    dcgp_benchmark::do_not_optimize(out[0]);
+                }
+            });
+        }
+        // second order derivatives: three Taylor coefficients per node
+        bench.run("differentiate" + suffix, 3. * nodes, [&](unsigned long batch) {
+            for (auto i = 0ul; i < batch; ++i) dcgp_benchmark::do_not_optimize(ex.differentiate(0u, 2u, points[i % points.size()]));
+        });
+        bench.run("differentiate_into" + suffix, 3. * nodes, [&](unsigned long batch) {
+            for (auto i = 0ul; i < batch; ++i)
+            {
+                ex.differentiate_into(0u, 2u, points[i % points.size()].data(), out.data(), ws);
+                dcgp_benchmark::do_not_optimize(out[0]);
+            }
+        });
+        // work is one mutation (including the update of the active nodes)
+        dcgp::expression mutant(ex);
+        bench.run("mutate_active" + suffix, 1., [&](unsigned long batch) {
+            for (auto i = 0ul; i < batch; ++i) mutant.mutate_active();
+            dcgp_benchmark::do_not_optimize(mutant.get()[0]);
+        });
+    }
+}
+
+void fitness_benchmarks(dcgp_benchmark::runner& bench)
+{
+    dcgp::function_set basic_set({"sum","diff","mul","div"});
+    dcgp::expression ex(2, 1, 1, 100, 101, basic_set(), 123);
+    const std::vector<std::vector<double> > points = make_points(2, 456);
+    dcgp::dataset data(points.size(), 2, 1);
+    for (auto i = 0u; i < points.size(); ++i)
+    {
+        data.set_in(i, 0, points[i][0]);
+        data.set_in(i, 1, points[i][1]);
+        data.set_out(i, 0, points[i][0] * points[i][1]);
+    }
+    bench.run("simple_data_fit/basic/2x1_r1c100l101", active_functions(ex) * static_cast<double>(data.rows()), [&](unsigned long batch) {
+        for (auto i = 0ul; i < batch; ++i) dcgp_benchmark::do_not_optimize(dcgp::simple_data_fit(ex, data));
+    });
+    // a fixed lineage of mutants, as evaluated by the evolution drivers, cycled through with and without the
+    // semantic cache (which, after the first cycle, holds the columns of the lineage): work is their mean active nodes
+    dcgp::semantic_cache cache(data, basic_set());
+    std::vector<dcgp::expression> lineage(1u, ex);
+    double lineage_nodes = 0.;
+    for (auto k = 0u; k < 1024u; ++k)
+    {
+        lineage.push_back(lineage.back());
+        lineage.back().mutate_active();
+        lineage_nodes += active_functions(lineage.back());
+    }
+    lineage.erase(lineage.begin());
+    const double lineage_work = lineage_nodes / static_cast<double>(lineage.size()) * static_cast<double>(data.rows());
+    bench.run("mutant_data_fit/basic/2x1_r1c100l101", lineage_work, [&](unsigned long batch) {
+        for (auto i = 0ul; i < batch; ++i) dcgp_benchmark::do_not_optimize(dcgp::simple_data_fit(lineage[i % lineage.size()], data));
+    });
+    bench.run("mutant_data_fit_cached/basic/2x1_r1c100l101", lineage_work, [&](unsigned long batch) {
+        for (auto i = 0ul; i < batch; ++i) dcgp_benchmark::do_not_optimize(dcgp::simple_data_fit(lineage[i % lineage.size()], cache));
+    });
+}
+
+void function_call_benchmarks(dcgp_benchmark::runner& bench)
+{
+    dcgp::function_set sum({"sum"});
+    const dcgp::basis_function& f = sum()[0];
+    const std::vector<std::vector<double> > points = make_points(2, 789);
+    std::vector<std::vector<double> > a(points.size()), b(points.size());
+    for (auto i = 0u; i < points.size(); ++i)
+    {
+        a[i] = {points[i][0], 1., 0.};
+        b[i] = {points[i][1], 0., 0.};
+    }
+    bench.run("function_call/my_sum", 1., [&](unsigned long batch) {
+        for (auto i = 0ul; i < batch; ++i) dcgp_benchmark::do_not_optimize(dcgp::my_sum(points[i % points.size()][0], points[i % points.size()][1]));
+    });
+    bench.run("function_call/basis_function_sum", 1., [&](unsigned long batch) {
+        for (auto i = 0ul; i < batch; ++i) dcgp_benchmark::do_not_optimize(f.m_f(points[i % points.size()][0], points[i % points.size()][1]));
+    });
+    bench.run("function_call/d_my_sum", 1., [&](unsigned long batch) {
+        for (auto i = 0ul; i < batch; ++i) dcgp_benchmark::do_not_optimize(dcgp::d_my_sum(a[i % a.size()], b[i % b.size()]));
+    });
+    bench.run("function_call/basis_function_d_sum", 1., [&](unsigned long batch) {
+        for (auto i = 0ul; i < batch; ++i) dcgp_benchmark::do_not_optimize(f.m_df(a[i % a.size()], b[i % b.size()]));
+    });
+}
+
+// A very wide expression evaluated on a batch of points, point by point and level by level
+void wide_benchmarks(dcgp_benchmark::runner& bench)
+{
+    dcgp::function_set basic_set({"sum","diff","mul","div"});
+    dcgp::expression ex(4, 4, 100, 50, 2, basic_set(), 123);
+    const std::vector<std::vector<double> > points = make_points(4, 321);
+    std::vector<double> in, out(points.size() * 4u);
+    for (const auto &p : points) in.insert(in.end(), p.begin(), p.end());
+    const double work = active_functions(ex) * static_cast<double>(points.size());
+    dcgp::workspace ws;
+
+    bench.run("batch_eval_into/basic/4x4_r100c50l2", work, [&](unsigned long batch) {
+        for (auto i = 0ul; i < batch; ++i)
+        {
+            for (auto k = 0u; k < points.size(); ++k) ex.eval_into(&in[k * 4u], &out[k * 4u], ws);
+            dcgp_benchmark::do_not_optimize(out[0]);
+        }
+    });
+    // one thread, then one per hardware thread
+    for (auto t = 0u; t < 2u; ++t)
+    {
+        dcgp::level_evaluator le(ex, t ? 0u : 1u);
+        bench.run(std::string("level_evaluator/") + (t ? "parallel" : "serial") + "/basic/4x4_r100c50l2", work, [&](unsigned long batch) {
+            for (auto i = 0ul; i < batch; ++i)
+            {
+                le(in.data(), out.data(), points.size());
+                dcgp_benchmark::do_not_optimize(out[0]);
+            }
+        });
+    }
+}
+
+// Islands evolving the Koza quintic x^5 - 2x^3 + x, as many generations per operation on each island
+void island_benchmarks(dcgp_benchmark::runner& bench)
+{
+    dcgp::function_set basic_set({"sum","diff","mul","div"});
+    dcgp::expression prototype(1, 1, 1, 15, 16, basic_set(), 123);
+    const std::vector<std::vector<double> > points = make_points(1, 654);
+    dcgp::dataset data(32u, 1, 1);
+    for (auto i = 0u; i < data.rows(); ++i)
+    {
+        const double x = points[i][0];
+        data.set_in(i, 0, x);
+        data.set_out(i, 0, x * x * x * x * x - 2. * x * x * x + x);
+    }
+    const unsigned int n_islands = 4u, lambda = 4u, generations = 100u;
+    dcgp::island_model archipelago(prototype, [&data](const dcgp::expression& ex) {return dcgp::simple_data_fit(ex, data);}, n_islands, dcgp::migration_topology::RING, lambda, 10u, 123u);
+    // work is the fitness evaluations, the target is never reached
+    bench.run("island_model/ring4/basic/1x1_r1c15l16", static_cast<double>(n_islands * lambda * generations), [&](unsigned long batch) {
+        for (auto i = 0ul; i < batch; ++i) dcgp_benchmark::do_not_optimize(archipelago.evolve(generations, std::numeric_limits<double>::infinity()));
+    });
+}
+
+void usage()
+{
+    std::cerr << "Usage: dcgp_benchmarks [--json FILE] [--repetitions N] [--warmup N] [--min-time SECONDS] [--filter SUBSTRING]" << std::endl;
+}
+
+}
+
+/// Benchmarks of the expression evaluation, differentiation, mutation and fitness
+/**
+ * Each benchmark is calibrated, warmed up and repeated: the median, percentiles and throughput (in node evaluations
+ * per second, where applicable) are printed, and written as JSON with --json. Use benchmarks/compare.py to compare
+ * the JSON output against a baseline.
+ */
+int main(int argc, char **argv) {
+    dcgp_benchmark::options opt;
+    for (auto i = 1; i < argc; ++i)
+    {
+        const std::string arg(argv[i]);
+        if (i + 1 >= argc)
+        {
+            usage();
+            return 1;
+        }
+        if (arg == "--json") {
+            opt.m_json = argv[++i];
+        } else if (arg == "--repetitions") {
+            opt.m_repetitions = static_cast<unsigned int>(std::max(1l, std::atol(argv[++i])));
+        } else if (arg == "--warmup") {
+            opt.m_warmup = static_cast<unsigned int>(std::atol(argv[++i]));
+        } else if (arg == "--min-time") {
+            opt.m_min_time = std::atof(argv[++i]);
+        } else if (arg == "--filter") {
+            opt.m_filter = argv[++i];
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    dcgp_benchmark::runner bench(opt);
+    dcgp::function_set basic_set({"sum","diff","mul","div"});
+    dcgp::function_set sqrt_set({"sum","diff","sqrt","pow"});
+    expression_benchmarks(bench, "basic", basic_set);
+    expression_benchmarks(bench, "sqrt", sqrt_set);
+    fitness_benchmarks(bench);
+    wide_benchmarks(bench);
+    function_call_benchmarks(bench);
+    island_benchmarks(bench);
+
+    if (!opt.m_json.empty())
+    {
+        std::ofstream file(opt.m_json);
+        file << bench.json();
+        if (!file)
+        {
+            std::cerr << "Could not write " << opt.m_json << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
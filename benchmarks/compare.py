@@ -0,0 +1,53 @@
+#!/usr/bin/env python3
+"""Compares the JSON output of dcgp_benchmarks against a baseline.
+
+Usage: compare.py BASELINE.json CURRENT.json [--threshold 0.05]
+
+A benchmark regresses when its median time grew by more than the threshold
+(relative) and the two runs are clearly apart: the 25th percentile of the
+current run is above the 75th percentile of the baseline. The exit status is
+1 if any benchmark regressed, so that the script can gate a CI job.
+
+To store a baseline: dcgp_benchmarks --json baseline.json
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(filename):
+    with open(filename) as f:
+        return {b["name"]: b for b in json.load(f)["benchmarks"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Flags the benchmarks that regressed against a baseline.")
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.05, help="relative slowdown of the median tolerated (default 0.05)")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+    regressions = 0
+    print("%-50s %12s %12s %8s" % ("benchmark", "baseline ns", "current ns", "change"))
+    for name in sorted(set(baseline) & set(current)):
+        old, new = baseline[name], current[name]
+        change = new["median"] / old["median"] - 1.
+        regressed = change > args.threshold and new["p25"] > old["p75"]
+        improved = change < -args.threshold and new["p75"] < old["p25"]
+        tag = "REGRESSION" if regressed else ("improved" if improved else "")
+        print("%-50s %12.1f %12.1f %+7.1f%% %s" % (name, old["median"] * 1e9, new["median"] * 1e9, 100. * change, tag))
+        regressions += regressed
+    for name in sorted(set(baseline) - set(current)):
+        print("%-50s missing from the current run" % name)
+    for name in sorted(set(current) - set(baseline)):
+        print("%-50s new, no baseline" % name)
+    if regressions:
+        print("%d benchmark(s) regressed" % regressions)
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
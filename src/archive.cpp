@@ -0,0 +1,308 @@
+#include <cstddef>
+#include <cstring>
+#include <limits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "archive.h"
+#include "exceptions.h"
+#include "function_set.h"
+
+namespace dcgp {
+
+static_assert(sizeof(unsigned int) == sizeof(std::uint32_t), "dcgp::archive maps genes as 32 bits unsigned integers");
+
+namespace {
+const char archive_magic[8] = {'D', 'C', 'G', 'P', 'A', 'R', 'C', 'H'};
+const std::uint32_t archive_byte_order = 0x01020304u;
+const std::uint32_t archive_version = 1u;
+// Chromosome and fitness blocks start on a cache line boundary
+const std::uint64_t archive_alignment = 64u;
+
+// The fixed-size header found at the beginning of every archive. It is followed by the function names
+// (each stored as a 32 bits length and the characters), then by the chromosome and fitness blocks.
+struct archive_header
+{
+    char m_magic[8];
+    std::uint32_t m_byte_order;
+    std::uint32_t m_version;
+    std::uint32_t m_n;
+    std::uint32_t m_m;
+    std::uint32_t m_r;
+    std::uint32_t m_c;
+    std::uint32_t m_l;
+    std::uint32_t m_n_functions;
+    std::uint32_t m_chromosome_length;
+    std::uint32_t m_reserved;
+    std::uint64_t m_size;
+    std::uint64_t m_chromosomes_offset;
+    std::uint64_t m_fitness_offset;
+};
+
+std::uint64_t align(std::uint64_t offset)
+{
+    return (offset + archive_alignment - 1u) / archive_alignment * archive_alignment;
+}
+
+void write_padding(std::ofstream& os, std::uint64_t from, std::uint64_t to)
+{
+    const char zeros[archive_alignment] = {};
+    os.write(zeros, static_cast<std::streamsize>(to - from));
+}
+}
+
+/// Constructor
+/** Creates (or truncates) an archive file for chromosomes having the topology of the prototype
+ *
+ * \param[in] filename the archive file name
+ * \param[in] prototype expression defining the topology and function set of the archived chromosomes
+ *
+ * @throw dcgp::input_error if the file cannot be opened
+ */
+archive_writer::archive_writer(const std::string& filename, const expression& prototype) : m_os(filename, std::ios::binary | std::ios::trunc), m_filename(filename), m_chromosome_length(static_cast<unsigned int>(prototype.get().size())), m_chromosomes_offset(0u)
+{
+    if (!m_os)
+    {
+        throw input_error("Could not open " + filename);
+    }
+    archive_header h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.m_magic, archive_magic, sizeof(archive_magic));
+    h.m_byte_order = archive_byte_order;
+    h.m_version = archive_version;
+    h.m_n = prototype.get_n();
+    h.m_m = prototype.get_m();
+    h.m_r = prototype.get_r();
+    h.m_c = prototype.get_c();
+    h.m_l = prototype.get_l();
+    h.m_n_functions = static_cast<std::uint32_t>(prototype.get_f().size());
+    h.m_chromosome_length = m_chromosome_length;
+    // size and fitness offset are only known at close
+    m_os.write(reinterpret_cast<const char*>(&h), sizeof(h));
+
+    std::uint64_t offset = sizeof(h);
+    for (const auto &f : prototype.get_f())
+    {
+        std::uint32_t length = static_cast<std::uint32_t>(f.m_name.size());
+        m_os.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        m_os.write(f.m_name.data(), length);
+        offset += sizeof(length) + length;
+    }
+    m_chromosomes_offset = align(offset);
+    write_padding(m_os, offset, m_chromosomes_offset);
+}
+
+/// Destructor (closes the archive if still open)
+archive_writer::~archive_writer()
+{
+    try {
+        close();
+    } catch (...) {}
+}
+
+/// Appends a chromosome
+/**
+ * \param[in] x the chromosome
+ * \param[in] fitness its fitness
+ *
+ * @throw dcgp::input_error if the archive is closed or the chromosome length is incompatible
+ */
+void archive_writer::push_back(const std::vector<unsigned int>& x, double fitness)
+{
+    if (!m_os.is_open())
+    {
+        throw input_error("Archive " + m_filename + " is closed");
+    }
+    if (x.size() != m_chromosome_length)
+    {
+        throw input_error("Chromosome is incompatible");
+    }
+    m_os.write(reinterpret_cast<const char*>(x.data()), x.size() * sizeof(std::uint32_t));
+    m_fitness.push_back(fitness);
+}
+
+/// Closes the archive
+/**
+ * Writes the fitness block and completes the header. Does nothing if already closed.
+ *
+ * @throw dcgp::input_error if the file could not be written
+ */
+void archive_writer::close()
+{
+    if (!m_os.is_open()) return;
+    std::uint64_t end = m_chromosomes_offset + std::uint64_t(m_fitness.size()) * m_chromosome_length * sizeof(std::uint32_t);
+    std::uint64_t fitness_offset = align(end);
+    write_padding(m_os, end, fitness_offset);
+    m_os.write(reinterpret_cast<const char*>(m_fitness.data()), m_fitness.size() * sizeof(double));
+
+    // the last three fields of the header are contiguous
+    std::uint64_t tail[3] = {m_fitness.size(), m_chromosomes_offset, fitness_offset};
+    m_os.seekp(offsetof(archive_header, m_size));
+    m_os.write(reinterpret_cast<const char*>(tail), sizeof(tail));
+    bool ok = static_cast<bool>(m_os);
+    m_os.close();
+    if (!ok)
+    {
+        throw input_error("Could not write " + m_filename);
+    }
+}
+
+/// Constructor
+/** Opens and memory-maps an archive written by dcgp::archive_writer
+ *
+ * \param[in] filename the archive file name
+ *
+ * @throw dcgp::input_error if the file cannot be mapped or is not a valid archive
+ */
+archive::archive(const std::string& filename) : m_map(MAP_FAILED), m_map_size(0u), m_chromosomes(nullptr), m_fitness(nullptr)
+{
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw input_error("Could not open " + filename);
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(archive_header))
+    {
+        ::close(fd);
+        throw input_error(filename + " is not a d-CGP archive");
+    }
+    m_map_size = static_cast<std::size_t>(st.st_size);
+    m_map = ::mmap(nullptr, m_map_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m_map == MAP_FAILED)
+    {
+        throw input_error("Could not map " + filename);
+    }
+    // chromosomes are typically accessed by index in no particular order
+    ::madvise(m_map, m_map_size, MADV_RANDOM);
+
+    const char *base = static_cast<const char*>(m_map);
+    archive_header h;
+    std::memcpy(&h, base, sizeof(h));
+    // the sizes are bounded by divisions, so that a corrupted header cannot make the products wrap around
+    std::string error;
+    if (std::memcmp(h.m_magic, archive_magic, sizeof(archive_magic)) != 0)
+    {
+        error = filename + " is not a d-CGP archive";
+    } else if (h.m_byte_order != archive_byte_order) {
+        error = filename + " was written on a machine with a different byte order";
+    } else if (h.m_version != archive_version) {
+        error = "Unsupported archive version " + std::to_string(h.m_version);
+    } else if (h.m_r == 0u || h.m_c == 0u || std::uint64_t(h.m_r) * h.m_c > std::numeric_limits<std::uint32_t>::max() / 3u
+               || h.m_chromosome_length != 3u * std::uint64_t(h.m_r) * h.m_c + h.m_m) {
+        error = filename + " has an inconsistent topology";
+    } else if (h.m_chromosomes_offset < sizeof(h) || h.m_chromosomes_offset > h.m_fitness_offset || h.m_fitness_offset > m_map_size
+               || h.m_fitness_offset % archive_alignment != 0u
+               || h.m_size > (h.m_fitness_offset - h.m_chromosomes_offset) / (std::uint64_t(h.m_chromosome_length) * sizeof(std::uint32_t))
+               || h.m_size > (m_map_size - h.m_fitness_offset) / sizeof(double)) {
+        error = filename + " is truncated or was not closed";
+    }
+    std::uint64_t offset = sizeof(h);
+    for (auto i = 0u; error.empty() && i < h.m_n_functions; ++i)
+    {
+        std::uint32_t length;
+        if (offset + sizeof(length) > h.m_chromosomes_offset)
+        {
+            error = filename + " is corrupted";
+            break;
+        }
+        std::memcpy(&length, base + offset, sizeof(length));
+        offset += sizeof(length);
+        if (offset + length > h.m_chromosomes_offset)
+        {
+            error = filename + " is corrupted";
+            break;
+        }
+        m_function_names.push_back(std::string(base + offset, length));
+        offset += length;
+    }
+    if (!error.empty())
+    {
+        ::munmap(m_map, m_map_size);
+        throw input_error(error);
+    }
+
+    m_n = h.m_n;
+    m_m = h.m_m;
+    m_r = h.m_r;
+    m_c = h.m_c;
+    m_l = h.m_l;
+    m_chromosome_length = h.m_chromosome_length;
+    m_size = static_cast<std::size_t>(h.m_size);
+    m_chromosomes = reinterpret_cast<const std::uint32_t*>(base + h.m_chromosomes_offset);
+    m_fitness = reinterpret_cast<const double*>(base + h.m_fitness_offset);
+}
+
+/// Destructor (unmaps the archive)
+archive::~archive()
+{
+    ::munmap(m_map, m_map_size);
+}
+
+/// Gets a chromosome
+/**
+ * \param[in] i index of the chromosome
+ *
+ * \return a pointer to its first gene, in the mapped memory
+ *
+ * @throw dcgp::input_error if the index is out of range
+ */
+const unsigned int* archive::chromosome(std::size_t i) const
+{
+    if (i >= m_size)
+    {
+        throw input_error("Archive index out of range");
+    }
+    return m_chromosomes + i * m_chromosome_length;
+}
+
+/// Gets a fitness value
+/**
+ * \param[in] i index of the chromosome
+ *
+ * \return its fitness
+ *
+ * @throw dcgp::input_error if the index is out of range
+ */
+double archive::fitness(std::size_t i) const
+{
+    if (i >= m_size)
+    {
+        throw input_error("Archive index out of range");
+    }
+    return m_fitness[i];
+}
+
+/// Loads a chromosome into an expression
+/**
+ * The genes are read directly from the mapped memory into the expression
+ *
+ * \param[in] i index of the chromosome
+ * \param[out] ex the expression (must have the archive topology, see dcgp::archive::make_expression)
+ *
+ * @throw dcgp::input_error if the index is out of range or the chromosome is incompatible with ex
+ */
+void archive::load(std::size_t i, expression& ex) const
+{
+    ex.set(chromosome(i), m_chromosome_length);
+}
+
+/// Creates an expression having the archive topology
+/**
+ * \param[in] seed seed for the random number generator of the expression
+ *
+ * \return a random dcgp::expression with the topology and function set of the archive
+ *
+ * @throw dcgp::input_error if a function name is unknown
+ */
+expression archive::make_expression(unsigned int seed) const
+{
+    function_set f(m_function_names);
+    return expression(m_n, m_m, m_r, m_c, m_l, f(), seed);
+}
+
+} // end of namespace dcgp
@@ -0,0 +1,106 @@
+#ifndef DCGP_ARCHIVE_H
+#define DCGP_ARCHIVE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "expression.h"
+#include "rng.h"
+
+namespace dcgp {
+
+/// Writes a chromosome archive
+/**
+ * Streams chromosomes and their fitness to a file having the fixed layout read by dcgp::archive:
+ *
+ * - a header holding the topology (n, m, r, c, l), the number of chromosomes and the offsets of the blocks below,
+ * - the function set names,
+ * - the packed chromosomes (32 bits per gene, starting on a 64 bytes boundary),
+ * - the fitness values (one double per chromosome, starting on a 64 bytes boundary).
+ *
+ * Chromosomes are written as they are pushed, fitness values are kept in memory and
+ * written by dcgp::archive_writer::close (also called by the destructor).
+ *
+ * @author Dario Izzo (dario.izzo@gmail.com)
+ */
+class archive_writer {
+public:
+    archive_writer(const std::string& filename, const expression& prototype);
+    ~archive_writer();
+
+    void push_back(const std::vector<unsigned int>& x, double fitness);
+    void close();
+
+    /// Gets the number of chromosomes written so far
+    std::size_t size() const {return m_fitness.size();};
+
+private:
+    archive_writer(const archive_writer&);
+    archive_writer& operator=(const archive_writer&);
+
+    std::ofstream m_os;
+    std::string m_filename;
+    unsigned int m_chromosome_length;
+    std::uint64_t m_chromosomes_offset;
+    std::vector<double> m_fitness;
+};
+
+/// Read-only memory-mapped chromosome archive
+/**
+ * Maps in memory an archive written by dcgp::archive_writer. Opening an archive only parses its header:
+ * chromosomes and fitness values are then accessed by index directly in the mapped memory (zero-copy),
+ * and the operating system only pages in what is actually touched.
+ *
+ * @author Dario Izzo (dario.izzo@gmail.com)
+ */
+class archive {
+public:
+    archive(const std::string& filename);
+    ~archive();
+
+    /// Gets the number of chromosomes in the archive
+    std::size_t size() const {return m_size;};
+    /// Gets the number of genes in each chromosome
+    unsigned int chromosome_length() const {return m_chromosome_length;};
+    /// Gets the number of inputs
+    unsigned int get_n() const {return m_n;};
+    /// Gets the number of outputs
+    unsigned int get_m() const {return m_m;};
+    /// Gets the number of rows
+    unsigned int get_r() const {return m_r;};
+    /// Gets the number of columns
+    unsigned int get_c() const {return m_c;};
+    /// Gets the number of levels-back
+    unsigned int get_l() const {return m_l;};
+    /// Gets the names of the functions in the function set
+    const std::vector<std::string>& get_function_names() const {return m_function_names;};
+
+    const unsigned int* chromosome(std::size_t i) const;
+    double fitness(std::size_t i) const;
+    void load(std::size_t i, expression& ex) const;
+    expression make_expression(unsigned int seed = rng::get_seed()) const;
+
+private:
+    archive(const archive&);
+    archive& operator=(const archive&);
+
+    void *m_map;
+    std::size_t m_map_size;
+    unsigned int m_n;
+    unsigned int m_m;
+    unsigned int m_r;
+    unsigned int m_c;
+    unsigned int m_l;
+    unsigned int m_chromosome_length;
+    std::size_t m_size;
+    std::vector<std::string> m_function_names;
+    const std::uint32_t *m_chromosomes;
+    const double *m_fitness;
+};
+
+} // end of namespace dcgp
+
+#endif // DCGP_ARCHIVE_H
@@ -4,13 +4,18 @@
 #include <functional>
 #include <string>
 #include <iostream>
+#include <utility>
 #include <vector>
 
+#include "interval.h"
+
 namespace dcgp {
 
 using my_fun_type = std::function<double(double, double)>;
 using d_my_fun_type = std::function<double(const std::vector<double> &, const std::vector<double> &)>;
 using my_print_fun_type = std::function<std::string(std::string, std::string)>;
+using my_interval_fun_type = std::function<interval(const interval &, const interval &, bool)>;
+using d_my_fun_into_type = std::function<double(const std::vector<double> &, const std::vector<double> &, std::vector<double> &)>;
 
 /// Basis function
 /**
@@ -23,13 +28,16 @@ using my_print_fun_type = std::function<std::string(std::string, std::string)>;
  * available as dcgp::my_fun_type, dcgp::my_d_fun_type and dcgp::my_print_fun_type in order
  * to be able to construct this object
  *
+ * Unary functions (arity 1) only depend on their first argument: the node second connection is then
+ * not read, and the nodes behind it are not made active
+ *
  * @author Dario Izzo (dario.izzo@gmail.com)
  */
 struct basis_function
 {
     /// Constructor from std::function construction arguments
     template <typename T, typename U, typename V>
-    basis_function(T &&f, U &&df, V&&pf, std::string name):m_f(std::forward<T>(f)), m_df(std::forward<U>(df)), m_pf(std::forward<V>(pf)), m_name(name) {}
+    basis_function(T &&f, U &&df, V&&pf, std::string name, unsigned int arity = 2u, my_interval_fun_type interval_f = my_interval_fun_type(), d_my_fun_into_type df_into = d_my_fun_into_type()):m_f(std::forward<T>(f)), m_df(std::forward<U>(df)), m_pf(std::forward<V>(pf)), m_if(std::move(interval_f)), m_df_into(std::move(df_into)), m_name(name), m_arity(arity) {}
 
     /// Overload of operator(double, double)
     /**
@@ -41,6 +49,18 @@ struct basis_function
             return m_f(x,y);
     }
 
+    /// Overload of operator(interval, interval)
+    /**
+    * Allows to call a dcgp::basis_function with the syntax f(interval x, interval y) and get an enclosure of
+    * the function values on x, y in return. Passing the same object twice means that both arguments are the
+    * same quantity (as when both connections of a node come from one node). Without an interval version
+    * (m_if) every value is possible.
+    */
+    interval operator()(const interval& x, const interval& y) const
+    {
+            return m_if ? m_if(x, y, &x == &y) : interval::entire();
+    }
+
     /// Overload of operator(std::string, std::string)
     /**
     * Allows to call a dcgp::basis_function with the syntax f(std::string x, std::string y) and get
@@ -57,8 +77,14 @@ struct basis_function
     d_my_fun_type m_df;
     /// Its symbolic representation
     my_print_fun_type m_pf;
+    /// Its interval version (optional)
+    my_interval_fun_type m_if;
+    /// Its derivatives, computed with the scratch memory given (optional, see dcgp::expression::differentiate_into)
+    d_my_fun_into_type m_df_into;
     /// Its name
     std::string m_name;
+    /// The number of arguments it depends on (1 or 2)
+    unsigned int m_arity;
 };
 
 std::ostream& operator<<(std::ostream& os, const basis_function& obj);
@@ -0,0 +1,327 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "checkpoint.h"
+#include "exceptions.h"
+#include "function_set.h"
+
+namespace dcgp {
+
+namespace {
+// File layout: magic, byte order mark and version, then the fields in the order they appear in dcgp::checkpoint
+const char checkpoint_magic[8] = {'D', 'C', 'G', 'P', 'C', 'K', 'P', 'T'};
+const std::uint32_t checkpoint_byte_order = 0x01020304u;
+const std::uint32_t checkpoint_version = 1u;
+
+template <typename T>
+void write_pod(std::ostream& os, const T& value)
+{
+    os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+void read_pod(std::istream& is, T& value)
+{
+    is.read(reinterpret_cast<char*>(&value), sizeof(T));
+    if (!is) throw input_error("Checkpoint is truncated");
+}
+
+void write_string(std::ostream& os, const std::string& s)
+{
+    write_pod(os, static_cast<std::uint32_t>(s.size()));
+    os.write(s.data(), s.size());
+}
+
+// Number of bytes left in a stream, the maximum if it cannot be known (the stream is not seekable)
+std::uint64_t remaining(std::istream& is)
+{
+    const std::istream::pos_type pos = is.tellg();
+    if (pos == std::istream::pos_type(-1)) return std::numeric_limits<std::uint64_t>::max();
+    is.seekg(0, std::ios::end);
+    const std::istream::pos_type end = is.tellg();
+    is.clear();
+    is.seekg(pos);
+    if (end == std::istream::pos_type(-1)) return std::numeric_limits<std::uint64_t>::max();
+    return static_cast<std::uint64_t>(end - pos);
+}
+
+std::string read_string(std::istream& is)
+{
+    std::uint32_t size;
+    read_pod(is, size);
+    if (size > remaining(is)) throw input_error("Checkpoint is truncated");
+    std::string retval(size, '\0');
+    is.read(&retval[0], size);
+    if (!is) throw input_error("Checkpoint is truncated");
+    return retval;
+}
+
+template <typename T>
+void write_block(std::ostream& os, const std::vector<T>& v)
+{
+    write_pod(os, static_cast<std::uint64_t>(v.size()));
+    os.write(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(T));
+}
+
+template <typename T>
+void read_block(std::istream& is, std::vector<T>& v)
+{
+    std::uint64_t size;
+    read_pod(is, size);
+    // the size is checked before allocating, so that a corrupted one cannot exhaust the memory
+    if (size > remaining(is) / sizeof(T)) throw input_error("Checkpoint is truncated");
+    v.resize(static_cast<std::size_t>(size));
+    is.read(reinterpret_cast<char*>(v.data()), static_cast<std::streamsize>(size * sizeof(T)));
+    if (!is) throw input_error("Checkpoint is truncated");
+}
+
+// Flushes a file, or a directory, to the disk. Returns false if it failed (never where flushing is unsupported)
+bool sync_path(const std::string& path)
+{
+#if defined(__unix__) || defined(__APPLE__)
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    const bool retval = ::fsync(fd) == 0;
+    ::close(fd);
+    return retval;
+#else
+    (void)path;
+    return true;
+#endif
+}
+}
+
+/// Gets the i-th chromosome
+/**
+ * \param[in] i index of the individual
+ *
+ * \return a copy of its chromosome
+ */
+std::vector<unsigned int> checkpoint::get_chromosome(std::size_t i) const
+{
+    const unsigned int *begin = m_chromosomes.data() + i * chromosome_length();
+    return std::vector<unsigned int>(begin, begin + chromosome_length());
+}
+
+/// Appends one individual
+/**
+ * \param[in] x chromosome
+ * \param[in] fitness its fitness
+ *
+ * @throw dcgp::input_error if the chromosome length is incompatible with the topology
+ */
+void checkpoint::push_back(const std::vector<unsigned int>& x, double fitness)
+{
+    if (x.size() != chromosome_length())
+    {
+        throw input_error("Chromosome is incompatible");
+    }
+    m_chromosomes.insert(m_chromosomes.end(), x.begin(), x.end());
+    m_fitness.push_back(fitness);
+}
+
+/// Creates an (empty) checkpoint having the topology of an expression
+/**
+ * \param[in] ex the expression
+ *
+ * \return a dcgp::checkpoint with the topology and function names of ex and no individuals
+ */
+checkpoint make_checkpoint(const expression& ex)
+{
+    checkpoint retval;
+    retval.m_n = ex.get_n();
+    retval.m_m = ex.get_m();
+    retval.m_r = ex.get_r();
+    retval.m_c = ex.get_c();
+    retval.m_l = ex.get_l();
+    for (const auto &f : ex.get_f())
+    {
+        retval.m_function_names.push_back(f.m_name);
+    }
+    return retval;
+}
+
+/// Creates an expression having the topology stored in a checkpoint
+/**
+ * \param[in] cp the checkpoint
+ * \param[in] seed seed for the random number generator of the expression
+ *
+ * \return a random dcgp::expression with the topology and function set of cp
+ *
+ * @throw dcgp::input_error if the topology is invalid or a function name is unknown
+ */
+expression make_expression(const checkpoint& cp, unsigned int seed)
+{
+    function_set f(cp.m_function_names);
+    return expression(cp.m_n, cp.m_m, cp.m_r, cp.m_c, cp.m_l, f(), seed);
+}
+
+/// Writes a checkpoint to a binary stream
+/**
+ * \param[in] cp the checkpoint
+ * \param[out] os the output stream (to be opened in binary mode)
+ *
+ * @throw dcgp::input_error if the checkpoint is inconsistent or the stream cannot be written
+ */
+void save_checkpoint(const checkpoint& cp, std::ostream& os)
+{
+    if (cp.m_chromosomes.size() != cp.m_fitness.size() * cp.chromosome_length())
+    {
+        throw input_error("Checkpoint is inconsistent: number of genes does not match the number of individuals");
+    }
+    os.write(checkpoint_magic, sizeof(checkpoint_magic));
+    write_pod(os, checkpoint_byte_order);
+    write_pod(os, checkpoint_version);
+    write_pod(os, static_cast<std::uint32_t>(cp.m_n));
+    write_pod(os, static_cast<std::uint32_t>(cp.m_m));
+    write_pod(os, static_cast<std::uint32_t>(cp.m_r));
+    write_pod(os, static_cast<std::uint32_t>(cp.m_c));
+    write_pod(os, static_cast<std::uint32_t>(cp.m_l));
+    write_pod(os, static_cast<std::uint32_t>(cp.m_function_names.size()));
+    for (const auto &name : cp.m_function_names)
+    {
+        write_string(os, name);
+    }
+    if (sizeof(unsigned int) == sizeof(std::uint32_t))
+    {
+        write_block(os, cp.m_chromosomes);
+    } else {
+        write_block(os, std::vector<std::uint32_t>(cp.m_chromosomes.begin(), cp.m_chromosomes.end()));
+    }
+    write_block(os, cp.m_fitness);
+    write_string(os, cp.m_rng_state);
+    write_pod(os, cp.m_generation);
+    write_pod(os, cp.m_best_fitness);
+    if (!os)
+    {
+        throw input_error("Could not write the checkpoint");
+    }
+}
+
+/// Writes a checkpoint to a file
+/**
+ * The checkpoint is first written to filename + ".tmp", flushed to the disk and then renamed, the directory being
+ * flushed as well, so that a crash while checkpointing leaves either the previous checkpoint or the new one.
+ * The flushes are made on POSIX systems only: elsewhere, a crash of the operating system may still lose
+ * the checkpoint written last.
+ *
+ * \param[in] cp the checkpoint
+ * \param[in] filename the file name
+ *
+ * @throw dcgp::input_error if the file cannot be written
+ */
+void save_checkpoint(const checkpoint& cp, const std::string& filename)
+{
+    const std::string tmp = filename + ".tmp";
+    {
+        std::ofstream os(tmp, std::ios::binary | std::ios::trunc);
+        if (!os)
+        {
+            throw input_error("Could not open " + tmp);
+        }
+        save_checkpoint(cp, os);
+        os.flush();
+        if (!os)
+        {
+            throw input_error("Could not write " + tmp);
+        }
+    }
+    if (!sync_path(tmp))
+    {
+        throw input_error("Could not write " + tmp);
+    }
+    if (std::rename(tmp.c_str(), filename.c_str()) != 0)
+    {
+        throw input_error("Could not rename " + tmp + " to " + filename);
+    }
+    // the rename itself is made durable by flushing the directory (which some file systems cannot do: the
+    // checkpoint is written anyway)
+    const std::string::size_type slash = filename.find_last_of('/');
+    sync_path((slash == std::string::npos) ? "." : (slash == 0u ? "/" : filename.substr(0u, slash)));
+}
+
+/// Reads a checkpoint from a binary stream
+/**
+ * \param[in] is the input stream (to be opened in binary mode)
+ *
+ * \return the dcgp::checkpoint
+ *
+ * @throw dcgp::input_error if the stream does not contain a valid checkpoint of a supported version
+ */
+checkpoint load_checkpoint(std::istream& is)
+{
+    char magic[sizeof(checkpoint_magic)];
+    is.read(magic, sizeof(magic));
+    if (!is || std::memcmp(magic, checkpoint_magic, sizeof(magic)) != 0)
+    {
+        throw input_error("Not a d-CGP checkpoint");
+    }
+    std::uint32_t byte_order, version, value;
+    read_pod(is, byte_order);
+    if (byte_order != checkpoint_byte_order)
+    {
+        throw input_error("Checkpoint was written on a machine with a different byte order");
+    }
+    read_pod(is, version);
+    if (version != checkpoint_version)
+    {
+        throw input_error("Unsupported checkpoint version " + std::to_string(version));
+    }
+
+    checkpoint retval;
+    read_pod(is, value); retval.m_n = value;
+    read_pod(is, value); retval.m_m = value;
+    read_pod(is, value); retval.m_r = value;
+    read_pod(is, value); retval.m_c = value;
+    read_pod(is, value); retval.m_l = value;
+    read_pod(is, value);
+    for (auto i = 0u; i < value; ++i)
+    {
+        retval.m_function_names.push_back(read_string(is));
+    }
+    if (sizeof(unsigned int) == sizeof(std::uint32_t))
+    {
+        read_block(is, retval.m_chromosomes);
+    } else {
+        std::vector<std::uint32_t> genes;
+        read_block(is, genes);
+        retval.m_chromosomes.assign(genes.begin(), genes.end());
+    }
+    read_block(is, retval.m_fitness);
+    retval.m_rng_state = read_string(is);
+    read_pod(is, retval.m_generation);
+    read_pod(is, retval.m_best_fitness);
+
+    if (retval.m_chromosomes.size() != retval.m_fitness.size() * retval.chromosome_length())
+    {
+        throw input_error("Checkpoint is inconsistent: number of genes does not match the number of individuals");
+    }
+    return retval;
+}
+
+/// Reads a checkpoint from a file
+/**
+ * \param[in] filename the file name
+ *
+ * \return the dcgp::checkpoint
+ *
+ * @throw dcgp::input_error if the file cannot be read or does not contain a valid checkpoint
+ */
+checkpoint load_checkpoint(const std::string& filename)
+{
+    std::ifstream is(filename, std::ios::binary);
+    if (!is)
+    {
+        throw input_error("Could not open " + filename);
+    }
+    return load_checkpoint(is);
+}
+
+} // end of namespace dcgp
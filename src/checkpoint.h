@@ -0,0 +1,70 @@
+#ifndef DCGP_CHECKPOINT_H
+#define DCGP_CHECKPOINT_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "expression.h"
+#include "rng.h"
+
+namespace dcgp {
+
+/// Snapshot of an evolution
+/**
+ * Contains everything needed to resume an evolution: the topology of the expressions
+ * (with the function set stored by name, see dcgp::function_set), the population chromosomes
+ * packed one after the other, their fitness, the engine random number generator state and
+ * the engine progress.
+ *
+ * A checkpoint is written and read by dcgp::save_checkpoint and dcgp::load_checkpoint using a compact
+ * versioned binary format made of a small header followed by the packed chromosomes and fitness written
+ * as raw blocks, so that saving even very large populations costs little more than the disk bandwidth.
+ *
+ * @author Dario Izzo (dario.izzo@gmail.com)
+ */
+struct checkpoint
+{
+    checkpoint() : m_n(0u), m_m(0u), m_r(0u), m_c(0u), m_l(0u), m_generation(0u), m_best_fitness(0.) {}
+
+    /// Gets the number of genes in each chromosome
+    unsigned int chromosome_length() const {return 3u * m_r * m_c + m_m;}
+    /// Gets the number of individuals stored
+    std::size_t size() const {return m_fitness.size();}
+    /// Gets the i-th chromosome
+    std::vector<unsigned int> get_chromosome(std::size_t i) const;
+    /// Appends one individual
+    void push_back(const std::vector<unsigned int>& x, double fitness);
+
+    // number of inputs, outputs, rows, columns and levels-back
+    unsigned int m_n;
+    unsigned int m_m;
+    unsigned int m_r;
+    unsigned int m_c;
+    unsigned int m_l;
+    // the names of the functions in the function set
+    std::vector<std::string> m_function_names;
+    // all chromosomes, packed one after the other
+    std::vector<unsigned int> m_chromosomes;
+    // the fitness of each chromosome
+    std::vector<double> m_fitness;
+    // the random engine state (as streamed by its operator<<)
+    std::string m_rng_state;
+    // generations (or evaluations, for engines that have no generations) performed so far
+    std::uint64_t m_generation;
+    // best fitness found so far
+    double m_best_fitness;
+};
+
+checkpoint make_checkpoint(const expression& ex);
+expression make_expression(const checkpoint& cp, unsigned int seed = rng::get_seed());
+
+void save_checkpoint(const checkpoint& cp, std::ostream& os);
+void save_checkpoint(const checkpoint& cp, const std::string& filename);
+checkpoint load_checkpoint(std::istream& is);
+checkpoint load_checkpoint(const std::string& filename);
+
+} // end of namespace dcgp
+
+#endif // DCGP_CHECKPOINT_H
@@ -0,0 +1,194 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#include <dlfcn.h>
+#include <unistd.h>
+
+#include "codegen.h"
+#include "exceptions.h"
+
+namespace dcgp {
+
+namespace {
+// C expression computing a basis function, same math as in wrapped_functions.cpp
+std::string c_function(const std::string& name, const std::string& b, const std::string& c)
+{
+    if (name == "sum") return b + " + " + c;
+    if (name == "diff") return b + " - " + c;
+    if (name == "mul") return b + " * " + c;
+    if (name == "div") return b + " / " + c;
+    if (name == "pow") return "pow(fabs(" + b + "), " + c + ")";
+    if (name == "sqrt") return "sqrt(fabs(" + b + "))";
+    throw input_error("Cannot generate code for the function " + name);
+}
+
+// Body computing the active nodes and the outputs. Input k is read as in(k), output k is written as out(k)
+std::string c_body(const expression& ex, const std::string& indent, const std::string& in_prefix, const std::string& in_suffix, const std::string& out_prefix, const std::string& out_suffix)
+{
+    std::ostringstream os;
+    const std::vector<unsigned int>& x = ex.get();
+    const unsigned int n = ex.get_n();
+    for (auto i : ex.get_active_nodes())
+    {
+        os << indent << "const double v" << i << " = ";
+        if (i < n)
+        {
+            os << in_prefix << i << in_suffix;
+        } else {
+            const unsigned int idx = (i - n) * 3u;
+            const basis_function& f = ex.get_f()[x[idx]];
+            // the second connection of unary functions may not be active
+            os << c_function(f.m_name, "v" + std::to_string(x[idx + 1]), "v" + std::to_string(x[(f.m_arity > 1u) ? idx + 2 : idx + 1]));
+        }
+        os << ";\n";
+    }
+    for (auto k = 0u; k < ex.get_m(); ++k)
+    {
+        os << indent << out_prefix << k << out_suffix << " = v" << x[ex.get_r() * ex.get_c() * 3u + k] << ";\n";
+    }
+    return os.str();
+}
+
+// Removes a file, ignoring errors
+void remove_quietly(const std::string& filename)
+{
+    std::remove(filename.c_str());
+}
+}
+
+/// Generates the C source code of an expression
+/**
+ * The code defines two functions computing the active nodes of the expression in straight-line code:
+ *
+ *     void name(const double *in, double *out);
+ *     void name_batch(unsigned long rows, const double *in, unsigned long in_row_stride, unsigned long in_column_stride,
+ *                     double *out, unsigned long out_row_stride, unsigned long out_column_stride);
+ *
+ * The first computes the m outputs of one point from its n inputs, the second those of several points, the j-th
+ * input of point i being in[i * in_row_stride + j * in_column_stride] (and likewise for the outputs), so that
+ * both row-major and column-major data can be processed in place.
+ *
+ * \param[in] ex the expression
+ * \param[in] name the name of the generated function
+ *
+ * \return the C source code
+ *
+ * @throw dcgp::input_error if the expression contains a function that cannot be translated
+ */
+std::string generate_c_code(const expression& ex, const std::string& name)
+{
+    std::ostringstream os;
+    os << "/* Generated by dcgp: " << ex.get_n() << " inputs, " << ex.get_m() << " outputs, " << ex.get_active_nodes().size() << " active nodes */\n";
+    os << "#include <math.h>\n\n";
+    os << "void " << name << "(const double *in, double *out)\n{\n";
+    os << c_body(ex, "    ", "in[", "]", "out[", "]");
+    os << "}\n\n";
+    os << "void " << name << "_batch(unsigned long rows, const double *in, unsigned long in_row_stride, unsigned long in_column_stride, double *out, unsigned long out_row_stride, unsigned long out_column_stride)\n{\n";
+    os << "    unsigned long i;\n";
+    os << "    for (i = 0; i < rows; ++i)\n    {\n";
+    os << "        const double *x = in + i * in_row_stride;\n";
+    os << "        double *y = out + i * out_row_stride;\n";
+    os << c_body(ex, "        ", "x[in_column_stride * ", "]", "y[out_column_stride * ", "]");
+    os << "    }\n}\n";
+    return os.str();
+}
+
+/// Constructor
+/** Generates, compiles and loads the code of an expression
+ *
+ * The code is compiled in a temporary directory (TMPDIR or /tmp) which is removed once the library is loaded.
+ *
+ * \param[in] ex the expression
+ * \param[in] compiler the C compiler command
+ * \param[in] flags additional compiler flags (e.g. optimization level)
+ *
+ * @throw dcgp::input_error if the expression cannot be translated, or the code cannot be compiled or loaded
+ */
+compiled_expression::compiled_expression(const expression& ex, const std::string& compiler, const std::string& flags) : m_n(ex.get_n()), m_m(ex.get_m()), m_source(generate_c_code(ex)), m_scalar(nullptr), m_batch(nullptr)
+{
+    const char *tmpdir = std::getenv("TMPDIR");
+    std::string pattern = std::string((tmpdir && *tmpdir) ? tmpdir : "/tmp") + "/dcgp_codegen_XXXXXX";
+    std::vector<char> dir(pattern.begin(), pattern.end());
+    dir.push_back('\0');
+    if (::mkdtemp(dir.data()) == nullptr)
+    {
+        throw input_error("Could not create a temporary directory in " + pattern);
+    }
+    const std::string path(dir.data());
+    const std::string source = path + "/model.c", library = path + "/model.so", log = path + "/model.log";
+    {
+        std::ofstream os(source);
+        os << m_source;
+    }
+    const std::string command = compiler + " " + flags + " -fPIC -shared -ffp-contract=off -o '" + library + "' '" + source + "' -lm > '" + log + "' 2>&1";
+    int status = std::system(command.c_str());
+    void *handle = (status == 0) ? ::dlopen(library.c_str(), RTLD_NOW | RTLD_LOCAL) : nullptr;
+    std::string error;
+    if (status != 0)
+    {
+        std::ifstream is(log);
+        error = "Could not compile the expression: " + std::string(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+    } else if (handle == nullptr) {
+        const char *message = ::dlerror();
+        error = "Could not load the compiled expression: " + std::string(message ? message : "");
+    }
+    // the library stays mapped once loaded
+    remove_quietly(source);
+    remove_quietly(library);
+    remove_quietly(log);
+    ::rmdir(path.c_str());
+    if (!error.empty())
+    {
+        throw input_error(error);
+    }
+
+    m_library = std::shared_ptr<void>(handle, [](void *h) {::dlclose(h);});
+    m_scalar = reinterpret_cast<scalar_type>(::dlsym(handle, "dcgp_model"));
+    m_batch = reinterpret_cast<batch_type>(::dlsym(handle, "dcgp_model_batch"));
+    if (m_scalar == nullptr || m_batch == nullptr)
+    {
+        throw input_error("The compiled expression does not define the expected functions");
+    }
+}
+
+/// Computes the outputs (same signature as dcgp::expression::operator())
+/**
+ * \param[in] in the n inputs
+ *
+ * \return the m outputs
+ *
+ * @throw dcgp::input_error if the number of inputs is wrong
+ */
+std::vector<double> compiled_expression::operator()(const std::vector<double>& in) const
+{
+    if (in.size() != m_n)
+    {
+        throw input_error("Input size is incompatible");
+    }
+    std::vector<double> retval(m_m);
+    m_scalar(in.data(), retval.data());
+    return retval;
+}
+
+/// Computes the outputs on all the points of a dataset
+/**
+ * \param[in] data the dataset (its inputs are read in place, in any layout)
+ * \param[out] out the outputs, data.rows() times m values (the m outputs of each point are contiguous)
+ *
+ * @throw dcgp::input_error if the dataset has the wrong number of inputs
+ */
+void compiled_expression::operator()(const dataset& data, double *out) const
+{
+    if (data.get_n() != m_n)
+    {
+        throw input_error("Dataset is incompatible with the expression inputs");
+    }
+    const std::size_t row_stride = (data.layout() == ROW_MAJOR) ? data.ld() : 1u;
+    const std::size_t column_stride = (data.layout() == ROW_MAJOR) ? 1u : data.ld();
+    m_batch(data.rows(), data.data(), row_stride, column_stride, out, m_m, 1u);
+}
+
+} // end of namespace dcgp
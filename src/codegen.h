@@ -0,0 +1,60 @@
+#ifndef DCGP_CODEGEN_H
+#define DCGP_CODEGEN_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dataset.h"
+#include "expression.h"
+
+namespace dcgp {
+
+/// Generates the C source code of an expression
+std::string generate_c_code(const expression& ex, const std::string& name = "dcgp_model");
+
+/// Expression compiled to native code
+/**
+ * Generates the C source code of the active part of a dcgp::expression (see dcgp::generate_c_code), compiles it
+ * as a shared library with the system C compiler and loads it with dlopen. The result is called just like the
+ * expression, without any interpretation overhead, and computes bit-for-bit the same outputs as the expression,
+ * since it performs the same operations (contraction into fused multiply-adds is disabled) with the same math library.
+ *
+ * A compiled expression does not depend on the expression it comes from, nor on the files used to build it.
+ * Copies share the loaded library, which is unloaded when the last of them is destroyed.
+ *
+ * @author Dario Izzo (dario.izzo@gmail.com)
+ */
+class compiled_expression {
+public:
+    compiled_expression(const expression& ex, const std::string& compiler = "cc", const std::string& flags = "-O2");
+
+    std::vector<double> operator()(const std::vector<double>& in) const;
+    /// Computes the m outputs from the n inputs
+    void operator()(const double *in, double *out) const {m_scalar(in, out);};
+    void operator()(const dataset& data, double *out) const;
+
+    /// Gets the number of inputs
+    unsigned int get_n() const {return m_n;};
+    /// Gets the number of outputs
+    unsigned int get_m() const {return m_m;};
+    /// Gets the generated source code
+    const std::string& get_source() const {return m_source;};
+
+private:
+    using scalar_type = void (*)(const double*, double*);
+    using batch_type = void (*)(unsigned long, const double*, unsigned long, unsigned long, double*, unsigned long, unsigned long);
+
+    unsigned int m_n;
+    unsigned int m_m;
+    std::string m_source;
+    // the loaded library
+    std::shared_ptr<void> m_library;
+    scalar_type m_scalar;
+    batch_type m_batch;
+};
+
+} // end of namespace dcgp
+
+#endif // DCGP_CODEGEN_H
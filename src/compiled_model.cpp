@@ -0,0 +1,319 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "compiled_model.h"
+#include "exceptions.h"
+
+namespace dcgp {
+
+namespace {
+// Blob layout: magic, byte order mark, version, n, m, number of operations and outputs, then the operations and the outputs
+const char model_magic[8] = {'D', 'C', 'G', 'P', 'M', 'O', 'D', 'L'};
+const std::uint32_t model_byte_order = 0x01020304u;
+const std::uint32_t model_version = 1u;
+
+struct model_header
+{
+    char m_magic[8];
+    std::uint32_t m_byte_order;
+    std::uint32_t m_version;
+    std::uint32_t m_n;
+    std::uint32_t m_m;
+    std::uint32_t m_n_operations;
+    std::uint32_t m_n_outputs;
+};
+
+// Values (registers times points) evaluated at once by dcgp::compiled_model::predict, on the stack
+const std::size_t model_workspace = 4096u;
+// Points evaluated at once, at least: larger models are evaluated in the workspace of the caller
+const std::size_t model_min_block = 64u;
+}
+
+/// Constructor
+/** Freezes an expression
+ *
+ * \param[in] ex the expression
+ * \param[in] level the optimization of its program (see dcgp::program)
+ *
+ * @throw dcgp::input_error if the expression uses functions other than those of dcgp::function_set
+ */
+compiled_model::compiled_model(const expression& ex, optimization_level level) : m_n(ex.get_n()), m_m(ex.get_m())
+{
+    program p(ex, level);
+    for (const auto &ins : p.get_instructions())
+    {
+        if (ins.m_op == OP_CALL)
+        {
+            throw input_error("Cannot freeze the function " + p.get_functions()[ins.m_function].m_name);
+        }
+        m_code.push_back(op{static_cast<std::uint32_t>(ins.m_op), ins.m_a, ins.m_b, 0u, ins.m_value});
+    }
+    m_outputs.assign(p.get_outputs().begin(), p.get_outputs().end());
+    check();
+    allocate();
+}
+
+/// Constructor from a blob
+/** Rebuilds a model from the blob returned by dcgp::compiled_model::serialize
+ *
+ * \param[in] blob the blob
+ * \param[in] size its size in bytes
+ *
+ * @throw dcgp::input_error if the blob is not a valid model
+ */
+compiled_model::compiled_model(const void *blob, std::size_t size)
+{
+    const char *p = static_cast<const char*>(blob);
+    model_header h;
+    if (size < sizeof(h))
+    {
+        throw input_error("Blob is not a d-CGP model");
+    }
+    std::memcpy(&h, p, sizeof(h));
+    if (std::memcmp(h.m_magic, model_magic, sizeof(model_magic)) != 0)
+    {
+        throw input_error("Blob is not a d-CGP model");
+    }
+    if (h.m_byte_order != model_byte_order)
+    {
+        throw input_error("Model was serialized on a machine with a different byte order");
+    }
+    if (h.m_version != model_version)
+    {
+        throw input_error("Unsupported model version " + std::to_string(h.m_version));
+    }
+    if (sizeof(h) + std::uint64_t(h.m_n_operations) * sizeof(op) + std::uint64_t(h.m_n_outputs) * sizeof(std::uint32_t) != size)
+    {
+        throw input_error("Model blob is truncated or corrupted");
+    }
+    m_n = h.m_n;
+    m_m = h.m_m;
+    m_code.resize(h.m_n_operations);
+    m_outputs.resize(h.m_n_outputs);
+    std::memcpy(m_code.data(), p + sizeof(h), m_code.size() * sizeof(op));
+    std::memcpy(m_outputs.data(), p + sizeof(h) + m_code.size() * sizeof(op), m_outputs.size() * sizeof(std::uint32_t));
+    check();
+    allocate();
+}
+
+/// Checks that the program only reads registers already written
+void compiled_model::check() const
+{
+    if (m_outputs.size() != m_m || m_n == 0u)
+    {
+        throw input_error("Model is corrupted");
+    }
+    const std::size_t n_registers = m_n + m_code.size();
+    for (auto k = 0u; k < m_code.size(); ++k)
+    {
+        if (m_code[k].m_op > OP_ABS || m_code[k].m_a >= m_n + k || m_code[k].m_b >= m_n + k)
+        {
+            throw input_error("Model is corrupted");
+        }
+    }
+    for (auto r : m_outputs)
+    {
+        if (r >= n_registers)
+        {
+            throw input_error("Model is corrupted");
+        }
+    }
+}
+
+// Allocates the registers of the program: the register of a value is reused after its last use (outputs are used
+// until the end), so that the registers needed are the values live at once rather than all the values
+void compiled_model::allocate()
+{
+    const std::size_t n_values = m_n + m_code.size();
+    const std::size_t end = m_code.size();
+    // last operation reading each value, end for the outputs and n_values for the values never read
+    std::vector<std::size_t> last_use(n_values, n_values);
+    for (auto k = 0u; k < m_code.size(); ++k)
+    {
+        if (m_code[k].m_op != OP_CONST)
+        {
+            last_use[m_code[k].m_a] = k;
+            last_use[m_code[k].m_b] = k;
+        }
+    }
+    for (auto r : m_outputs)
+    {
+        last_use[r] = end;
+    }
+    // the inputs are loaded in the first registers
+    std::vector<std::uint32_t> reg(n_values);
+    std::vector<std::uint32_t> released;
+    for (auto j = 0u; j < m_n; ++j)
+    {
+        reg[j] = j;
+        if (last_use[j] == n_values)
+        {
+            released.push_back(j);
+        }
+    }
+    m_n_registers = m_n;
+    m_program.resize(m_code.size());
+    for (auto k = 0u; k < m_code.size(); ++k)
+    {
+        op ins = m_code[k];
+        ins.m_a = reg[m_code[k].m_a];
+        ins.m_b = reg[m_code[k].m_b];
+        // the operands read for the last time are released first: operations are computed point by point,
+        // so the result can overwrite one of them
+        if (ins.m_op != OP_CONST)
+        {
+            if (last_use[m_code[k].m_a] == k)
+            {
+                released.push_back(ins.m_a);
+            }
+            if (last_use[m_code[k].m_b] == k && ins.m_b != ins.m_a)
+            {
+                released.push_back(ins.m_b);
+            }
+        }
+        if (released.empty())
+        {
+            ins.m_reserved = static_cast<std::uint32_t>(m_n_registers++);
+        }
+        else
+        {
+            ins.m_reserved = released.back();
+            released.pop_back();
+        }
+        reg[m_n + k] = ins.m_reserved;
+        if (last_use[m_n + k] == n_values)
+        {
+            released.push_back(ins.m_reserved);
+        }
+        m_program[k] = ins;
+    }
+    m_output_registers.resize(m_outputs.size());
+    for (auto j = 0u; j < m_outputs.size(); ++j)
+    {
+        m_output_registers[j] = reg[m_outputs[j]];
+    }
+}
+
+/// Computes the outputs of several points
+/**
+ * The points are processed in blocks, each operation being applied to all the points of a block in a tight loop,
+ * in a workspace on the stack. The model is not modified, so that several threads can predict at the same time.
+ * Models too large for the workspace on the stack (see dcgp::compiled_model::get_workspace_size) must use the
+ * overload taking a workspace.
+ *
+ * \param[in] in the inputs, rows times n values (the n inputs of each point are contiguous)
+ * \param[out] out the outputs, rows times m values (the m outputs of each point are contiguous)
+ * \param[in] rows number of points
+ *
+ * @throw dcgp::input_error if the model has more than 64 registers
+ */
+void compiled_model::predict(const double *in, double *out, std::size_t rows) const
+{
+    if (m_n_registers * model_min_block > model_workspace)
+    {
+        throw input_error("Model has " + std::to_string(m_n_registers) + " registers, predict it in a workspace");
+    }
+    double workspace[model_workspace];
+    run(in, out, rows, workspace, model_workspace / m_n_registers);
+}
+
+/// Computes the outputs of several points, in a workspace given by the caller
+/**
+ * As dcgp::compiled_model::predict, but the workspace is resized to dcgp::compiled_model::get_workspace_size values
+ * if smaller, so that reusing it across calls no memory is allocated whatever the size of the model. Each thread
+ * predicting at the same time needs its own workspace.
+ *
+ * \param[in] in the inputs, rows times n values (the n inputs of each point are contiguous)
+ * \param[out] out the outputs, rows times m values (the m outputs of each point are contiguous)
+ * \param[in] rows number of points
+ * \param[in, out] workspace the workspace
+ */
+void compiled_model::predict(const double *in, double *out, std::size_t rows, std::vector<double>& workspace) const
+{
+    const std::size_t size = get_workspace_size();
+    if (workspace.size() < size)
+    {
+        workspace.resize(size);
+    }
+    run(in, out, rows, workspace.data(), size / m_n_registers);
+}
+
+/// Gets the number of values of the workspace needed by predict
+/**
+ * Models of up to 64 registers (see dcgp::compiled_model::get_registers) fit the workspace predict keeps on the
+ * stack; larger ones need one given by the caller, holding 64 points.
+ *
+ * \return the size of the workspace
+ */
+std::size_t compiled_model::get_workspace_size() const
+{
+    return std::max(model_workspace / m_n_registers, model_min_block) * m_n_registers;
+}
+
+// Computes the outputs of the points, block points at a time, in a workspace of block times the registers values
+void compiled_model::run(const double *in, double *out, std::size_t rows, double *workspace, std::size_t block) const
+{
+    for (std::size_t begin = 0u; begin < rows; begin += block)
+    {
+        const std::size_t count = std::min(block, rows - begin);
+        for (auto j = 0u; j < m_n; ++j)
+        {
+            double *dst = workspace + j * block;
+            for (auto i = 0u; i < count; ++i)
+            {
+                dst[i] = in[(begin + i) * m_n + j];
+            }
+        }
+        for (const auto &ins : m_program)
+        {
+            double *dst = workspace + ins.m_reserved * block;
+            const double *a = workspace + ins.m_a * block, *b = workspace + ins.m_b * block;
+            switch (ins.m_op)
+            {
+                case OP_CONST: for (auto i = 0u; i < count; ++i) dst[i] = ins.m_value; break;
+                case OP_SUM: for (auto i = 0u; i < count; ++i) dst[i] = a[i] + b[i]; break;
+                case OP_DIFF: for (auto i = 0u; i < count; ++i) dst[i] = a[i] - b[i]; break;
+                case OP_MUL: for (auto i = 0u; i < count; ++i) dst[i] = a[i] * b[i]; break;
+                case OP_DIV: for (auto i = 0u; i < count; ++i) dst[i] = a[i] / b[i]; break;
+                case OP_POW_ABS: for (auto i = 0u; i < count; ++i) dst[i] = std::pow(std::fabs(a[i]), b[i]); break;
+                case OP_POW: for (auto i = 0u; i < count; ++i) dst[i] = std::pow(a[i], b[i]); break;
+                case OP_SQRT_ABS: for (auto i = 0u; i < count; ++i) dst[i] = std::sqrt(std::fabs(a[i])); break;
+                case OP_SQRT: for (auto i = 0u; i < count; ++i) dst[i] = std::sqrt(a[i]); break;
+                case OP_ABS: for (auto i = 0u; i < count; ++i) dst[i] = std::fabs(a[i]); break;
+            }
+        }
+        for (auto j = 0u; j < m_m; ++j)
+        {
+            const double *src = workspace + m_output_registers[j] * block;
+            for (auto i = 0u; i < count; ++i)
+            {
+                out[(begin + i) * m_m + j] = src[i];
+            }
+        }
+    }
+}
+
+/// Serializes the model
+/**
+ * \return a blob from which dcgp::compiled_model can be rebuilt
+ */
+std::vector<char> compiled_model::serialize() const
+{
+    model_header h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.m_magic, model_magic, sizeof(model_magic));
+    h.m_byte_order = model_byte_order;
+    h.m_version = model_version;
+    h.m_n = m_n;
+    h.m_m = m_m;
+    h.m_n_operations = static_cast<std::uint32_t>(m_code.size());
+    h.m_n_outputs = static_cast<std::uint32_t>(m_outputs.size());
+    std::vector<char> retval(sizeof(h) + m_code.size() * sizeof(op) + m_outputs.size() * sizeof(std::uint32_t));
+    std::memcpy(retval.data(), &h, sizeof(h));
+    std::memcpy(retval.data() + sizeof(h), m_code.data(), m_code.size() * sizeof(op));
+    std::memcpy(retval.data() + sizeof(h) + m_code.size() * sizeof(op), m_outputs.data(), m_outputs.size() * sizeof(std::uint32_t));
+    return retval;
+}
+
+} // end of namespace dcgp
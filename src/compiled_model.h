@@ -0,0 +1,71 @@
+#ifndef DCGP_COMPILED_MODEL_H
+#define DCGP_COMPILED_MODEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "expression.h"
+#include "program.h"
+
+namespace dcgp {
+
+/// Frozen inference model
+/**
+ * Holds only what is needed to compute the outputs of a dcgp::expression: its optimized program (see dcgp::program).
+ * There are no bounds, random engine, std::function objects or mutation state, and predictions can be made concurrently
+ * by several threads. When freezing, registers are reused as soon as their value is no longer needed, so that a model
+ * needs as many registers as values live at once (see dcgp::compiled_model::get_registers). Predictions allocate no
+ * memory: models of up to 64 registers use a workspace on the stack, larger ones the workspace given by the caller.
+ *
+ * A model can be serialized to a small binary blob and rebuilt from it, without the function set
+ * or any other part of the expression.
+ *
+ * @author Dario Izzo (dario.izzo@gmail.com)
+ */
+class compiled_model {
+public:
+    explicit compiled_model(const expression& ex, optimization_level level = EXACT_OPTIMIZATION);
+    compiled_model(const void *blob, std::size_t size);
+
+    void predict(const double *in, double *out, std::size_t rows) const;
+    void predict(const double *in, double *out, std::size_t rows, std::vector<double>& workspace) const;
+    std::size_t get_workspace_size() const;
+    std::vector<char> serialize() const;
+
+    /// Gets the number of inputs
+    unsigned int get_n() const {return m_n;};
+    /// Gets the number of outputs
+    unsigned int get_m() const {return m_m;};
+    /// Gets the number of operations performed per point
+    std::size_t get_operations() const {return m_code.size();};
+    /// Gets the number of registers (values live at once, inputs included) used per point
+    std::size_t get_registers() const {return m_n_registers;};
+
+private:
+    void check() const;
+    void allocate();
+    void run(const double *in, double *out, std::size_t rows, double *workspace, std::size_t block) const;
+
+    struct op
+    {
+        std::uint32_t m_op;
+        std::uint32_t m_a;
+        std::uint32_t m_b;
+        std::uint32_t m_reserved;
+        double m_value;
+    };
+
+    unsigned int m_n;
+    unsigned int m_m;
+    std::vector<op> m_code;
+    std::vector<std::uint32_t> m_outputs;
+    // m_code with its registers allocated (m_reserved being the destination) and the registers of the outputs
+    std::vector<op> m_program;
+    std::vector<std::uint32_t> m_output_registers;
+    std::size_t m_n_registers;
+};
+
+} // end of namespace dcgp
+
+#endif // DCGP_COMPILED_MODEL_H
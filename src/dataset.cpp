@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#include "dataset.h"
+#include "exceptions.h"
+
+namespace dcgp {
+
+namespace {
+// Alignment (in bytes) of the storage and, in column-major layout, of each column
+const std::size_t dataset_alignment = 64u;
+const std::size_t doubles_per_alignment = dataset_alignment / sizeof(double);
+
+std::shared_ptr<double> aligned_storage(std::size_t size)
+{
+    void *ptr = nullptr;
+    if (posix_memalign(&ptr, dataset_alignment, (size > 0u ? size : 1u) * sizeof(double)) != 0)
+    {
+        throw std::bad_alloc();
+    }
+    return std::shared_ptr<double>(static_cast<double*>(ptr), std::free);
+}
+}
+
+/// Default constructor (an empty dataset)
+dataset::dataset() : m_storage(), m_data(nullptr), m_rows(0u), m_n(0u), m_m(0u), m_layout(COLUMN_MAJOR), m_ld(0u), m_writable(true) {}
+
+/// Constructor
+/** Allocates (with one single aligned allocation) a dataset of zeros
+ *
+ * \param[in] rows number of points
+ * \param[in] n number of inputs
+ * \param[in] m number of outputs
+ * \param[in] layout the memory layout
+ */
+dataset::dataset(std::size_t rows, unsigned int n, unsigned int m, dataset_layout layout) : m_rows(rows), m_n(n), m_m(m), m_layout(layout), m_writable(true)
+{
+    if (layout == COLUMN_MAJOR)
+    {
+        m_ld = (rows + doubles_per_alignment - 1u) / doubles_per_alignment * doubles_per_alignment;
+    } else {
+        m_ld = n + m;
+    }
+    std::size_t size = (layout == COLUMN_MAJOR) ? m_ld * (n + m) : m_ld * rows;
+    m_storage = aligned_storage(size);
+    m_data = m_storage.get();
+    std::fill(m_data, m_data + size, 0.);
+}
+
+/// Constructor from nested vectors
+/** Copies points stored as std::vector<std::vector<double> > (as used by dcgp::simple_data_fit) into a dataset
+ *
+ * \param[in] in the input points
+ * \param[in] out the output points
+ * \param[in] layout the memory layout
+ *
+ * @throw dcgp::input_error if in and out do not have the same number of points or if the points do not all have the same size
+ */
+dataset::dataset(const std::vector<std::vector<double> >& in, const std::vector<std::vector<double> >& out, dataset_layout layout) : dataset(in.size(), in.empty() ? 0u : static_cast<unsigned int>(in[0].size()), out.empty() ? 0u : static_cast<unsigned int>(out[0].size()), layout)
+{
+    if (in.size() != out.size())
+    {
+        throw input_error("Size of the input vector must be the size of the output vector");
+    }
+    for (auto i = 0u; i < m_rows; ++i)
+    {
+        if (in[i].size() != m_n || out[i].size() != m_m)
+        {
+            throw input_error("All points must have the same number of inputs and outputs");
+        }
+        for (auto j = 0u; j < m_n; ++j)
+        {
+            m_data[offset(i, j)] = in[i][j];
+        }
+        for (auto j = 0u; j < m_m; ++j)
+        {
+            m_data[offset(i, m_n + j)] = out[i][j];
+        }
+    }
+}
+
+/// Constructor from existing storage
+/** Views storage allocated elsewhere (e.g. a memory-mapped file), which is kept alive by the shared pointer
+ *
+ * \param[in] storage the storage, pointing to the first value
+ * \param[in] rows number of points
+ * \param[in] n number of inputs
+ * \param[in] m number of outputs
+ * \param[in] layout the memory layout
+ * \param[in] ld the leading dimension
+ * \param[in] writable whether the storage can be modified
+ *
+ * @throw dcgp::input_error if the leading dimension is too small for the layout
+ */
+dataset::dataset(std::shared_ptr<double> storage, std::size_t rows, unsigned int n, unsigned int m, dataset_layout layout, std::size_t ld, bool writable) : m_storage(storage), m_data(storage.get()), m_rows(rows), m_n(n), m_m(m), m_layout(layout), m_ld(ld), m_writable(writable)
+{
+    if ((layout == COLUMN_MAJOR && ld < rows) || (layout == ROW_MAJOR && ld < n + m))
+    {
+        throw input_error("Leading dimension is too small");
+    }
+}
+
+/// Gets a slice of consecutive points
+/**
+ * The slice shares the storage with this dataset: no data are copied.
+ *
+ * \param[in] begin index of the first point
+ * \param[in] count number of points
+ *
+ * \return a dcgp::dataset viewing the points [begin, begin + count)
+ *
+ * @throw dcgp::input_error if the slice exceeds the dataset
+ */
+dataset dataset::slice(std::size_t begin, std::size_t count) const
+{
+    if (begin > m_rows || count > m_rows - begin)
+    {
+        throw input_error("Slice exceeds the dataset");
+    }
+    dataset retval(*this);
+    retval.m_data = m_data + ((m_layout == COLUMN_MAJOR) ? begin : begin * m_ld);
+    retval.m_rows = count;
+    return retval;
+}
+
+/// Sets the j-th input of the i-th point
+/**
+ * \param[in] i the point
+ * \param[in] j the input
+ * \param[in] value the value
+ *
+ * @throw dcgp::input_error if the dataset is read-only
+ */
+void dataset::set_in(std::size_t i, unsigned int j, double value)
+{
+    if (!m_writable)
+    {
+        throw input_error("Dataset is read-only");
+    }
+    m_data[offset(i, j)] = value;
+}
+
+/// Sets the j-th output of the i-th point
+/**
+ * \param[in] i the point
+ * \param[in] j the output
+ * \param[in] value the value
+ *
+ * @throw dcgp::input_error if the dataset is read-only
+ */
+void dataset::set_out(std::size_t i, unsigned int j, double value)
+{
+    if (!m_writable)
+    {
+        throw input_error("Dataset is read-only");
+    }
+    m_data[offset(i, m_n + j)] = value;
+}
+
+/// Gets a pointer to the first value, to modify the data
+/**
+ * @throw dcgp::input_error if the dataset is not writable
+ */
+double* dataset::writable_data()
+{
+    if (!m_writable)
+    {
+        throw input_error("Dataset is read-only");
+    }
+    return m_data;
+}
+
+} // end of namespace dcgp
@@ -0,0 +1,111 @@
+#ifndef DCGP_DATASET_H
+#define DCGP_DATASET_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace dcgp {
+
+enum dataset_layout {
+    ROW_MAJOR,      // the inputs and outputs of one point are contiguous
+    COLUMN_MAJOR    // the values of one input (or output) across all points are contiguous
+    };
+
+/// Strided view over the values of a dataset row or column
+/**
+ * A lightweight (pointer, size, stride) triplet. It does not own the data and is only valid
+ * as long as the dataset it comes from.
+ */
+struct strided_view
+{
+    strided_view(const double *data, std::size_t size, std::size_t stride) : m_data(data), m_size(size), m_stride(stride) {}
+    /// Gets the i-th element
+    double operator[](std::size_t i) const {return m_data[i * m_stride];}
+    /// Gets the number of elements
+    std::size_t size() const {return m_size;}
+    /// Gets the distance (in doubles) between two consecutive elements
+    std::size_t stride() const {return m_stride;}
+    /// Gets a pointer to the first element
+    const double *data() const {return m_data;}
+
+    const double *m_data;
+    std::size_t m_size;
+    std::size_t m_stride;
+};
+
+/// Dataset
+/**
+ * Holds the input/output points to be fitted by a dcgp::expression in one single allocation aligned to 64 bytes,
+ * either row-major (each point is contiguous) or column-major (each input and output is contiguous).
+ * In column-major layout every column is padded so that it also starts on a 64 bytes boundary.
+ *
+ * The columns of a dataset are numbered with the n inputs first and then the m outputs.
+ *
+ * Copies (and slices, see dcgp::dataset::slice) of a dataset share the same storage, which is released when
+ * the last of them is destroyed. A dataset may also view storage it does not own, such as a read-only
+ * memory-mapped file.
+ *
+ * @author Dario Izzo (dario.izzo@gmail.com)
+ */
+class dataset {
+public:
+    dataset();
+    dataset(std::size_t rows, unsigned int n, unsigned int m, dataset_layout layout = COLUMN_MAJOR);
+    dataset(const std::vector<std::vector<double> >& in, const std::vector<std::vector<double> >& out, dataset_layout layout = COLUMN_MAJOR);
+    dataset(std::shared_ptr<double> storage, std::size_t rows, unsigned int n, unsigned int m, dataset_layout layout, std::size_t ld, bool writable);
+
+    /// Gets the number of points (rows)
+    std::size_t rows() const {return m_rows;};
+    /// Gets the number of inputs
+    unsigned int get_n() const {return m_n;};
+    /// Gets the number of outputs
+    unsigned int get_m() const {return m_m;};
+    /// Gets the layout
+    dataset_layout layout() const {return m_layout;};
+    /// Gets the leading dimension (distance in doubles between two rows if ROW_MAJOR, two columns if COLUMN_MAJOR)
+    std::size_t ld() const {return m_ld;};
+    /// Checks whether the data can be modified
+    bool writable() const {return m_writable;};
+
+    /// Gets the j-th input of the i-th point
+    double in(std::size_t i, unsigned int j) const {return m_data[offset(i, j)];};
+    /// Gets the j-th output of the i-th point
+    double out(std::size_t i, unsigned int j) const {return m_data[offset(i, m_n + j)];};
+    /// Sets the j-th input of the i-th point (throws if the dataset is read-only)
+    void set_in(std::size_t i, unsigned int j, double value);
+    /// Sets the j-th output of the i-th point (throws if the dataset is read-only)
+    void set_out(std::size_t i, unsigned int j, double value);
+
+    /// Gets a view over the j-th column (inputs first, then outputs)
+    strided_view column(unsigned int j) const {return (m_layout == COLUMN_MAJOR) ? strided_view(m_data + j * m_ld, m_rows, 1u) : strided_view(m_data + j, m_rows, m_ld);};
+    /// Gets a view over the i-th row (inputs first, then outputs)
+    strided_view row(std::size_t i) const {return (m_layout == ROW_MAJOR) ? strided_view(m_data + i * m_ld, m_n + m_m, 1u) : strided_view(m_data + i, m_n + m_m, m_ld);};
+
+    dataset slice(std::size_t begin, std::size_t count) const;
+
+    /// Gets a pointer to the first value
+    const double *data() const {return m_data;};
+    double *writable_data();
+
+private:
+    std::size_t offset(std::size_t i, unsigned int j) const
+    {
+        return (m_layout == COLUMN_MAJOR) ? j * m_ld + i : i * m_ld + j;
+    }
+
+    // keeps the storage alive (possibly shared with other datasets)
+    std::shared_ptr<double> m_storage;
+    // first value of this dataset (differs from m_storage.get() for slices)
+    double *m_data;
+    std::size_t m_rows;
+    unsigned int m_n;
+    unsigned int m_m;
+    dataset_layout m_layout;
+    std::size_t m_ld;
+    bool m_writable;
+};
+
+} // end of namespace dcgp
+
+#endif // DCGP_DATASET_H
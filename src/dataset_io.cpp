@@ -0,0 +1,670 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "dataset_io.h"
+#include "exceptions.h"
+
+namespace dcgp {
+
+namespace {
+const char dataset_magic[8] = {'D', 'C', 'G', 'P', 'D', 'A', 'T', 'A'};
+const std::uint32_t dataset_byte_order = 0x01020304u;
+const std::uint32_t dataset_version = 1u;
+// Type of the stored values. Only IEEE 754 double precision is currently supported
+const std::uint32_t dtype_float64 = 1u;
+// Every column starts on a cache line boundary
+const std::uint64_t column_alignment = 64u;
+
+// The fixed-size header found at the beginning of every binary dataset. It is followed by
+// the (n + m) 64 bits offsets of the columns, inputs first, and then by the columns.
+struct dataset_header
+{
+    char m_magic[8];
+    std::uint32_t m_byte_order;
+    std::uint32_t m_version;
+    std::uint32_t m_dtype;
+    std::uint32_t m_n;
+    std::uint32_t m_m;
+    std::uint32_t m_reserved;
+    std::uint64_t m_rows;
+};
+
+std::uint64_t align(std::uint64_t offset)
+{
+    return (offset + column_alignment - 1u) / column_alignment * column_alignment;
+}
+
+// Validates the header of a binary dataset file of the given size
+void check_header(const dataset_header& h, std::size_t size, const std::string& filename)
+{
+    if (std::memcmp(h.m_magic, dataset_magic, sizeof(dataset_magic)) != 0)
+    {
+        throw input_error(filename + " is not a d-CGP binary dataset");
+    }
+    if (h.m_byte_order != dataset_byte_order)
+    {
+        throw input_error(filename + " was written on a machine with a different byte order");
+    }
+    if (h.m_version != dataset_version)
+    {
+        throw input_error("Unsupported binary dataset version " + std::to_string(h.m_version));
+    }
+    if (h.m_dtype != dtype_float64)
+    {
+        throw input_error("Unsupported binary dataset value type " + std::to_string(h.m_dtype));
+    }
+    // the sizes are bounded by divisions, so that a corrupted header cannot make the products wrap around
+    const std::uint64_t n_columns = std::uint64_t(h.m_n) + h.m_m;
+    if (n_columns > std::numeric_limits<std::uint32_t>::max() || n_columns > (size - sizeof(h)) / sizeof(std::uint64_t))
+    {
+        throw input_error(filename + " is truncated");
+    }
+    if (h.m_rows > size / sizeof(double))
+    {
+        throw input_error(filename + " is truncated or corrupted");
+    }
+}
+
+// Validates the column offsets of a binary dataset file of the given size (whose header was validated)
+void check_offsets(const dataset_header& h, const std::vector<std::uint64_t>& offsets, std::size_t size, const std::string& filename)
+{
+    for (auto offset : offsets)
+    {
+        if (offset % column_alignment != 0u || offset > size || h.m_rows > (size - offset) / sizeof(double))
+        {
+            throw input_error(filename + " is truncated or corrupted");
+        }
+    }
+}
+
+// Reads exactly size bytes at the given offset of a file
+void read_fully(int fd, void *dst, std::size_t size, std::uint64_t offset, const std::string& filename)
+{
+    char *p = static_cast<char*>(dst);
+    while (size > 0u)
+    {
+        ssize_t r = ::pread(fd, p, size, static_cast<off_t>(offset));
+        if (r <= 0)
+        {
+            if (r < 0 && errno == EINTR) continue;
+            throw input_error("Could not read " + filename);
+        }
+        p += r;
+        size -= static_cast<std::size_t>(r);
+        offset += static_cast<std::uint64_t>(r);
+    }
+}
+
+// Exact powers of ten representable as doubles
+const double exact_powers_of_ten[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+bool is_blank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Parses a floating point number in [begin, end). On success returns true and sets value and the position after the number.
+// Numbers with at most 15 significant digits and a small decimal exponent are computed exactly with one multiplication
+// or division of two exactly representable doubles (Clinger's fast path, correctly rounded), all others (and nan, inf, ...)
+// are handed over to std::strtod.
+bool parse_double(const char *begin, const char *end, double &value, const char *&next)
+{
+    const char *p = begin;
+    bool negative = false;
+    if (p != end && (*p == '-' || *p == '+'))
+    {
+        negative = (*p == '-');
+        ++p;
+    }
+    std::uint64_t mantissa = 0u;
+    int digits = 0, exponent = 0;
+    bool any_digit = false;
+    while (p != end && *p >= '0' && *p <= '9')
+    {
+        any_digit = true;
+        if (mantissa != 0u || *p != '0') ++digits;
+        if (digits <= 19) mantissa = mantissa * 10u + static_cast<std::uint64_t>(*p - '0');
+        else ++exponent;
+        ++p;
+    }
+    if (p != end && *p == '.')
+    {
+        ++p;
+        while (p != end && *p >= '0' && *p <= '9')
+        {
+            any_digit = true;
+            if (mantissa != 0u || *p != '0') ++digits;
+            if (digits <= 19)
+            {
+                mantissa = mantissa * 10u + static_cast<std::uint64_t>(*p - '0');
+                --exponent;
+            }
+            ++p;
+        }
+    }
+    if (any_digit && p != end && (*p == 'e' || *p == 'E'))
+    {
+        const char *q = p + 1;
+        bool negative_exponent = false;
+        if (q != end && (*q == '-' || *q == '+'))
+        {
+            negative_exponent = (*q == '-');
+            ++q;
+        }
+        if (q != end && *q >= '0' && *q <= '9')
+        {
+            int e = 0;
+            while (q != end && *q >= '0' && *q <= '9')
+            {
+                if (e < 100000) e = e * 10 + (*q - '0');
+                ++q;
+            }
+            exponent += negative_exponent ? -e : e;
+            p = q;
+        }
+    }
+    if (any_digit && digits <= 15 && exponent >= -22 && exponent <= 22)
+    {
+        double m = static_cast<double>(mantissa);
+        value = (exponent < 0) ? m / exact_powers_of_ten[-exponent] : m * exact_powers_of_ten[exponent];
+        if (negative) value = -value;
+        next = p;
+        return true;
+    }
+
+    // slow path, on a null terminated copy of the token
+    const char *token_end = begin;
+    while (token_end != end && !is_blank(*token_end) && *token_end != '\n' && *token_end != ',' && *token_end != ';')
+    {
+        ++token_end;
+    }
+    std::string token(begin, token_end);
+    char *parsed_end = nullptr;
+    value = std::strtod(token.c_str(), &parsed_end);
+    if (parsed_end == token.c_str())
+    {
+        return false;
+    }
+    next = begin + (parsed_end - token.c_str());
+    return true;
+}
+
+// Finds the first position after the newline following pos (or end)
+const char *next_line(const char *pos, const char *end)
+{
+    const void *nl = std::memchr(pos, '\n', static_cast<std::size_t>(end - pos));
+    return nl ? static_cast<const char*>(nl) + 1 : end;
+}
+
+// Checks whether a line contains only blanks
+bool is_empty_line(const char *begin, const char *end)
+{
+    for (; begin != end; ++begin)
+    {
+        if (!is_blank(*begin) && *begin != '\n') return false;
+    }
+    return true;
+}
+
+// Counts the non-empty lines in [begin, end)
+void count_points(const char *begin, const char *end, std::size_t &count)
+{
+    count = 0u;
+    for (const char *line = begin; line < end;)
+    {
+        const char *line_end = next_line(line, end);
+        if (!is_empty_line(line, line_end)) ++count;
+        line = line_end;
+    }
+}
+
+// Maps a whole file read-only and shared. The mapping is released when the returned pointer (and its copies) die.
+// An empty file results in a null pointer and size 0.
+std::shared_ptr<void> map_file(const std::string& filename, access_pattern pattern, std::size_t& size)
+{
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw input_error("Could not open " + filename);
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        throw input_error("Could not stat " + filename);
+    }
+    size = static_cast<std::size_t>(st.st_size);
+    if (size == 0u)
+    {
+        ::close(fd);
+        return std::shared_ptr<void>();
+    }
+    void *map = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED)
+    {
+        throw input_error("Could not map " + filename);
+    }
+    ::madvise(map, size, (pattern == SEQUENTIAL) ? MADV_SEQUENTIAL : MADV_RANDOM);
+    const std::size_t map_size = size;
+    return std::shared_ptr<void>(map, [map_size](void *ptr) {::munmap(ptr, map_size);});
+}
+}
+
+/// Writes a dataset in the d-CGP binary columnar format
+/**
+ * The file contains a header (number of points, inputs, outputs and the type of the values) followed by the
+ * offsets of each column and the columns themselves, each one starting on a 64 bytes boundary, so that
+ * it can later be memory-mapped by dcgp::load_binary_dataset.
+ *
+ * \param[in] data the dataset (in any layout)
+ * \param[in] filename the file name
+ *
+ * @throw dcgp::input_error if the file cannot be written
+ */
+void save_binary_dataset(const dataset& data, const std::string& filename)
+{
+    std::ofstream os(filename, std::ios::binary | std::ios::trunc);
+    if (!os)
+    {
+        throw input_error("Could not open " + filename);
+    }
+    const unsigned int n_columns = data.get_n() + data.get_m();
+    dataset_header h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.m_magic, dataset_magic, sizeof(dataset_magic));
+    h.m_byte_order = dataset_byte_order;
+    h.m_version = dataset_version;
+    h.m_dtype = dtype_float64;
+    h.m_n = data.get_n();
+    h.m_m = data.get_m();
+    h.m_rows = data.rows();
+
+    const std::uint64_t column_size = align(data.rows() * sizeof(double));
+    std::vector<std::uint64_t> offsets(n_columns);
+    std::uint64_t first = align(sizeof(h) + n_columns * sizeof(std::uint64_t));
+    for (auto j = 0u; j < n_columns; ++j)
+    {
+        offsets[j] = first + j * column_size;
+    }
+    os.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    os.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(std::uint64_t));
+
+    std::vector<char> padding(column_alignment, 0);
+    os.write(padding.data(), static_cast<std::streamsize>(first - sizeof(h) - n_columns * sizeof(std::uint64_t)));
+    std::vector<double> column;
+    for (auto j = 0u; j < n_columns; ++j)
+    {
+        strided_view view = data.column(j);
+        if (view.stride() == 1u)
+        {
+            os.write(reinterpret_cast<const char*>(view.data()), view.size() * sizeof(double));
+        } else {
+            column.resize(view.size());
+            for (auto i = 0u; i < view.size(); ++i)
+            {
+                column[i] = view[i];
+            }
+            os.write(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(double));
+        }
+        os.write(padding.data(), static_cast<std::streamsize>(column_size - data.rows() * sizeof(double)));
+    }
+    if (!os)
+    {
+        throw input_error("Could not write " + filename);
+    }
+}
+
+/// Memory-maps a dataset stored in the d-CGP binary columnar format
+/**
+ * The file is mapped read-only and shared, so that opening even a very large dataset costs only
+ * the parsing of its header and concurrent jobs on the same machine share the same page cache.
+ * The returned dataset (column-major, not writable) reads its values directly from the mapping, which
+ * stays alive as long as the dataset or any of its copies or slices.
+ *
+ * \param[in] filename the file name
+ * \param[in] pattern the expected access pattern, passed on to the kernel (madvise) to tune read-ahead
+ *
+ * \return the memory-mapped dcgp::dataset
+ *
+ * @throw dcgp::input_error if the file cannot be mapped, is not a valid binary dataset or stores a type other than double
+ */
+dataset load_binary_dataset(const std::string& filename, access_pattern pattern)
+{
+    std::size_t size = 0u;
+    std::shared_ptr<void> owner = map_file(filename, pattern, size);
+    if (size < sizeof(dataset_header))
+    {
+        throw input_error(filename + " is not a d-CGP binary dataset");
+    }
+
+    const char *base = static_cast<const char*>(owner.get());
+    dataset_header h;
+    std::memcpy(&h, base, sizeof(h));
+    check_header(h, size, filename);
+    const unsigned int n_columns = h.m_n + h.m_m;
+    std::vector<std::uint64_t> offsets(n_columns);
+    std::memcpy(offsets.data(), base + sizeof(h), n_columns * sizeof(std::uint64_t));
+    check_offsets(h, offsets, size, filename);
+
+    if (n_columns == 0u)
+    {
+        return dataset();
+    }
+
+    // Columns evenly spaced (as written by dcgp::save_binary_dataset) are viewed in place
+    std::uint64_t stride = (n_columns > 1u) ? offsets[1] - offsets[0] : align(h.m_rows * sizeof(double));
+    bool evenly_spaced = (n_columns < 2u || offsets[1] >= offsets[0]) && stride % sizeof(double) == 0u && stride >= h.m_rows * sizeof(double);
+    // the offsets and the stride are at most the file size: the sums cannot wrap around
+    for (auto j = 1u; evenly_spaced && j < n_columns; ++j)
+    {
+        evenly_spaced = (offsets[j] == offsets[j - 1u] + stride);
+    }
+    if (evenly_spaced)
+    {
+        std::shared_ptr<double> storage(owner, reinterpret_cast<double*>(const_cast<char*>(base) + offsets[0]));
+        return dataset(storage, h.m_rows, h.m_n, h.m_m, COLUMN_MAJOR, stride / sizeof(double), false);
+    }
+
+    // Otherwise the columns are copied
+    dataset retval(h.m_rows, h.m_n, h.m_m, COLUMN_MAJOR);
+    double *dst = retval.writable_data();
+    for (auto j = 0u; j < n_columns; ++j)
+    {
+        std::memcpy(dst + j * retval.ld(), base + offsets[j], h.m_rows * sizeof(double));
+    }
+    return retval;
+}
+
+/// Loads a CSV file into a dataset, parsing it in parallel
+/**
+ * The file is memory-mapped and split in as many chunks as threads, each one starting at a line boundary.
+ * A first parallel pass counts the points in each chunk, so that the dataset can be allocated once, and a second
+ * parallel pass parses the values writing them directly at their final place in the dataset.
+ *
+ * Each non-empty line must contain exactly n + m values (the n inputs followed by the m outputs) separated by the delimiter.
+ * Blanks around values and Windows line endings are allowed.
+ *
+ * \param[in] filename the file name
+ * \param[in] n number of inputs
+ * \param[in] m number of outputs
+ * \param[in] layout the layout of the returned dataset
+ * \param[in] skip_header whether the first line is a header to be ignored
+ * \param[in] delimiter the character separating values
+ * \param[in] n_threads number of threads to be used (0 to use one per hardware thread)
+ *
+ * \return the dcgp::dataset
+ *
+ * @throw dcgp::input_error if the file cannot be read or a line is malformed
+ */
+dataset load_csv(const std::string& filename, unsigned int n, unsigned int m, dataset_layout layout, bool skip_header, char delimiter, unsigned int n_threads)
+{
+    std::size_t size = 0u;
+    std::shared_ptr<void> owner = map_file(filename, SEQUENTIAL, size);
+    const char *begin = static_cast<const char*>(owner.get());
+    const char *end = begin + size;
+    if (skip_header && size > 0u)
+    {
+        begin = next_line(begin, end);
+    }
+
+    if (n_threads == 0u)
+    {
+        n_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // Chunk boundaries are moved forward to the next line start
+    std::vector<const char*> bounds(n_threads + 1u, end);
+    bounds[0] = begin;
+    for (auto t = 1u; t < n_threads; ++t)
+    {
+        const char *b = begin + (end - begin) * t / n_threads;
+        bounds[t] = (b == begin) ? begin : next_line(std::max(b - 1, bounds[t - 1]), end);
+        bounds[t] = std::max(bounds[t], bounds[t - 1]);
+    }
+
+    // First pass: count the points in each chunk
+    std::vector<std::size_t> counts(n_threads, 0u);
+    std::vector<std::thread> threads;
+    for (auto t = 0u; t < n_threads; ++t)
+    {
+        threads.emplace_back(count_points, bounds[t], bounds[t + 1], std::ref(counts[t]));
+    }
+    for (auto &th : threads) th.join();
+    threads.clear();
+
+    std::vector<std::size_t> first_row(n_threads + 1u, 0u);
+    for (auto t = 0u; t < n_threads; ++t)
+    {
+        first_row[t + 1] = first_row[t] + counts[t];
+    }
+    dataset retval(first_row[n_threads], n, m, layout);
+    double *data = retval.writable_data();
+    const std::size_t ld = retval.ld();
+    const std::size_t row_stride = (layout == ROW_MAJOR) ? ld : 1u;
+    const std::size_t column_stride = (layout == ROW_MAJOR) ? 1u : ld;
+
+    // Second pass: parse the values straight into the dataset
+    std::vector<std::string> errors(n_threads);
+    for (auto t = 0u; t < n_threads; ++t)
+    {
+        threads.emplace_back([&, t]() {
+            std::size_t row = first_row[t];
+            for (const char *line = bounds[t]; line < bounds[t + 1];)
+            {
+                const char *line_end = next_line(line, bounds[t + 1]);
+                if (is_empty_line(line, line_end))
+                {
+                    line = line_end;
+                    continue;
+                }
+                const char *p = line;
+                for (auto j = 0u; j < n + m; ++j)
+                {
+                    while (p != line_end && is_blank(*p)) ++p;
+                    double value;
+                    const char *next;
+                    if (!parse_double(p, line_end, value, next))
+                    {
+                        errors[t] = "Malformed value in data row " + std::to_string(row) + " of " + filename;
+                        return;
+                    }
+                    data[row * row_stride + j * column_stride] = value;
+                    p = next;
+                    while (p != line_end && is_blank(*p)) ++p;
+                    if (j + 1u < n + m)
+                    {
+                        if (p == line_end || *p != delimiter)
+                        {
+                            errors[t] = "Expected " + std::to_string(n + m) + " values in data row " + std::to_string(row) + " of " + filename;
+                            return;
+                        }
+                        ++p;
+                    }
+                }
+                if (p != line_end && *p != '\n')
+                {
+                    errors[t] = "Expected " + std::to_string(n + m) + " values in data row " + std::to_string(row) + " of " + filename;
+                    return;
+                }
+                ++row;
+                line = line_end;
+            }
+        });
+    }
+    for (auto &th : threads) th.join();
+    for (const auto &error : errors)
+    {
+        if (!error.empty()) throw input_error(error);
+    }
+    return retval;
+}
+
+/// Converts a CSV file into the d-CGP binary columnar format
+/**
+ * Parses the CSV file once (see dcgp::load_csv) and writes it with dcgp::save_binary_dataset, so that later jobs can
+ * memory-map it with dcgp::load_binary_dataset instead of parsing it again.
+ *
+ * \param[in] csv_filename the CSV file name
+ * \param[in] filename the binary file name
+ * \param[in] n number of inputs
+ * \param[in] m number of outputs
+ * \param[in] skip_header whether the first line is a header to be ignored
+ * \param[in] delimiter the character separating values
+ * \param[in] n_threads number of threads to be used (0 to use one per hardware thread)
+ *
+ * @throw dcgp::input_error if the CSV file cannot be read or is malformed, or if the binary file cannot be written
+ */
+void csv_to_binary_dataset(const std::string& csv_filename, const std::string& filename, unsigned int n, unsigned int m, bool skip_header, char delimiter, unsigned int n_threads)
+{
+    save_binary_dataset(load_csv(csv_filename, n, m, COLUMN_MAJOR, skip_header, delimiter, n_threads), filename);
+}
+
+/// Constructor
+/** Opens a file in the d-CGP binary columnar format and reads its header
+ *
+ * \param[in] filename the file name
+ *
+ * @throw dcgp::input_error if the file cannot be opened or is not a valid binary dataset
+ */
+binary_file_source::binary_file_source(const std::string& filename) : m_fd(::open(filename.c_str(), O_RDONLY)), m_filename(filename), m_position(0u)
+{
+    if (m_fd < 0)
+    {
+        throw input_error("Could not open " + filename);
+    }
+    try {
+        struct stat st;
+        if (::fstat(m_fd, &st) != 0)
+        {
+            throw input_error("Could not stat " + filename);
+        }
+        const std::size_t size = static_cast<std::size_t>(st.st_size);
+        dataset_header h;
+        if (size < sizeof(h))
+        {
+            throw input_error(filename + " is not a d-CGP binary dataset");
+        }
+        read_fully(m_fd, &h, sizeof(h), 0u, filename);
+        check_header(h, size, filename);
+        m_offsets.resize(h.m_n + h.m_m);
+        read_fully(m_fd, m_offsets.data(), m_offsets.size() * sizeof(std::uint64_t), sizeof(h), filename);
+        check_offsets(h, m_offsets, size, filename);
+        m_n = h.m_n;
+        m_m = h.m_m;
+        m_rows = static_cast<std::size_t>(h.m_rows);
+    } catch (...) {
+        ::close(m_fd);
+        throw;
+    }
+    ::posix_fadvise(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+}
+
+/// Destructor (closes the file)
+binary_file_source::~binary_file_source()
+{
+    ::close(m_fd);
+}
+
+/// Reads the next points into a chunk
+/**
+ * \param[out] chunk a writable column-major dataset with the same inputs and outputs as the file
+ *
+ * \return the number of points read (up to chunk.rows(), zero once the file is exhausted)
+ *
+ * @throw dcgp::input_error if the chunk is incompatible or the file cannot be read
+ */
+std::size_t binary_file_source::read(dataset& chunk)
+{
+    if (chunk.get_n() != m_n || chunk.get_m() != m_m || chunk.layout() != COLUMN_MAJOR)
+    {
+        throw input_error("Chunk is incompatible with " + m_filename);
+    }
+    const std::size_t count = std::min(chunk.rows(), m_rows - m_position);
+    double *dst = chunk.writable_data();
+    for (auto j = 0u; j < m_offsets.size(); ++j)
+    {
+        read_fully(m_fd, dst + j * chunk.ld(), count * sizeof(double), m_offsets[j] + m_position * sizeof(double), m_filename);
+    }
+    m_position += count;
+    return count;
+}
+
+/// Reads the next points into a chunk
+/**
+ * \param[out] chunk a writable dataset with the same inputs and outputs as the source
+ *
+ * \return the number of points read (up to chunk.rows(), zero once the dataset is exhausted)
+ *
+ * @throw dcgp::input_error if the chunk is incompatible
+ */
+std::size_t dataset_source::read(dataset& chunk)
+{
+    if (chunk.get_n() != m_data.get_n() || chunk.get_m() != m_data.get_m())
+    {
+        throw input_error("Chunk is incompatible with the dataset");
+    }
+    const std::size_t count = std::min(chunk.rows(), m_data.rows() - m_position);
+    double *dst = chunk.writable_data();
+    for (auto j = 0u; j < m_data.get_n() + m_data.get_m(); ++j)
+    {
+        strided_view src = m_data.column(j);
+        if (src.stride() == 1u && chunk.layout() == COLUMN_MAJOR)
+        {
+            std::memcpy(dst + j * chunk.ld(), src.data() + m_position, count * sizeof(double));
+        } else {
+            for (auto i = 0u; i < count; ++i)
+            {
+                dst[(chunk.layout() == COLUMN_MAJOR) ? j * chunk.ld() + i : i * chunk.ld() + j] = src[m_position + i];
+            }
+        }
+    }
+    m_position += count;
+    return count;
+}
+
+/// Reads the next points into a chunk
+/**
+ * \param[out] chunk a writable dataset with the same inputs and outputs as the source
+ *
+ * \return the number of points generated (up to chunk.rows(), zero once all points have been generated)
+ *
+ * @throw dcgp::input_error if the chunk is incompatible
+ */
+std::size_t generator_source::read(dataset& chunk)
+{
+    if (chunk.get_n() != m_n || chunk.get_m() != m_m)
+    {
+        throw input_error("Chunk is incompatible with the generator");
+    }
+    const std::size_t count = std::min(chunk.rows(), m_rows - m_position);
+    for (auto i = 0u; i < count; ++i)
+    {
+        m_generator(m_position + i, m_point.data());
+        for (auto j = 0u; j < m_n; ++j)
+        {
+            chunk.set_in(i, j, m_point[j]);
+        }
+        for (auto j = 0u; j < m_m; ++j)
+        {
+            chunk.set_out(i, j, m_point[m_n + j]);
+        }
+    }
+    m_position += count;
+    return count;
+}
+
+} // end of namespace dcgp
@@ -0,0 +1,120 @@
+#ifndef DCGP_DATASET_IO_H
+#define DCGP_DATASET_IO_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "dataset.h"
+
+namespace dcgp {
+
+enum access_pattern {
+    SEQUENTIAL,     // the data will be scanned from the first to the last point (e.g. fitness evaluations)
+    RANDOM_ACCESS   // the data will be accessed in no particular order (e.g. subsampling)
+    };
+
+/// Writes a dataset in the d-CGP binary columnar format
+void save_binary_dataset(const dataset& data, const std::string& filename);
+
+/// Memory-maps a dataset stored in the d-CGP binary columnar format
+dataset load_binary_dataset(const std::string& filename, access_pattern pattern = SEQUENTIAL);
+
+/// Loads a CSV file into a dataset, parsing it in parallel
+dataset load_csv(const std::string& filename, unsigned int n, unsigned int m, dataset_layout layout = COLUMN_MAJOR, bool skip_header = false, char delimiter = ',', unsigned int n_threads = 0u);
+
+/// Converts a CSV file into the d-CGP binary columnar format
+void csv_to_binary_dataset(const std::string& csv_filename, const std::string& filename, unsigned int n, unsigned int m, bool skip_header = false, char delimiter = ',', unsigned int n_threads = 0u);
+
+/// Source of consecutive chunks of points
+/**
+ * Streams a sequence of points (possibly much larger than the available memory) in chunks, see
+ * dcgp::streaming_data_fit. A source is read by one thread at a time.
+ */
+class chunk_source {
+public:
+    virtual ~chunk_source() {}
+    /// Gets the number of inputs
+    virtual unsigned int get_n() const = 0;
+    /// Gets the number of outputs
+    virtual unsigned int get_m() const = 0;
+    /// Reads the next points into a chunk, returns how many were read (up to chunk.rows(), zero once exhausted)
+    virtual std::size_t read(dataset& chunk) = 0;
+    /// Restarts from the first point
+    virtual void rewind() = 0;
+};
+
+/// Streams the points of a file in the d-CGP binary columnar format
+/**
+ * The columns are read with positioned reads, without mapping the file: only the chunks being
+ * processed are ever resident in memory.
+ */
+class binary_file_source : public chunk_source {
+public:
+    explicit binary_file_source(const std::string& filename);
+    ~binary_file_source();
+    binary_file_source(const binary_file_source&) = delete;
+    binary_file_source& operator=(const binary_file_source&) = delete;
+
+    unsigned int get_n() const {return m_n;};
+    unsigned int get_m() const {return m_m;};
+    /// Gets the total number of points
+    std::size_t rows() const {return m_rows;};
+    std::size_t read(dataset& chunk);
+    void rewind() {m_position = 0u;};
+
+private:
+    int m_fd;
+    std::string m_filename;
+    unsigned int m_n;
+    unsigned int m_m;
+    std::size_t m_rows;
+    std::size_t m_position;
+    std::vector<std::uint64_t> m_offsets;
+};
+
+/// Streams the points of a dataset
+/**
+ * Typically a memory-mapped dataset (see dcgp::load_binary_dataset), whose pages are then faulted in
+ * one window at a time by the thread reading the source.
+ */
+class dataset_source : public chunk_source {
+public:
+    explicit dataset_source(const dataset& data) : m_data(data), m_position(0u) {};
+
+    unsigned int get_n() const {return m_data.get_n();};
+    unsigned int get_m() const {return m_data.get_m();};
+    std::size_t read(dataset& chunk);
+    void rewind() {m_position = 0u;};
+
+private:
+    dataset m_data;
+    std::size_t m_position;
+};
+
+/// Streams points produced on the fly
+/**
+ * The generator is called with the index of the point and a pointer where to write its n inputs followed by its m outputs.
+ */
+class generator_source : public chunk_source {
+public:
+    generator_source(unsigned int n, unsigned int m, std::size_t rows, std::function<void(std::size_t, double*)> generator) : m_n(n), m_m(m), m_rows(rows), m_position(0u), m_generator(generator), m_point(n + m) {};
+
+    unsigned int get_n() const {return m_n;};
+    unsigned int get_m() const {return m_m;};
+    std::size_t read(dataset& chunk);
+    void rewind() {m_position = 0u;};
+
+private:
+    unsigned int m_n;
+    unsigned int m_m;
+    std::size_t m_rows;
+    std::size_t m_position;
+    std::function<void(std::size_t, double*)> m_generator;
+    std::vector<double> m_point;
+};
+
+} // end of namespace dcgp
+
+#endif // DCGP_DATASET_IO_H
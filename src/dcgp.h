@@ -2,10 +2,28 @@
 #define DCGP_H
 
 #include "expression.h"
+#include "topology.h"
 #include "basis_function.h"
+#include "interval.h"
 #include "wrapped_functions.h"
 #include "fitness_functions.h"
 #include "function_set.h"
+#include "codegen.h"
+#include "jit.h"
+#include "program.h"
+#include "compiled_model.h"
+#include "instrumentation.h"
+#include "level_evaluator.h"
+#include "archive.h"
+#include "checkpoint.h"
+#include "dataset.h"
+#include "dataset_io.h"
+#include "progressive_fit.h"
+#include "semantic_cache.h"
+#include "window_fit.h"
+#include "island_model.h"
+#include "steady_state.h"
+#include "telemetry.h"
 #include "std_overloads.h"
 
 #endif // DCGP_H
\ No newline at end of file
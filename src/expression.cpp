@@ -1,9 +1,12 @@
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
+#include <string>
 #include <random>
 #include <limits>
 #include <cmath>
+#include <utility>
 
 #include "expression.h"
 #include "std_overloads.h"
@@ -20,8 +23,9 @@ namespace dcgp {
  * \param[in] c number of columns of the cartesian cgp
  * \param[in] l number of levels-back allowed for the cartesian cgp
  * \param[in] f function set. An std::vector of dcgp::basis_function
- * \param[in] tol tolerance to be used in case dcgp::expression::HITS_BASED is used as fitness evaluation 
  * \param[in] seed seed for the random number generator (initial expression  and mutations depend on this)
+ *
+ * @throw dcgp::input_error if any of n, m, r, c, l or the number of functions is 0
  */
 expression::expression(unsigned int n,              // n. inputs
                    unsigned int m,                  // n. outputs
@@ -30,45 +34,34 @@ expression::expression(unsigned int n,              // n. inputs
                    unsigned int l,                  // n. levels-back
                    std::vector<basis_function> f,   // functions
                    unsigned int seed                // seed for the pseudo-random numbers
-                   ) : m_n(n), m_m(m), m_r(r), m_c(c), m_l(l), m_f(f), m_lb((3 * m_r * m_c) + m_m, 0), m_ub((3 * m_r * m_c) + m_m, 0), m_x((3 * m_r * m_c) + m_m, 0), m_e(seed)
+                   ) : expression(make_topology(n, m, r, c, l, std::move(f)), seed)
 {
+}
 
-    if (n == 0) throw input_error("Number of inputs is 0");
-    if (m == 0) throw input_error("Number of outputs is 0");
-    if (c == 0) throw input_error("Number of columns is 0");
-    if (r == 0) throw input_error("Number of rows is 0");
-    if (l == 0) throw input_error("Number of level-backs is 0");
-    if (f.size()==0) throw input_error("Number of basis functions is 0");
-
-    // Bounds for the function genes
-    for (auto i = 0u; i < (3 * m_r * m_c); i+=3) {
-        m_ub[i] = f.size() - 1;
-    }
-
-    // Bounds for the output genes
-    for (auto i = 3u * m_r * m_c; i < m_ub.size(); ++i) {
-        m_ub[i] = m_n + m_r * m_c - 1;
-        if (m_l <= m_c) {
-            m_lb[i] = m_n + m_r * (m_c - m_l);
-        }
-    }
-
-    // Bounds for the node connection genes 
-    for (auto i = 0u; i < m_c; ++i) {
-        for (auto j = 0u; j < m_r; ++j) {
-            m_ub[((i * m_r) + j) * 3 + 1] = m_n + i * m_r - 1;
-            m_ub[((i * m_r) + j) * 3 + 2] = m_n + i * m_r - 1;
-            if (i >= m_l) {
-                m_lb[((i * m_r) + j) * 3 + 1] = m_n + m_r * (i - m_l);
-                m_lb[((i * m_r) + j) * 3 + 2] = m_n + m_r * (i - m_l);
-            }
-        }
-    }
+/// Constructor from a shared topology
+/** Constructs a random d-cgp expression having a given topology, without copying it
+ *
+ * \param[in] topology the topology (see dcgp::make_topology and dcgp::expression::get_topology)
+ * \param[in] seed seed for the random number generator (initial expression  and mutations depend on this)
+ *
+ * @throw dcgp::input_error if the topology is null
+ */
+expression::expression(std::shared_ptr<const expression_topology> topology, unsigned int seed) : m_topology(std::move(topology)), m_e(seed)
+{
+    if (!m_topology) throw input_error("Topology is null");
+    m_n = m_topology->get_n();
+    m_m = m_topology->get_m();
+    m_r = m_topology->get_r();
+    m_c = m_topology->get_c();
+    m_l = m_topology->get_l();
 
     // We generate a random expression
+    const std::vector<unsigned int>& lb = m_topology->get_lb();
+    const std::vector<unsigned int>& ub = m_topology->get_ub();
+    m_x.resize(lb.size());
     for (auto i = 0u; i < m_x.size(); ++i)
     {
-        m_x[i] = std::uniform_int_distribution<unsigned int>(m_lb[i], m_ub[i])(m_e);
+        m_x[i] = std::uniform_int_distribution<unsigned int>(lb[i], ub[i])(m_e);
     }
     update_active();
 }
@@ -82,11 +75,25 @@ expression::expression(unsigned int n,              // n. inputs
  */
 void expression::set(const std::vector<unsigned int>& x)
 {
-    if(!is_valid(x))
+    set(x.data(), x.size());
+}
+
+/// Sets the chromosome from raw memory
+/** Sets a new chromosome as genotype for the expression reading it directly from memory
+ * (e.g. a memory-mapped dcgp::archive) and updates the active nodes and active genes information
+ *
+ * \param[in] x pointer to the first gene of the new chromosome
+ * \param[in] size number of genes
+ *
+ * @throw dcgp::input_error if the chromosome is incompatible with the expression (n.inputs, n.outputs, levels-back, etc.)
+ */
+void expression::set(const unsigned int* x, std::size_t size)
+{
+    if(!is_valid(x, size))
     {
         throw input_error("Chromosome is incompatible");
     }
-    m_x = x;
+    m_x.assign(x, x + size);
     update_active();
 }
 
@@ -101,6 +108,206 @@ inline unsigned int factorial(unsigned int n)
 }
 
 
+/// Computes the outputs of the expression without allocating memory
+/**
+ * Same outputs as dcgp::expression::operator(), with the values of the nodes kept in a caller-owned workspace.
+ * Once the workspace has grown to the size of the expression, no memory is allocated.
+ *
+ * \param[in] in pointer to the n inputs
+ * \param[out] out pointer to the m outputs
+ * \param[in] ws the workspace
+ */
+void expression::eval_into(const double *in, double *out, workspace& ws) const
+{
+    DCGP_TIME_SCOPE(TIME_EVALUATION);
+    DCGP_INSTRUMENT(instrument_evaluation(*this));
+    const std::vector<basis_function>& f = m_topology->get_f();
+    if (ws.m_values.size() < m_n + m_r * m_c)
+    {
+        DCGP_COUNT(COUNT_ALLOCATIONS, 1u);
+        ws.m_values.resize(m_n + m_r * m_c);
+    }
+    double *node = ws.m_values.data();
+    for (auto i : m_active_nodes)
+    {
+        if (i < m_n)
+        {
+            node[i] = in[i];
+        } else {
+            unsigned int idx = (i - m_n) * 3;
+            // unary functions ignore their second argument, which may not have been computed
+            const double a = node[m_x[idx + 1]];
+            node[i] = f[m_x[idx]](a, (f[m_x[idx]].m_arity > 1u) ? node[m_x[idx + 2]] : a);
+        }
+    }
+    for (auto i = 0u; i<m_m; ++i)
+    {
+        out[i] = node[m_x[(m_r * m_c) * 3 + i]];
+    }
+}
+
+/// Computes the outputs of the expression on all the points of a dataset
+/**
+ * \param[in] data the dataset (only its inputs are read)
+ *
+ * \return the outputs, rows times m values (the m outputs of each point are contiguous)
+ *
+ * @throw dcgp::input_error if the dataset does not have the inputs of the expression
+ */
+std::vector<double> expression::eval(const dataset& data) const
+{
+    DCGP_COUNT(COUNT_ALLOCATIONS, 1u);
+    workspace ws;
+    std::vector<double> retval(data.rows() * m_m);
+    eval_into(data, retval.data(), ws);
+    return retval;
+}
+
+/// Computes the outputs of the expression on all the points of a dataset without allocating memory
+/**
+ * Each point is evaluated as by dcgp::expression::eval_into. The inputs of a row-major dataset are read in place,
+ * those of a column-major one are first gathered in the workspace. Once the workspace has grown to the size of the
+ * expression, no memory is allocated.
+ *
+ * \param[in] data the dataset (only its inputs are read)
+ * \param[out] out pointer to the outputs, rows times m values (the m outputs of each point are contiguous)
+ * \param[in] ws the workspace
+ *
+ * @throw dcgp::input_error if the dataset does not have the inputs of the expression
+ */
+void expression::eval_into(const dataset& data, double *out, workspace& ws) const
+{
+    if (data.get_n() != m_n)
+    {
+        throw input_error("Dataset is incompatible with the expression inputs");
+    }
+    if (ws.m_inputs.size() < m_n)
+    {
+        DCGP_COUNT(COUNT_ALLOCATIONS, 1u);
+        ws.m_inputs.resize(m_n);
+    }
+    for (std::size_t i = 0u; i < data.rows(); ++i)
+    {
+        const strided_view point = data.row(i);
+        if (point.stride() == 1u)
+        {
+            eval_into(point.data(), out + i * m_m, ws);
+            continue;
+        }
+        for (auto j = 0u; j < m_n; ++j)
+        {
+            ws.m_inputs[j] = point[j];
+        }
+        eval_into(ws.m_inputs.data(), out + i * m_m, ws);
+    }
+}
+
+/// Gets the active nodes an output depends on
+/**
+ * Gets the idx of the active nodes needed to compute one output (its cone), sorted as dcgp::expression::get_active_nodes.
+ * The cones are computed together with the active nodes. The cone of the only output of an expression is made of all
+ * its active nodes.
+ *
+ * \param[in] output the output
+ *
+ * \return An std::vector containing the idx of the nodes of the cone
+ *
+ * @throw dcgp::input_error if the output does not exist
+ */
+const std::vector<unsigned int>& expression::get_output_cone(unsigned int output) const
+{
+    if (output >= m_m)
+    {
+        throw input_error("Output " + std::to_string(output) + " does not exist");
+    }
+    return output_cone(output);
+}
+
+/// Computes some of the outputs of the expression
+/**
+ * Only the nodes the requested outputs depend on are computed (see dcgp::expression::eval_outputs_into).
+ *
+ * \param[in] in std::vector containing the inputs
+ * \param[in] outputs the outputs to be computed, in any order
+ *
+ * \return the requested outputs, in the order given
+ *
+ * @throw dcgp::input_error if the input size is incompatible or an output does not exist
+ */
+std::vector<double> expression::eval_outputs(const std::vector<double>& in, const std::vector<unsigned int>& outputs) const
+{
+    if(in.size() != m_n)
+    {
+        throw input_error("Input size is incompatible");
+    }
+    DCGP_COUNT(COUNT_ALLOCATIONS, 1u);
+    workspace ws;
+    std::vector<double> retval(outputs.size());
+    eval_outputs_into(in.data(), outputs.data(), outputs.size(), retval.data(), ws);
+    return retval;
+}
+
+/// Computes some of the outputs of the expression without allocating memory
+/**
+ * Computes only the union of the cones of the requested outputs (see dcgp::expression::get_output_cone), so that
+ * the nodes shared by several outputs are computed once and those needed only by the other outputs are skipped.
+ * The outputs are the same as those of dcgp::expression::eval_into. Once the workspace has grown to the size of the
+ * expression, no memory is allocated.
+ *
+ * \param[in] in pointer to the n inputs
+ * \param[in] outputs pointer to the indices of the outputs to be computed, in any order
+ * \param[in] count number of outputs to be computed
+ * \param[out] out pointer to the count outputs, in the order of outputs
+ * \param[in] ws the workspace
+ *
+ * @throw dcgp::input_error if an output does not exist
+ */
+void expression::eval_outputs_into(const double *in, const unsigned int *outputs, std::size_t count, double *out, workspace& ws) const
+{
+    DCGP_TIME_SCOPE(TIME_EVALUATION);
+    for (auto k = 0u; k < count; ++k)
+    {
+        if (outputs[k] >= m_m)
+        {
+            throw input_error("Output " + std::to_string(outputs[k]) + " does not exist");
+        }
+    }
+    const std::vector<basis_function>& f = m_topology->get_f();
+    if (ws.m_values.size() < m_n + m_r * m_c)
+    {
+        DCGP_COUNT(COUNT_ALLOCATIONS, 1u);
+        ws.m_values.resize(m_n + m_r * m_c);
+    }
+    if (ws.m_stamps.size() < m_n + m_r * m_c)
+    {
+        DCGP_COUNT(COUNT_ALLOCATIONS, 1u);
+        ws.m_stamps.resize(m_n + m_r * m_c, 0u);
+    }
+    // a node computed for a previous output of this evaluation carries the current stamp
+    const unsigned long stamp = ++ws.m_stamp;
+    double *node = ws.m_values.data();
+    unsigned long *computed = ws.m_stamps.data();
+    for (auto k = 0u; k < count; ++k)
+    {
+        for (auto i : output_cone(outputs[k]))
+        {
+            if (computed[i] == stamp) continue;
+            computed[i] = stamp;
+            if (i < m_n)
+            {
+                node[i] = in[i];
+            } else {
+                unsigned int idx = (i - m_n) * 3;
+                // unary functions ignore their second argument, which may not have been computed
+                const double a = node[m_x[idx + 1]];
+                node[i] = f[m_x[idx]](a, (f[m_x[idx]].m_arity > 1u) ? node[m_x[idx + 2]] : a);
+            }
+        }
+        out[k] = node[m_x[(m_r * m_c) * 3 + outputs[k]]];
+    }
+    DCGP_INSTRUMENT(instrument_evaluation(*this, computed, stamp));
+}
+
 /// Computes the derivatives of the expression
 /** 
  * Using automated differentiation rules this method returns the derivatives up to a certain order, with respect
@@ -120,40 +327,76 @@ std::vector<std::vector<double> > expression::differentiate(unsigned int wrt, un
     {
         throw input_error("Input size is incompatible");
     }
+    DCGP_COUNT(COUNT_ALLOCATIONS, 1u);
+    workspace ws;
+    std::vector<double> out((order + 1) * m_m);
+    differentiate_into(wrt, order, in.data(), out.data(), ws);
+    std::vector<std::vector<double> > retval(order + 1);
+    for (auto j = 0u; j<=order; ++j)
+    {
+        retval[j].assign(out.begin() + j * m_m, out.begin() + (j + 1) * m_m);
+    }
+    return retval;
+}
+
+/// Computes the derivatives of the expression without allocating memory
+/** 
+ * Same derivatives as dcgp::expression::differentiate, with the Taylor coefficients of the nodes kept in a
+ * caller-owned workspace. Once the workspace has grown to the size of the expression and to the order, no memory
+ * is allocated.
+ *
+ * \param[in] wrt index of the derivation variable (0,1 ..., m_n)
+ * \param[in] order the derivative order we want to compute
+ * \param[in] in pointer to the n inputs
+ * \param[out] out pointer to (order + 1) * m values: the j-th derivative of the k-th output is written in out[j * m + k]
+ * \param[in] ws the workspace
+ *
+ * @throw dcgp::input_error if wrt is not an input
+ */
+void expression::differentiate_into(unsigned int wrt, unsigned int order, const double *in, double *out, workspace& ws) const
+{
     if(wrt >= m_n)
     {
         throw input_error("Derivative id is larger than the independent variable number");
     }
-//for (auto i : m_active_nodes) std::cout << " " << i; std::cout << std::endl;
-    std::vector<double> dumb(m_m);
-    std::vector<std::vector<double> > retval(order+1,dumb);
-    std::map<unsigned int, std::vector<double> > node_jet;
+    DCGP_TIME_SCOPE(TIME_DIFFERENTIATION);
+    DCGP_COUNT(COUNT_DIFFERENTIATIONS, 1u);
+    const std::vector<basis_function>& f = m_topology->get_f();
+    if (ws.m_jets.size() < m_n + m_r * m_c)
+    {
+        DCGP_COUNT(COUNT_ALLOCATIONS, 1u);
+        ws.m_jets.resize(m_n + m_r * m_c);
+    }
+    std::vector<std::vector<double> >& node_jet = ws.m_jets;
+    for (auto i : m_active_nodes)
+    {
+        node_jet[i].clear();
+    }
     for (auto j =0u; j<=order; ++j)
     {
         for (auto i : m_active_nodes)
         {
             if (i < m_n) 
             {
-                //if (j==0) node_jet[i] = std::vector<double>({in[i]});
                 if (j==0) node_jet[i].push_back(in[i]);
                 else if (j==1) node_jet[i].push_back((i==wrt) ? 1. : 0.);
                 else node_jet[i].push_back(0.);
             } else {
                 unsigned int idx = (i - m_n) * 3;
-                if (j==0) node_jet[i] = std::vector<double>({m_f[m_x[idx]].m_df(node_jet[m_x[idx + 1]], node_jet[m_x[idx + 2]])});
-                else node_jet[i].push_back(m_f[m_x[idx]].m_df(node_jet[m_x[idx + 1]], node_jet[m_x[idx + 2]]));
+                const std::vector<double>& a = node_jet[m_x[idx + 1]];
+                const std::vector<double>& b = (f[m_x[idx]].m_arity > 1u) ? node_jet[m_x[idx + 2]] : a;
+                const basis_function& fn = f[m_x[idx]];
+                node_jet[i].push_back(fn.m_df_into ? fn.m_df_into(a, b, ws.m_scratch) : fn.m_df(a, b));
             }
         }
     }
-//std::cout << i << ", " << node_jet[i] << std::endl;
 
     for (auto j = 0u; j<=order; ++j) {
         for (auto i = 0u; i<m_m; ++i)
         {
-            retval[j][i] = node_jet[m_x[(m_r * m_c) * 3 + i]][j] * factorial(j);
+            out[j * m_m + i] = node_jet[m_x[(m_r * m_c) * 3 + i]][j] * factorial(j);
         }
     }
-    return retval;
 }
 
 /// Mutates one of the active genes
@@ -162,15 +405,18 @@ std::vector<std::vector<double> > expression::differentiate(unsigned int wrt, un
  */
 void expression::mutate_active()
 {
+    DCGP_TIME_SCOPE(TIME_MUTATION);
+    DCGP_COUNT(COUNT_MUTATIONS, 1u);
     unsigned int idx = std::uniform_int_distribution<unsigned int>(0, m_active_genes.size() - 1)(m_e);
     idx = m_active_genes[idx];
+    const unsigned int lb = m_topology->get_lb()[idx], ub = m_topology->get_ub()[idx];
 
-    if (m_lb[idx]<m_ub[idx]) // if only one value is allowed for the gene, then we will not do anything as mutation does not apply
+    if (lb<ub) // if only one value is allowed for the gene, then we will not do anything as mutation does not apply
     {
         unsigned int new_value = UINT_MAX;
         do 
         {
-            new_value = std::uniform_int_distribution<unsigned int>(m_lb[idx], m_ub[idx])(m_e);
+            new_value = std::uniform_int_distribution<unsigned int>(lb, ub)(m_e);
         } while (new_value == m_x[idx]);
         m_x[idx] = new_value;
         update_active();
@@ -182,18 +428,21 @@ void expression::mutate_active()
  * Checks if a chromosome (i.e. a sequence of integers) is a valid expression
  * by checking its length and the bounds
  *
- * \param[in] x chromosome 
+ * \param[in] x pointer to the first gene of the chromosome
+ * \param[in] size number of genes
  */
-bool expression::is_valid(const std::vector<unsigned int>& x) const
+bool expression::is_valid(const unsigned int* x, std::size_t size) const
 {
+    const std::vector<unsigned int>& lb = m_topology->get_lb();
+    const std::vector<unsigned int>& ub = m_topology->get_ub();
     // Checking for length
-    if (x.size() != m_lb.size()) {
+    if (size != lb.size()) {
         return false;
     }
 
     // Checking for bounds on all cenes
-    for (auto i = 0u; i < x.size(); ++i) {
-        if ((x[i] > m_ub[i]) || (x[i] < m_lb[i])) {
+    for (auto i = 0u; i < size; ++i) {
+        if ((x[i] > ub[i]) || (x[i] < lb[i])) {
             return false;
         }
     }
@@ -204,7 +453,10 @@ bool expression::is_valid(const std::vector<unsigned int>& x) const
 /// Updates the m_active_genes and m_active_nodes data member
 void expression::update_active()
 {
-    assert(m_x.size() == m_lb.size());
+    assert(m_x.size() == m_topology->size());
+    DCGP_TIME_SCOPE(TIME_UPDATE_ACTIVE);
+    DCGP_COUNT(COUNT_ACTIVE_UPDATES, 1u);
+    const std::vector<basis_function>& f = m_topology->get_f();
 
     // First we update the active nodes
     std::vector<unsigned int> current(m_m), next;
@@ -222,7 +474,8 @@ void expression::update_active()
             if (node_id >=m_n) // we insert the input nodes connections as they do not have any
             {
                 next.push_back(m_x[(node_id - m_n) * 3 + 1]);
-                next.push_back(m_x[(node_id - m_n) * 3 + 2]);
+                // unary functions do not read their second connection
+                if (f[m_x[(node_id - m_n) * 3]].m_arity > 1u) next.push_back(m_x[(node_id - m_n) * 3 + 2]);
             }
             else{
                 m_active_nodes.push_back(node_id);
@@ -238,6 +491,35 @@ void expression::update_active()
     // We remove duplicates and keep m_active_nodes sorted
     std::sort( m_active_nodes.begin(), m_active_nodes.end() );
     m_active_nodes.erase( std::unique( m_active_nodes.begin(), m_active_nodes.end() ), m_active_nodes.end() );
+    DCGP_INSTRUMENT(instrument_active_size(m_active_nodes.size()));
+
+    // Then the cone of each output: sweeping the active nodes backwards, the nodes an output depends on are marked
+    // before being reached. A single output depends on all the active nodes, and needs no cone
+    m_output_cones.resize(m_m > 1u ? m_m : 0u);
+    if (m_m > 1u && m_marked.size() < m_n + m_r * m_c)
+    {
+        m_marked.resize(m_n + m_r * m_c, 0);
+    }
+    for (auto j = 0u; j < m_output_cones.size(); ++j)
+    {
+        // the marks are all cleared by the sweep of the previous output
+        char *marked = m_marked.data();
+        m_output_cones[j].clear();
+        marked[m_x[3 * m_r * m_c + j]] = 1;
+        for (auto it = m_active_nodes.rbegin(); it != m_active_nodes.rend(); ++it)
+        {
+            if (!marked[*it]) continue;
+            m_output_cones[j].push_back(*it);
+            marked[*it] = 0;
+            if (*it >= m_n)
+            {
+                const unsigned int idx = (*it - m_n) * 3;
+                marked[m_x[idx + 1]] = 1;
+                if (f[m_x[idx]].m_arity > 1u) marked[m_x[idx + 2]] = 1;
+            }
+        }
+        std::reverse(m_output_cones[j].begin(), m_output_cones[j].end());
+    }
 
     // Then the active genes
     m_active_genes.clear();
@@ -248,7 +530,7 @@ void expression::update_active()
             unsigned int idx = (m_active_nodes[i] - m_n) * 3;
             m_active_genes.push_back(idx);
             m_active_genes.push_back(idx + 1);
-            m_active_genes.push_back(idx + 2);
+            if (f[m_x[idx]].m_arity > 1u) m_active_genes.push_back(idx + 2);
         }
     }
     for (auto i = 0u; i<m_m; ++i) 
@@ -272,12 +554,12 @@ std::string expression::human_readable() const
     s << "\tNumber of rows:\t\t\t" << m_r << '\n';
     s << "\tNumber of columns:\t\t" << m_c << '\n';
     s << "\tNumber of levels-back allowed:\t" << m_l << '\n';
-    s << "\n\tResulting lower bounds:\t" << m_lb;
-    s << "\n\tResulting upper bounds:\t" << m_ub << '\n';
+    s << "\n\tResulting lower bounds:\t" << m_topology->get_lb();
+    s << "\n\tResulting upper bounds:\t" << m_topology->get_ub() << '\n';
     s << "\n\tCurrent expression (encoded):\t" << m_x << '\n';
     s << "\tActive nodes:\t\t\t" << m_active_nodes << '\n';
     s << "\tActive genes:\t\t\t" << m_active_genes << '\n';
-    s << "\n\tFunction set:\t\t\t" << m_f << '\n';
+    s << "\n\tFunction set:\t\t\t" << m_topology->get_f() << '\n';
     return s.str();
 }
 
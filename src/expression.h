@@ -4,21 +4,53 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <memory>
 #include <random>
 
 #include "basis_function.h"
+#include "dataset.h"
 #include "exceptions.h"
+#include "instrumentation.h"
 #include "rng.h"
+#include "topology.h"
 
 
 namespace dcgp {
 
+/// Scratch memory of dcgp::expression::eval_into and dcgp::expression::differentiate_into
+/**
+ * Holds the values (and the derivatives) of the nodes of an expression. It grows to fit the largest expression
+ * it is used with and is then reused, so that evaluations do not allocate memory. A workspace can be used
+ * with several expressions, but not by several threads at the same time: each thread should own one.
+ */
+class workspace {
+public:
+    workspace() : m_values(), m_jets(), m_stamps(), m_stamp(0u), m_inputs(), m_scratch() {};
+
+private:
+    friend class expression;
+    // the value of each node (inputs included)
+    std::vector<double> m_values;
+    // the Taylor coefficients of each node
+    std::vector<std::vector<double> > m_jets;
+    // the evaluation which last computed each node (see dcgp::expression::eval_outputs_into)
+    std::vector<unsigned long> m_stamps;
+    unsigned long m_stamp;
+    // the inputs of a point of a column-major dataset (see dcgp::expression::eval_into)
+    std::vector<double> m_inputs;
+    // the temporaries of the derivatives of the functions (see dcgp::basis_function::m_df_into)
+    std::vector<double> m_scratch;
+};
+
 /// A d-CGP expression
 /**
  * This class represent a mathematical expression as encoded using CGP and contains
  * algorithms that compute its value (numerical and symbolical) and its derivatives 
  * its fitness on a given input target set, as well as mutate the expression. 
  *
+ * The topology (see dcgp::expression_topology) is shared, not copied, by the copies of an expression and by the
+ * expressions constructed from the same dcgp::expression_topology.
+ *
  * @author Dario Izzo (dario.izzo@gmail.com)
  */
 class expression {
@@ -31,8 +63,10 @@ public:
             std::vector<basis_function> f, 
             unsigned int seed = rng::get_seed()
             );
+    expression(std::shared_ptr<const expression_topology> topology, unsigned int seed = rng::get_seed());
 
     void set(const std::vector<unsigned int> &x);
+    void set(const unsigned int *x, std::size_t size);
 
     /// Gets the chromosome
     /** 
@@ -57,6 +91,7 @@ public:
      * \return An std::vector containing the idx of the active nodes
     */
     const std::vector<unsigned int> & get_active_nodes() const {return m_active_nodes;};
+    const std::vector<unsigned int> & get_output_cone(unsigned int output) const;
     /// Gets the number of inputs
     /** 
      * Gets the number of inputs of the c_CGP expression
@@ -71,6 +106,27 @@ public:
      * \return the number of outputs
     */
     unsigned int get_m() const {return m_m;};
+    /// Gets the number of rows
+    /**
+     * Gets the number of rows of the c_CGP expression
+     *
+     * \return the number of rows
+    */
+    unsigned int get_r() const {return m_r;};
+    /// Gets the number of columns
+    /**
+     * Gets the number of columns of the c_CGP expression
+     *
+     * \return the number of columns
+    */
+    unsigned int get_c() const {return m_c;};
+    /// Gets the number of levels-back
+    /**
+     * Gets the number of levels-back allowed in the c_CGP expression
+     *
+     * \return the number of levels-back
+    */
+    unsigned int get_l() const {return m_l;};
 
     /// Gets the functions
     /** 
@@ -78,7 +134,15 @@ public:
      *
      * \return an std::vector<basis_function>
     */
-    const std::vector<basis_function>& get_f() const {return m_f;};
+    const std::vector<basis_function>& get_f() const {return m_topology->get_f();};
+
+    /// Gets the topology
+    /**
+     * Gets the topology, which can be used to cheaply construct other expressions having it
+     *
+     * \return the shared dcgp::expression_topology
+    */
+    const std::shared_ptr<const expression_topology>& get_topology() const {return m_topology;};
 
     void mutate_active();
     
@@ -90,6 +154,10 @@ public:
             throw input_error("Input size is incompatible");
         }
 //for (auto i : m_active_nodes) std::cout << " " << i; std::cout << std::endl;
+        DCGP_TIME_SCOPE(TIME_EVALUATION);
+        DCGP_INSTRUMENT(instrument_evaluation(*this));
+        DCGP_COUNT(COUNT_ALLOCATIONS, 1u);
+        const std::vector<basis_function>& f = m_topology->get_f();
         std::vector<T> retval(m_m);
         std::map<unsigned int, T> node;
         for (auto i : m_active_nodes) {
@@ -98,7 +166,9 @@ public:
                 node[i] = in[i];
             } else {
                 unsigned int idx = (i - m_n) * 3;
-                node[i] = m_f[m_x[idx]](node[m_x[idx + 1]], node[m_x[idx + 2]]);
+                // unary functions ignore their second argument, which may not have been computed
+                const T& a = node[m_x[idx + 1]];
+                node[i] = f[m_x[idx]](a, (f[m_x[idx]].m_arity > 1u) ? node[m_x[idx + 2]] : a);
             }
 //std::cout << i << ", " << node[i] << std::endl;
         }
@@ -109,15 +179,25 @@ public:
         return retval;
     }
 
+    void eval_into(const double *in, double *out, workspace& ws) const;
+    std::vector<double> eval(const dataset& data) const;
+    void eval_into(const dataset& data, double *out, workspace& ws) const;
+    std::vector<double> eval_outputs(const std::vector<double>& in, const std::vector<unsigned int>& outputs) const;
+    void eval_outputs_into(const double *in, const unsigned int *outputs, std::size_t count, double *out, workspace& ws) const;
     std::vector<std::vector<double> > differentiate(unsigned int wrt, unsigned int degree, const std::vector<double>& in) const;
+    void differentiate_into(unsigned int wrt, unsigned int order, const double *in, double *out, workspace& ws) const;
     std::string human_readable() const;
 
 protected: 
-    bool is_valid(const std::vector<unsigned int>& x) const;
+    bool is_valid(const unsigned int *x, std::size_t size) const;
     void update_active();
+    /// Gets the active nodes an output depends on (not checking that it exists)
+    const std::vector<unsigned int>& output_cone(unsigned int output) const {return (m_m == 1u) ? m_active_nodes : m_output_cones[output];};
 
 private:
-    // number of inputs
+    // the topology, shared with other expressions
+    std::shared_ptr<const expression_topology> m_topology;
+    // number of inputs (m_n to m_l are copied from the topology)
     unsigned int m_n;
     // number of outputs
     unsigned int m_m;
@@ -127,13 +207,12 @@ private:
     unsigned int m_c;
     // number of levels_back allowed
     unsigned int m_l;
-    // the functions allowed
-    std::vector<basis_function> m_f;
-    // lower and upper bounds on all genes
-    std::vector<unsigned int> m_lb;
-    std::vector<unsigned int> m_ub;
     // active nodes idx (guaranteed to be always sorted)
     std::vector<unsigned int> m_active_nodes;
+    // active nodes idx needed by each output (sorted), empty if there is a single output
+    std::vector<std::vector<unsigned int> > m_output_cones;
+    // marks of the nodes during the computation of the cones, all zero in between
+    std::vector<char> m_marked;
     // active genes idx
     std::vector<unsigned int> m_active_genes;
     // the actual expression encoded in a chromosome
@@ -1,4 +1,11 @@
+#include <algorithm>
 #include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include "fitness_functions.h"
@@ -6,6 +13,148 @@
 #include "exceptions.h"
 
 namespace dcgp {
+
+namespace {
+    /// Fitness contribution of one point
+    template <typename Out>
+    double point_fit(const std::vector<double>& out_real, const Out& out_des, fitness_type type, double tol)
+    {
+        double retval = 0.;
+        DCGP_COUNT(COUNT_FITNESS_POINTS, 1u);
+        DCGP_INSTRUMENT(for (auto y : out_real) if (!std::isfinite(y)) instrument_count(COUNT_NON_FINITE_OUTPUTS));
+        if (type == fitness_type::ERROR_BASED)
+        {
+            for (auto j = 0u; j < out_real.size(); ++j)
+            {
+                if (std::isfinite(out_real[j]))
+                {
+                    retval += 1.0 / (1.0 + fabs(out_des[j] - out_real[j]));
+                }
+            }
+        } else if (type == fitness_type::HITS_BASED){
+            for (auto j = 0u; j < out_real.size(); ++j)
+            {
+                if (std::isfinite(out_real[j]))
+                {
+                    if (fabs(out_des[j] - out_real[j]) < tol) retval += 1.0;
+                }
+            }
+        }
+        return retval;
+    }
+
+    // Number of independent accumulators used by the loss reductions
+    const unsigned int loss_lanes = 4u;
+
+    /// Compensated (Kahan-Babuska-Neumaier) sum
+    struct compensated_sum
+    {
+        compensated_sum() : m_sum(0.), m_c(0.) {}
+        void add(double x)
+        {
+            double t = m_sum + x;
+            if (std::abs(m_sum) >= std::abs(x)) m_c += (m_sum - t) + x;
+            else m_c += (x - t) + m_sum;
+            m_sum = t;
+        }
+        double value() const {return m_sum + m_c;}
+        double m_sum;
+        double m_c;
+    };
+
+    /// Partial reduction of the errors on one output
+    struct loss_accumulator
+    {
+        loss_accumulator() : m_count(0u), m_non_finite(0u), m_lane(0u), m_max(0.), m_mean(0.), m_m2(0.) {}
+
+        void add(double err, double y, loss_type type)
+        {
+            ++m_count;
+            if (type == MAX_ERROR)
+            {
+                m_max = std::max(m_max, std::abs(err));
+                return;
+            }
+            // consecutive errors go to different lanes, which are independent dependency chains
+            m_lanes[m_lane].add(type == MAE ? std::abs(err) : err * err);
+            m_lane = (m_lane + 1u) % loss_lanes;
+            if (type == R2)
+            {
+                // Welford update of the mean and the sum of squared deviations of the target
+                double delta = y - m_mean;
+                m_mean += delta / static_cast<double>(m_count);
+                m_m2 += delta * (y - m_mean);
+            }
+        }
+
+        void merge(const loss_accumulator& other)
+        {
+            m_non_finite += other.m_non_finite;
+            if (other.m_count == 0u) return;
+            const double n_a = static_cast<double>(m_count), n_b = static_cast<double>(other.m_count);
+            const double delta = other.m_mean - m_mean;
+            m_mean += delta * n_b / (n_a + n_b);
+            m_m2 += other.m_m2 + delta * delta * n_a * n_b / (n_a + n_b);
+            m_count += other.m_count;
+            m_max = std::max(m_max, other.m_max);
+            for (auto k = 0u; k < loss_lanes; ++k)
+            {
+                m_lanes[k].add(other.m_lanes[k].m_sum);
+                m_lanes[k].add(other.m_lanes[k].m_c);
+            }
+        }
+
+        double sum() const
+        {
+            compensated_sum retval;
+            for (auto k = 0u; k < loss_lanes; ++k)
+            {
+                retval.add(m_lanes[k].m_sum);
+                retval.add(m_lanes[k].m_c);
+            }
+            return retval.value();
+        }
+
+        std::size_t m_count;
+        std::size_t m_non_finite;
+        unsigned int m_lane;
+        compensated_sum m_lanes[loss_lanes];
+        double m_max;
+        double m_mean;
+        double m_m2;
+    };
+
+    /// Evaluates the expression on the points [begin, end) and reduces the errors of each output
+    void reduce_loss(const expression& ex, const dataset& data, std::size_t begin, std::size_t end, loss_type type, std::vector<loss_accumulator>& acc)
+    {
+        std::vector<double> in(data.get_n());
+        std::vector<double> out_real(data.get_m());
+        workspace ws;
+        for (auto i = begin; i < end; ++i)
+        {
+            strided_view point = data.row(i);
+            for (auto j = 0u; j < in.size(); ++j)
+            {
+                in[j] = point[j];
+            }
+            ex.eval_into(in.data(), out_real.data(), ws);
+            for (auto j = 0u; j < out_real.size(); ++j)
+            {
+                // a non finite output is the worst error: it is only counted, and makes the whole loss non finite
+                if (std::isfinite(out_real[j]))
+                {
+                    const double y = point[data.get_n() + j];
+                    acc[j].add(y - out_real[j], y, type);
+                }
+                else
+                {
+                    ++acc[j].m_non_finite;
+                }
+            }
+        }
+    }
+}
+
     /// Computes the error of the expression in approximating some given data
     double simple_data_fit(const expression& ex, 
         const std::vector<std::vector<double> >& in_des, 
@@ -13,6 +162,7 @@ namespace dcgp {
         fitness_type type,
         double tol) 
     {
+        DCGP_TIME_SCOPE(TIME_FITNESS);
         double retval = 0.;
         std::vector<double> out_real;
 
@@ -24,26 +174,428 @@ namespace dcgp {
         for (auto i = 0u; i < in_des.size(); ++i)
         {
             out_real = ex(in_des[i]);
-            if (type == fitness_type::ERROR_BASED)
+            retval += point_fit(out_real, out_des[i], type, tol);
+        }
+
+        return retval;
+    }
+
+    /// Computes the error of the expression in approximating the points of a dataset
+    double simple_data_fit(const expression& ex, 
+        const dataset& data, 
+        fitness_type type,
+        double tol) 
+    {
+        DCGP_TIME_SCOPE(TIME_FITNESS);
+        double retval = 0.;
+        std::vector<double> in(data.get_n());
+        std::vector<double> out_real(data.get_m());
+        workspace ws;
+
+        if (data.get_n() != ex.get_n() || data.get_m() != ex.get_m())
+        {
+            throw input_error("Dataset is incompatible with the expression inputs and outputs");
+        }
+
+        for (auto i = 0u; i < data.rows(); ++i)
+        {
+            strided_view point = data.row(i);
+            for (auto j = 0u; j < in.size(); ++j)
+            {
+                in[j] = point[j];
+            }
+            ex.eval_into(in.data(), out_real.data(), ws);
+            retval += point_fit(out_real, strided_view(point.data() + data.get_n() * point.stride(), data.get_m(), point.stride()), type, tol);
+        }
+
+        return retval;
+    }
+
+    /// Computes the error of the expression in approximating the points of a dataset having the given indices
+    /**
+     * Same as the whole-dataset version, restricted to a subset of its points (e.g. a subsample).
+     *
+     * \param[in] ex the expression
+     * \param[in] data the dataset
+     * \param[in] indices indices of the points to be used
+     * \param[in] count number of indices
+     * \param[in] type the fitness type
+     * \param[in] tol the tolerance for HITS_BASED fitness
+     *
+     * \return the fitness of the expression on the selected points
+     *
+     * @throw dcgp::input_error if the dataset is incompatible with the expression or an index is out of range
+     */
+    double simple_data_fit(const expression& ex, 
+        const dataset& data, 
+        const std::size_t *indices,
+        std::size_t count,
+        fitness_type type,
+        double tol) 
+    {
+        DCGP_TIME_SCOPE(TIME_FITNESS);
+        double retval = 0.;
+        std::vector<double> in(data.get_n());
+        std::vector<double> out_real(data.get_m());
+        workspace ws;
+
+        if (data.get_n() != ex.get_n() || data.get_m() != ex.get_m())
+        {
+            throw input_error("Dataset is incompatible with the expression inputs and outputs");
+        }
+
+        for (auto k = 0u; k < count; ++k)
+        {
+            if (indices[k] >= data.rows())
+            {
+                throw input_error("Point index out of range");
+            }
+            strided_view point = data.row(indices[k]);
+            for (auto j = 0u; j < in.size(); ++j)
             {
-                for (auto j = 0u; j < out_real.size(); ++j)
+                in[j] = point[j];
+            }
+            ex.eval_into(in.data(), out_real.data(), ws);
+            retval += point_fit(out_real, strided_view(point.data() + data.get_n() * point.stride(), data.get_m(), point.stride()), type, tol);
+        }
+
+        return retval;
+    }
+
+    /// Computes the enclosure of the inputs of a dataset
+    /**
+     * \param[in] data the dataset
+     *
+     * \return for each input, the set of its values (see dcgp::interval), infinities and NaN included
+     */
+    std::vector<interval> input_box(const dataset& data)
+    {
+        std::vector<interval> retval(data.get_n());
+        for (auto j = 0u; j < data.get_n(); ++j)
+        {
+            const strided_view column = data.column(j);
+            for (auto i = 0u; i < data.rows(); ++i)
+            {
+                retval[j].add(column[i]);
+            }
+        }
+        return retval;
+    }
+
+    /// Checks, by interval arithmetic, whether no output of the expression can be finite on a box of inputs
+    /**
+     * The expression is evaluated once on intervals (see dcgp::interval). A true answer is a proof: on every point
+     * of the box, every output is infinite or NaN, so that its fitness (see dcgp::simple_data_fit) is zero. A false
+     * answer proves nothing, the enclosures being conservative.
+     *
+     * \param[in] ex the expression
+     * \param[in] box the inputs, e.g. dcgp::input_box of a dataset
+     *
+     * \return true if no output can be finite
+     *
+     * @throw dcgp::input_error if the box size is incompatible with the expression inputs
+     */
+    bool nowhere_finite(const expression& ex, const std::vector<interval>& box)
+    {
+        for (const auto &out : ex(box))
+        {
+            if (out.has_finite()) return false;
+        }
+        return true;
+    }
+
+    /// Computes the error of the expression in approximating the points of a dataset, unless it is nowhere finite on their box
+    /**
+     * Pre-screened version of the dataset dcgp::simple_data_fit: if dcgp::nowhere_finite proves that no output can be
+     * finite on the box, the fitness is zero (non finite outputs being ignored) and the dataset is not read,
+     * otherwise the fitness is computed as usual. Either way the result is the same as without pre-screening.
+     *
+     * \param[in] ex the expression
+     * \param[in] data the dataset
+     * \param[in] box an enclosure of the inputs of the dataset (see dcgp::input_box), computed once for all expressions
+     * \param[in] type the fitness type
+     * \param[in] tol the tolerance for HITS_BASED fitness
+     *
+     * \return the fitness of the expression
+     *
+     * @throw dcgp::input_error if the dataset or the box are incompatible with the expression
+     */
+    double simple_data_fit(const expression& ex,
+        const dataset& data,
+        const std::vector<interval>& box,
+        fitness_type type,
+        double tol)
+    {
+        if (data.get_n() != ex.get_n() || data.get_m() != ex.get_m())
+        {
+            throw input_error("Dataset is incompatible with the expression inputs and outputs");
+        }
+        if (nowhere_finite(ex, box))
+        {
+            return 0.;
+        }
+        return simple_data_fit(ex, data, type, tol);
+    }
+
+    /// Computes the error of the expression in approximating the points of the dataset of a semantic cache
+    /**
+     * Same as the dataset version, with the values of the nodes found in (or added to) the cache
+     * (see dcgp::semantic_cache), so that the sub-expressions shared with the expressions evaluated before are not
+     * computed again.
+     *
+     * \param[in] ex the expression
+     * \param[in] cache the cache, holding the dataset
+     * \param[in] type the fitness type
+     * \param[in] tol the tolerance for HITS_BASED fitness
+     *
+     * \return the fitness of the expression
+     *
+     * @throw dcgp::input_error if the dataset is incompatible with the expression
+     */
+    double simple_data_fit(const expression& ex,
+        semantic_cache& cache,
+        fitness_type type,
+        double tol)
+    {
+        DCGP_TIME_SCOPE(TIME_FITNESS);
+        const dataset& data = cache.get_data();
+        if (data.get_n() != ex.get_n() || data.get_m() != ex.get_m())
+        {
+            throw input_error("Dataset is incompatible with the expression inputs and outputs");
+        }
+        const std::vector<semantic_cache::column> columns = cache.evaluate(ex);
+        double retval = 0.;
+        std::vector<double> out_real(data.get_m());
+        for (auto i = 0u; i < data.rows(); ++i)
+        {
+            for (auto j = 0u; j < out_real.size(); ++j)
+            {
+                out_real[j] = (*columns[j])[i];
+            }
+            strided_view point = data.row(i);
+            retval += point_fit(out_real, strided_view(point.data() + data.get_n() * point.stride(), data.get_m(), point.stride()), type, tol);
+        }
+        return retval;
+    }
+
+    /// Computes a loss of the expression on the points of a dataset, in one single pass
+    /**
+     * Each point is evaluated and its errors are immediately accumulated, so that the outputs are
+     * never stored and the data are read only once. The sums are compensated (Kahan-Babuska-Neumaier)
+     * and spread over several independent lanes, and the threads reduce disjoint blocks of points
+     * whose partial results are merged at the end, so that the loss stays accurate on very large datasets.
+     *
+     * Unlike dcgp::simple_data_fit, which ignores them, non finite outputs are the worst possible errors: the loss is
+     * +inf (-inf for R2) as soon as one output is not finite, so that a candidate which is mostly NaN can never
+     * beat a finite one. The loss is also +inf (-inf for R2) on an empty dataset.
+     * For R2, if the targets are constant the loss is 1 when they are all matched exactly, 0 otherwise.
+     *
+     * \param[in] ex the expression
+     * \param[in] data the dataset
+     * \param[in] type the loss type
+     * \param[in] n_threads number of threads
+     *
+     * \return the loss (to be minimized, except R2 which is to be maximized)
+     *
+     * @throw dcgp::input_error if the dataset is incompatible with the expression or n_threads is zero
+     */
+    double data_loss(const expression& ex,
+        const dataset& data,
+        loss_type type,
+        unsigned int n_threads)
+    {
+        if (data.get_n() != ex.get_n() || data.get_m() != ex.get_m())
+        {
+            throw input_error("Dataset is incompatible with the expression inputs and outputs");
+        }
+        if (n_threads == 0u)
+        {
+            throw input_error("Number of threads must be at least 1");
+        }
+        n_threads = static_cast<unsigned int>(std::min<std::size_t>(n_threads, std::max<std::size_t>(data.rows(), 1u)));
+
+        std::vector<std::vector<loss_accumulator> > partial(n_threads, std::vector<loss_accumulator>(data.get_m()));
+        std::vector<std::thread> threads;
+        for (auto t = 1u; t < n_threads; ++t)
+        {
+            threads.emplace_back(reduce_loss, std::cref(ex), std::cref(data), data.rows() * t / n_threads, data.rows() * (t + 1u) / n_threads, type, std::ref(partial[t]));
+        }
+        reduce_loss(ex, data, 0u, data.rows() / n_threads, type, partial[0]);
+        for (auto &th : threads)
+        {
+            th.join();
+        }
+
+        loss_accumulator total;
+        compensated_sum sum, m2;
+        for (auto j = 0u; j < data.get_m(); ++j)
+        {
+            for (auto t = 1u; t < n_threads; ++t)
+            {
+                partial[0][j].merge(partial[t][j]);
+            }
+            total.m_count += partial[0][j].m_count;
+            total.m_non_finite += partial[0][j].m_non_finite;
+            total.m_max = std::max(total.m_max, partial[0][j].m_max);
+            sum.add(partial[0][j].sum());
+            m2.add(partial[0][j].m_m2);
+        }
+        if (total.m_count == 0u || total.m_non_finite > 0u)
+        {
+            return (type == R2) ? -std::numeric_limits<double>::infinity() : std::numeric_limits<double>::infinity();
+        }
+        const double count = static_cast<double>(total.m_count);
+        switch (type)
+        {
+            case MSE:
+                return sum.value() / count;
+            case RMSE:
+                return std::sqrt(sum.value() / count);
+            case MAE:
+                return sum.value() / count;
+            case MAX_ERROR:
+                return total.m_max;
+            case R2:
+                if (m2.value() == 0.)
                 {
-                    if (std::isfinite(out_real[j]))
-                    {
-                        retval += 1.0 / (1.0 + fabs(out_des[i][j] - out_real[j]));
-                    }
+                    return (sum.value() == 0.) ? 1. : 0.;
+                }
+                return 1. - sum.value() / m2.value();
+        }
+        return 0.;
+    }
+
+    /// Computes the fitness of several expressions on the points streamed, chunk by chunk, from a source
+    /**
+     * The source is rewound and read to its end by a background thread into two chunk buffers, alternately:
+     * while the candidates are evaluated on one chunk the next one is being read into the other, so that
+     * only two chunks are ever held in memory and reading overlaps with evaluation. Each pass over
+     * the source evaluates all the candidates, so that batching candidates amortises the reads.
+     *
+     * The fitness of each candidate is the same as dcgp::simple_data_fit on the whole sequence of points.
+     *
+     * \param[in] candidates the expressions (all with the inputs and outputs of the source)
+     * \param[in] source the source of the points
+     * \param[in] chunk_rows number of points per chunk
+     * \param[in] type the fitness type
+     * \param[in] tol the tolerance for HITS_BASED fitness
+     *
+     * \return the fitness of each candidate
+     *
+     * @throw dcgp::input_error if chunk_rows is zero or a candidate is incompatible with the source, or any error of the source
+     */
+    std::vector<double> streaming_data_fit(const std::vector<expression>& candidates,
+        chunk_source& source,
+        std::size_t chunk_rows,
+        fitness_type type,
+        double tol)
+    {
+        if (chunk_rows == 0u)
+        {
+            throw input_error("Chunks must contain at least one point");
+        }
+        for (const auto &ex : candidates)
+        {
+            if (ex.get_n() != source.get_n() || ex.get_m() != source.get_m())
+            {
+                throw input_error("Source is incompatible with the expression inputs and outputs");
+            }
+        }
+        std::vector<double> retval(candidates.size(), 0.);
+
+        dataset buffers[2] = {dataset(chunk_rows, source.get_n(), source.get_m()), dataset(chunk_rows, source.get_n(), source.get_m())};
+        // number of points in each buffer, valid when the buffer is full
+        std::size_t counts[2] = {0u, 0u};
+        bool full[2] = {false, false};
+        bool stop = false;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable cv;
+
+        source.rewind();
+        std::thread reader([&]() {
+            for (auto k = 0u; ; k = 1u - k)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [&]() {return !full[k] || stop;});
+                    if (stop) return;
+                }
+                std::size_t count = 0u;
+                try {
+                    count = source.read(buffers[k]);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    error = std::current_exception();
                 }
-            } else if (type == fitness_type::HITS_BASED){
-                for (auto j = 0u; j < out_real.size(); ++j)
                 {
-                    if (std::isfinite(out_real[j]))
-                    {
-                        if (fabs(out_des[i][j] - out_real[j]) < tol) retval += 1.0;
-                    }
+                    std::lock_guard<std::mutex> lock(mutex);
+                    counts[k] = error ? 0u : count;
+                    full[k] = true;
                 }
+                cv.notify_all();
+                if (count == 0u || error) return;
             }
-        }
+        });
 
+        try {
+            for (auto k = 0u; ; k = 1u - k)
+            {
+                std::size_t count;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [&]() {return full[k];});
+                    count = counts[k];
+                }
+                if (count == 0u) break;
+                dataset chunk = buffers[k].slice(0u, count);
+                for (auto c = 0u; c < candidates.size(); ++c)
+                {
+                    retval[c] += simple_data_fit(candidates[c], chunk, type, tol);
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    full[k] = false;
+                }
+                cv.notify_all();
+            }
+        } catch (...) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stop = true;
+            }
+            cv.notify_all();
+            reader.join();
+            throw;
+        }
+        reader.join();
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
         return retval;
     }
+
+    /// Computes the fitness of an expression on the points streamed, chunk by chunk, from a source
+    /**
+     * See the overload for several candidates.
+     *
+     * \param[in] ex the expression
+     * \param[in] source the source of the points
+     * \param[in] chunk_rows number of points per chunk
+     * \param[in] type the fitness type
+     * \param[in] tol the tolerance for HITS_BASED fitness
+     *
+     * \return the fitness of the expression
+     *
+     * @throw dcgp::input_error if chunk_rows is zero or the expression is incompatible with the source, or any error of the source
+     */
+    double streaming_data_fit(const expression& ex,
+        chunk_source& source,
+        std::size_t chunk_rows,
+        fitness_type type,
+        double tol)
+    {
+        return streaming_data_fit(std::vector<expression>(1u, ex), source, chunk_rows, type, tol)[0];
+    }
 }
@@ -1,5 +1,13 @@
+#ifndef DCGP_FITNESS_FUNCTIONS_H
+#define DCGP_FITNESS_FUNCTIONS_H
+
+#include <functional>
 #include <vector>
+#include "dataset.h"
+#include "dataset_io.h"
 #include "expression.h"
+#include "interval.h"
+#include "semantic_cache.h"
 
 namespace dcgp {
     enum fitness_type { 
@@ -7,10 +15,76 @@ namespace dcgp {
         HITS_BASED      // fitness is the number of components across the output data which are within a tolerance
         };   
 
+    enum loss_type {
+        MSE,            // mean of err_ij^2
+        RMSE,           // square root of the MSE
+        MAE,            // mean of |err_ij|
+        MAX_ERROR,      // max of |err_ij|
+        R2              // coefficient of determination 1 - sum_ij err_ij^2 / sum_ij (y_ij - mean_i(y_ij))^2 (to be maximized)
+        };
+
+    /// The fitness of an expression (to be maximized) as used by the evolution drivers. Must be safe to call concurrently.
+    using fitness_function = std::function<double(const expression&)>;
+
     /// Computes the error of the expression in approximating some given data
     double simple_data_fit(const dcgp::expression& ex, 
         const std::vector<std::vector<double> >& in_des, 
         const std::vector<std::vector<double> >& out_des, 
         fitness_type type = fitness_type::ERROR_BASED,
         double tol = 1e-10);
+
+    /// Computes the error of the expression in approximating the points of a dataset
+    double simple_data_fit(const dcgp::expression& ex, 
+        const dcgp::dataset& data, 
+        fitness_type type = fitness_type::ERROR_BASED,
+        double tol = 1e-10);
+
+    /// Computes the error of the expression in approximating the points of a dataset having the given indices
+    double simple_data_fit(const dcgp::expression& ex, 
+        const dcgp::dataset& data, 
+        const std::size_t *indices,
+        std::size_t count,
+        fitness_type type = fitness_type::ERROR_BASED,
+        double tol = 1e-10);
+
+    /// Computes the enclosure of the inputs of a dataset
+    std::vector<dcgp::interval> input_box(const dcgp::dataset& data);
+
+    /// Checks, by interval arithmetic, whether no output of the expression can be finite on a box of inputs
+    bool nowhere_finite(const dcgp::expression& ex, const std::vector<dcgp::interval>& box);
+
+    /// Computes the error of the expression in approximating the points of a dataset, unless it is nowhere finite on their box
+    double simple_data_fit(const dcgp::expression& ex,
+        const dcgp::dataset& data,
+        const std::vector<dcgp::interval>& box,
+        fitness_type type = fitness_type::ERROR_BASED,
+        double tol = 1e-10);
+
+    /// Computes the error of the expression in approximating the points of the dataset of a semantic cache
+    double simple_data_fit(const dcgp::expression& ex,
+        dcgp::semantic_cache& cache,
+        fitness_type type = fitness_type::ERROR_BASED,
+        double tol = 1e-10);
+
+    /// Computes a loss of the expression on the points of a dataset, in one single pass
+    double data_loss(const dcgp::expression& ex,
+        const dcgp::dataset& data,
+        loss_type type = loss_type::MSE,
+        unsigned int n_threads = 1u);
+
+    /// Computes the fitness of several expressions on the points streamed, chunk by chunk, from a source
+    std::vector<double> streaming_data_fit(const std::vector<dcgp::expression>& candidates,
+        dcgp::chunk_source& source,
+        std::size_t chunk_rows = 65536u,
+        fitness_type type = fitness_type::ERROR_BASED,
+        double tol = 1e-10);
+
+    /// Computes the fitness of an expression on the points streamed, chunk by chunk, from a source
+    double streaming_data_fit(const dcgp::expression& ex,
+        dcgp::chunk_source& source,
+        std::size_t chunk_rows = 65536u,
+        fitness_type type = fitness_type::ERROR_BASED,
+        double tol = 1e-10);
 }
+
+#endif // DCGP_FITNESS_FUNCTIONS_H
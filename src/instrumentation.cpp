@@ -0,0 +1,286 @@
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <sstream>
+
+#include "expression.h"
+#include "instrumentation.h"
+
+namespace dcgp {
+
+namespace {
+const char *counter_names[N_INSTRUMENTATION_COUNTERS] = {"evaluations", "differentiations", "mutations", "active_updates", "fitness_points", "non_finite_outputs", "allocations"};
+const char *node_op_names[N_INSTRUMENTATION_NODE_OPS] = {"sum", "diff", "mul", "div", "pow", "sqrt", "other"};
+const char *timer_names[N_INSTRUMENTATION_TIMERS] = {"evaluation", "differentiation", "update_active", "mutation", "fitness"};
+
+// The counters of one thread. Only the owning thread writes them, other threads read them when taking a snapshot
+struct thread_counters
+{
+    std::atomic<unsigned long long> m_counters[N_INSTRUMENTATION_COUNTERS];
+    std::atomic<unsigned long long> m_node_ops[N_INSTRUMENTATION_NODE_OPS];
+    std::atomic<unsigned long long> m_active_sizes[instrumentation_active_buckets];
+    std::atomic<unsigned long long> m_timer_calls[N_INSTRUMENTATION_TIMERS];
+    std::atomic<unsigned long long> m_timer_ns[N_INSTRUMENTATION_TIMERS];
+};
+
+// Single writer: a relaxed load and store, no locked instruction
+inline void bump(std::atomic<unsigned long long>& a, unsigned long long n)
+{
+    a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+template <std::size_t N>
+void add_to(unsigned long long (&to)[N], std::atomic<unsigned long long> (&from)[N], bool clear)
+{
+    for (auto k = 0u; k < N; ++k)
+    {
+        to[k] += clear ? from[k].exchange(0u, std::memory_order_relaxed) : from[k].load(std::memory_order_relaxed);
+    }
+}
+
+void add_to(instrumentation_snapshot& to, thread_counters& from, bool clear)
+{
+    add_to(to.m_counters, from.m_counters, clear);
+    add_to(to.m_node_ops, from.m_node_ops, clear);
+    add_to(to.m_active_sizes, from.m_active_sizes, clear);
+    add_to(to.m_timer_calls, from.m_timer_calls, clear);
+    add_to(to.m_timer_ns, from.m_timer_ns, clear);
+}
+
+// The counters of the live threads, and the sum of those of the exited threads
+struct registry
+{
+    std::mutex m_mutex;
+    std::vector<thread_counters*> m_threads;
+    instrumentation_snapshot m_exited;
+};
+
+registry& get_registry()
+{
+    static registry r;
+    return r;
+}
+
+// Registers the counters of a thread for its lifetime
+struct thread_handle
+{
+    thread_handle()
+    {
+        for (auto &c : m_counters.m_counters) c.store(0u);
+        for (auto &c : m_counters.m_node_ops) c.store(0u);
+        for (auto &c : m_counters.m_active_sizes) c.store(0u);
+        for (auto &c : m_counters.m_timer_calls) c.store(0u);
+        for (auto &c : m_counters.m_timer_ns) c.store(0u);
+        registry& r = get_registry();
+        std::lock_guard<std::mutex> lock(r.m_mutex);
+        r.m_threads.push_back(&m_counters);
+    }
+    ~thread_handle()
+    {
+        registry& r = get_registry();
+        std::lock_guard<std::mutex> lock(r.m_mutex);
+        add_to(r.m_exited, m_counters, false);
+        r.m_threads.erase(std::find(r.m_threads.begin(), r.m_threads.end(), &m_counters));
+    }
+    thread_counters m_counters;
+};
+
+thread_counters& local()
+{
+    static thread_local thread_handle handle;
+    return handle.m_counters;
+}
+
+}
+
+instrumentation_snapshot::instrumentation_snapshot() : m_enabled(instrumentation_enabled()), m_counters(), m_node_ops(), m_active_sizes(), m_timer_calls(), m_timer_ns() {}
+
+/// Renders the snapshot as text
+/**
+ * \return one line per non-zero value, e.g. "evaluations: 1000"
+ */
+std::string instrumentation_snapshot::to_text() const
+{
+    std::ostringstream os;
+    os << "instrumentation: " << (m_enabled ? "enabled" : "disabled") << "\n";
+    for (auto k = 0u; k < N_INSTRUMENTATION_COUNTERS; ++k)
+    {
+        if (m_counters[k]) os << counter_names[k] << ": " << m_counters[k] << "\n";
+    }
+    for (auto k = 0u; k < N_INSTRUMENTATION_NODE_OPS; ++k)
+    {
+        if (m_node_ops[k]) os << "node ops " << node_op_names[k] << ": " << m_node_ops[k] << "\n";
+    }
+    for (auto k = 0u; k < instrumentation_active_buckets; ++k)
+    {
+        if (!m_active_sizes[k]) continue;
+        os << "active size " << ((k == 0u) ? 0u : (1u << (k - 1u)));
+        if (k + 1u < instrumentation_active_buckets) os << "-" << (1u << k) - 1u;
+        else os << "+";
+        os << ": " << m_active_sizes[k] << "\n";
+    }
+    for (auto k = 0u; k < N_INSTRUMENTATION_TIMERS; ++k)
+    {
+        if (m_timer_calls[k]) os << "time " << timer_names[k] << ": " << static_cast<double>(m_timer_ns[k]) * 1e-9 << " s in " << m_timer_calls[k] << " calls\n";
+    }
+    return os.str();
+}
+
+/// Renders the snapshot as JSON
+/**
+ * \return a JSON object with the members "enabled", "counters", "node_ops", "active_sizes" (the histogram buckets) and
+ * "timers" (calls and nanoseconds)
+ */
+std::string instrumentation_snapshot::to_json() const
+{
+    std::ostringstream os;
+    os << "{\"enabled\": " << (m_enabled ? "true" : "false") << ", \"counters\": {";
+    for (auto k = 0u; k < N_INSTRUMENTATION_COUNTERS; ++k)
+    {
+        os << (k ? ", " : "") << "\"" << counter_names[k] << "\": " << m_counters[k];
+    }
+    os << "}, \"node_ops\": {";
+    for (auto k = 0u; k < N_INSTRUMENTATION_NODE_OPS; ++k)
+    {
+        os << (k ? ", " : "") << "\"" << node_op_names[k] << "\": " << m_node_ops[k];
+    }
+    os << "}, \"active_sizes\": [";
+    for (auto k = 0u; k < instrumentation_active_buckets; ++k)
+    {
+        os << (k ? ", " : "") << m_active_sizes[k];
+    }
+    os << "], \"timers\": {";
+    for (auto k = 0u; k < N_INSTRUMENTATION_TIMERS; ++k)
+    {
+        os << (k ? ", " : "") << "\"" << timer_names[k] << "\": {\"calls\": " << m_timer_calls[k] << ", \"ns\": " << m_timer_ns[k] << "}";
+    }
+    os << "}}";
+    return os.str();
+}
+
+/// Checks whether the library was built with the instrumentation
+/**
+ * \return true if the library was built with DCGP_ENABLE_INSTRUMENTATION (CMake option ENABLE_INSTRUMENTATION),
+ * otherwise the counters stay at zero
+ */
+bool instrumentation_enabled()
+{
+#ifdef DCGP_ENABLE_INSTRUMENTATION
+    return true;
+#else
+    return false;
+#endif
+}
+
+/// Merges the counters of all threads (also those which have exited)
+/**
+ * The counters are read while the other threads keep updating them, so that a snapshot taken during a run is
+ * not an atomic picture of all counters, but each value is exact at some point in time.
+ *
+ * \return the snapshot
+ */
+instrumentation_snapshot get_instrumentation()
+{
+    registry& r = get_registry();
+    std::lock_guard<std::mutex> lock(r.m_mutex);
+    instrumentation_snapshot retval(r.m_exited);
+    for (auto t : r.m_threads)
+    {
+        add_to(retval, *t, false);
+    }
+    return retval;
+}
+
+/// Sets all the counters to zero
+/**
+ * Should be called while no other thread runs instrumented code, otherwise some of their counts may survive the reset.
+ */
+void reset_instrumentation()
+{
+    registry& r = get_registry();
+    std::lock_guard<std::mutex> lock(r.m_mutex);
+    r.m_exited = instrumentation_snapshot();
+    instrumentation_snapshot discarded;
+    for (auto t : r.m_threads)
+    {
+        add_to(discarded, *t, true);
+    }
+}
+
+/// Adds to a counter of the calling thread
+void instrument_count(instrumentation_counter counter, unsigned long long n)
+{
+    bump(local().m_counters[counter], n);
+}
+
+/// Gets the node operation counting the evaluations of a basis function
+/**
+ * Resolved once per function by dcgp::expression_topology, so that evaluations do not compare names.
+ *
+ * \param[in] name the name of the function
+ *
+ * \return the node operation, NODE_OTHER for the functions not counted separately
+ */
+instrumentation_node_op instrument_node_op(const std::string& name)
+{
+    if (name == "sum") return NODE_SUM;
+    if (name == "diff") return NODE_DIFF;
+    if (name == "mul") return NODE_MUL;
+    if (name == "div") return NODE_DIV;
+    if (name == "pow") return NODE_POW;
+    if (name == "sqrt") return NODE_SQRT;
+    return NODE_OTHER;
+}
+
+/// Records one evaluation of an expression, and its node operations, in the counters of the calling thread
+void instrument_evaluation(const expression& ex)
+{
+    thread_counters& c = local();
+    bump(c.m_counters[COUNT_EVALUATIONS], 1u);
+    const std::vector<unsigned int>& x = ex.get();
+    const std::vector<instrumentation_node_op>& ops = ex.get_topology()->get_node_ops();
+    for (auto i : ex.get_active_nodes())
+    {
+        if (i >= ex.get_n()) bump(c.m_node_ops[ops[x[(i - ex.get_n()) * 3u]]], 1u);
+    }
+}
+
+/// Records one evaluation of some of the outputs of an expression, and the node operations it computed
+/**
+ * \param[in] ex the expression
+ * \param[in] stamps the evaluation which last computed each node
+ * \param[in] stamp the evaluation
+ */
+void instrument_evaluation(const expression& ex, const unsigned long *stamps, unsigned long stamp)
+{
+    thread_counters& c = local();
+    bump(c.m_counters[COUNT_EVALUATIONS], 1u);
+    const std::vector<unsigned int>& x = ex.get();
+    const std::vector<instrumentation_node_op>& ops = ex.get_topology()->get_node_ops();
+    for (auto i : ex.get_active_nodes())
+    {
+        if (i >= ex.get_n() && stamps[i] == stamp) bump(c.m_node_ops[ops[x[(i - ex.get_n()) * 3u]]], 1u);
+    }
+}
+
+/// Records the number of active nodes in the histogram of the calling thread
+void instrument_active_size(std::size_t size)
+{
+    unsigned int bucket = 0u;
+    while (size > 0u && bucket + 1u < instrumentation_active_buckets)
+    {
+        size >>= 1u;
+        ++bucket;
+    }
+    bump(local().m_active_sizes[bucket], 1u);
+}
+
+/// Adds a duration to a timer of the calling thread
+void instrument_time(instrumentation_timer timer, unsigned long long ns)
+{
+    thread_counters& c = local();
+    bump(c.m_timer_calls[timer], 1u);
+    bump(c.m_timer_ns[timer], ns);
+}
+
+} // end of namespace dcgp
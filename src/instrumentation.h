@@ -0,0 +1,110 @@
+#ifndef DCGP_INSTRUMENTATION_H
+#define DCGP_INSTRUMENTATION_H
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace dcgp {
+
+class expression;
+
+enum instrumentation_counter {
+    COUNT_EVALUATIONS,          // evaluations of an expression on one point
+    COUNT_DIFFERENTIATIONS,     // computations of the derivatives of an expression on one point
+    COUNT_MUTATIONS,            // active mutations
+    COUNT_ACTIVE_UPDATES,       // recomputations of the active nodes and genes
+    COUNT_FITNESS_POINTS,       // points evaluated by dcgp::simple_data_fit
+    COUNT_NON_FINITE_OUTPUTS,   // NaN or infinite outputs met by dcgp::simple_data_fit
+    COUNT_ALLOCATIONS,          // calls of the allocating evaluation APIs and growths of a dcgp::workspace
+    N_INSTRUMENTATION_COUNTERS
+    };
+
+enum instrumentation_node_op {
+    NODE_SUM,
+    NODE_DIFF,
+    NODE_MUL,
+    NODE_DIV,
+    NODE_POW,
+    NODE_SQRT,
+    NODE_OTHER,                 // any other basis function
+    N_INSTRUMENTATION_NODE_OPS
+    };
+
+enum instrumentation_timer {
+    TIME_EVALUATION,            // dcgp::expression::operator() and dcgp::expression::eval_into
+    TIME_DIFFERENTIATION,       // dcgp::expression::differentiate and dcgp::expression::differentiate_into
+    TIME_UPDATE_ACTIVE,         // recomputation of the active nodes and genes
+    TIME_MUTATION,              // dcgp::expression::mutate_active (including the update of the active nodes)
+    TIME_FITNESS,               // dcgp::simple_data_fit
+    N_INSTRUMENTATION_TIMERS
+    };
+
+/// Number of buckets of the histogram of the active sizes: bucket k counts the sizes in [2^(k-1), 2^k), the last one all the larger sizes
+const unsigned int instrumentation_active_buckets = 17u;
+
+/// Merged values of the instrumentation counters of all threads
+struct instrumentation_snapshot
+{
+    instrumentation_snapshot();
+
+    std::string to_text() const;
+    std::string to_json() const;
+
+    /// Whether the library was built with the instrumentation (DCGP_ENABLE_INSTRUMENTATION)
+    bool m_enabled;
+    unsigned long long m_counters[N_INSTRUMENTATION_COUNTERS];
+    /// Node operations evaluated, by function
+    unsigned long long m_node_ops[N_INSTRUMENTATION_NODE_OPS];
+    /// Histogram of the number of active nodes (inputs included), recorded at each update of the active nodes
+    unsigned long long m_active_sizes[instrumentation_active_buckets];
+    /// Number of scopes timed and their cumulated duration (in nanoseconds)
+    unsigned long long m_timer_calls[N_INSTRUMENTATION_TIMERS];
+    unsigned long long m_timer_ns[N_INSTRUMENTATION_TIMERS];
+};
+
+/// Checks whether the library was built with the instrumentation
+bool instrumentation_enabled();
+/// Merges the counters of all threads (also those which have exited)
+instrumentation_snapshot get_instrumentation();
+/// Sets all the counters to zero
+void reset_instrumentation();
+
+void instrument_count(instrumentation_counter counter, unsigned long long n = 1u);
+instrumentation_node_op instrument_node_op(const std::string& name);
+void instrument_evaluation(const expression& ex);
+void instrument_evaluation(const expression& ex, const unsigned long *stamps, unsigned long stamp);
+void instrument_active_size(std::size_t size);
+void instrument_time(instrumentation_timer timer, unsigned long long ns);
+
+/// Adds the duration of a scope to a timer
+class instrumentation_scoped_timer {
+public:
+    explicit instrumentation_scoped_timer(instrumentation_timer timer) : m_timer(timer), m_begin(std::chrono::steady_clock::now()) {};
+    ~instrumentation_scoped_timer()
+    {
+        instrument_time(m_timer, static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_begin).count()));
+    }
+    instrumentation_scoped_timer(const instrumentation_scoped_timer&) = delete;
+    instrumentation_scoped_timer& operator=(const instrumentation_scoped_timer&) = delete;
+
+private:
+    instrumentation_timer m_timer;
+    std::chrono::steady_clock::time_point m_begin;
+};
+
+} // end of namespace dcgp
+
+// The hot paths are instrumented through these macros, which compile to nothing unless DCGP_ENABLE_INSTRUMENTATION is defined
+#ifdef DCGP_ENABLE_INSTRUMENTATION
+#define DCGP_INSTRUMENT(statement) statement
+#define DCGP_COUNT(counter, n) ::dcgp::instrument_count(::dcgp::counter, n)
+#define DCGP_TIME_SCOPE(timer) ::dcgp::instrumentation_scoped_timer dcgp_scoped_timer_(::dcgp::timer)
+#else
+#define DCGP_INSTRUMENT(statement)
+#define DCGP_COUNT(counter, n)
+#define DCGP_TIME_SCOPE(timer)
+#endif
+
+#endif // DCGP_INSTRUMENTATION_H
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "interval.h"
+
+namespace dcgp {
+
+interval::interval() : m_lo(std::numeric_limits<double>::infinity()), m_hi(-std::numeric_limits<double>::infinity()), m_neg_inf(false), m_pos_inf(false), m_nan(false) {}
+
+interval::interval(double v) : interval()
+{
+    add(v);
+}
+
+interval::interval(double lo, double hi) : interval()
+{
+    add_range(lo, hi);
+}
+
+interval interval::entire()
+{
+    interval retval(-std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity());
+    retval.m_nan = true;
+    return retval;
+}
+
+/// Checks whether the set contains a value
+/**
+ * \param[in] v the value (possibly infinite or NaN)
+ *
+ * \return true if v may be taken
+ */
+bool interval::contains(double v) const
+{
+    if (std::isnan(v)) return m_nan;
+    if (v == -std::numeric_limits<double>::infinity()) return m_neg_inf;
+    if (v == std::numeric_limits<double>::infinity()) return m_pos_inf;
+    return m_lo <= v && v <= m_hi;
+}
+
+/// Adds a value
+/**
+ * \param[in] v the value (possibly infinite or NaN)
+ */
+void interval::add(double v)
+{
+    if (std::isnan(v)) {
+        m_nan = true;
+    } else if (v == -std::numeric_limits<double>::infinity()) {
+        m_neg_inf = true;
+    } else if (v == std::numeric_limits<double>::infinity()) {
+        m_pos_inf = true;
+    } else {
+        m_lo = std::min(m_lo, v);
+        m_hi = std::max(m_hi, v);
+    }
+}
+
+/// Adds all the values between two bounds
+/**
+ * An infinite bound adds the infinity and all the finite values on its side, e.g. [1, inf] adds
+ * [1, max double] and +inf. Does nothing if a bound is NaN or lo > hi.
+ *
+ * \param[in] lo the lower bound
+ * \param[in] hi the upper bound
+ */
+void interval::add_range(double lo, double hi)
+{
+    if (!(lo <= hi)) return;
+    const double inf = std::numeric_limits<double>::infinity(), max = std::numeric_limits<double>::max();
+    if (lo == -inf) m_neg_inf = true;
+    if (hi == inf) m_pos_inf = true;
+    // [inf, inf] and [-inf, -inf] have no finite values
+    if (lo == inf || hi == -inf) return;
+    m_lo = std::min(m_lo, std::max(lo, -max));
+    m_hi = std::max(m_hi, std::min(hi, max));
+}
+
+/// Adds all the values of another set
+/**
+ * \param[in] other the other set
+ */
+void interval::add(const interval& other)
+{
+    m_lo = std::min(m_lo, other.m_lo);
+    m_hi = std::max(m_hi, other.m_hi);
+    m_neg_inf = m_neg_inf || other.m_neg_inf;
+    m_pos_inf = m_pos_inf || other.m_pos_inf;
+    m_nan = m_nan || other.m_nan;
+}
+
+/// Overload of operator<<
+/**
+ * Streams e.g. "[-1, 2]", "{-inf, [0, 1], NaN}" or "{}"
+ */
+std::ostream& operator<<(std::ostream& os, const interval& i)
+{
+    const bool single = (i.has_finite() + i.m_neg_inf + i.m_pos_inf + i.m_nan) == 1;
+    os << (single ? "" : "{");
+    const char *separator = "";
+    if (i.m_neg_inf) {os << "-inf"; separator = ", ";}
+    if (i.has_finite()) {os << separator << "[" << i.m_lo << ", " << i.m_hi << "]"; separator = ", ";}
+    if (i.m_pos_inf) {os << separator << "inf"; separator = ", ";}
+    if (i.m_nan) {os << separator << "NaN";}
+    os << (single ? "" : "}");
+    return os;
+}
+
+} // end of namespace dcgp
@@ -0,0 +1,58 @@
+#ifndef DCGP_INTERVAL_H
+#define DCGP_INTERVAL_H
+
+#include <iostream>
+
+namespace dcgp {
+
+/// A set of double values, as computed by interval arithmetic
+/**
+ * Encloses the values a quantity may take: a range [m_lo, m_hi] of finite values (empty if m_lo > m_hi), and
+ * whether -inf, +inf or NaN are possible. Keeping the infinities and NaN apart from the finite range allows to prove
+ * that a quantity is never finite (e.g. x / (x - x) is always inf or NaN), which a plain interval could not express.
+ *
+ * The interval versions of the basis functions (see dcgp::basis_function) compute enclosures of the values the
+ * functions take, evaluated in double precision, on all the combinations of their arguments, so that an expression
+ * evaluated on intervals (dcgp::expression::operator() is templated) encloses all its outputs on a box of inputs.
+ * The enclosures are conservative: they may contain values which are never taken.
+ */
+struct interval
+{
+    /// The empty set
+    interval();
+    /// A single value (possibly infinite or NaN)
+    interval(double v);
+    /// All the values between lo and hi (possibly infinite)
+    interval(double lo, double hi);
+
+    /// Every double, NaN included
+    static interval entire();
+
+    /// Checks whether the set is empty
+    bool is_empty() const {return !has_finite() && !m_neg_inf && !m_pos_inf && !m_nan;};
+    /// Checks whether the set contains finite values
+    bool has_finite() const {return m_lo <= m_hi;};
+    /// Checks whether the set contains a value
+    bool contains(double v) const;
+
+    void add(double v);
+    void add_range(double lo, double hi);
+    void add(const interval& other);
+
+    /// Lowest finite value
+    double m_lo;
+    /// Highest finite value
+    double m_hi;
+    /// Whether -inf is possible
+    bool m_neg_inf;
+    /// Whether +inf is possible
+    bool m_pos_inf;
+    /// Whether NaN is possible
+    bool m_nan;
+};
+
+std::ostream& operator<<(std::ostream& os, const interval& i);
+
+} // end of namespace dcgp
+
+#endif // DCGP_INTERVAL_H
@@ -0,0 +1,289 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "island_model.h"
+#include "exceptions.h"
+#include "jit.h"
+
+namespace dcgp {
+
+namespace {
+// Number of migrants a channel can hold before new ones get dropped
+const std::size_t channel_capacity = 8u;
+
+// Pins the calling thread to a core (best effort, silently ignored where unsupported)
+void pin_this_thread(unsigned int core)
+{
+#ifdef __linux__
+    unsigned int n_cores = std::thread::hardware_concurrency();
+    if (n_cores == 0u) return;
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(core % n_cores, &cpuset);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+#else
+    (void)core;
+#endif
+}
+}
+
+/// Constructor
+/** Constructs an island model where each island evolves its own random dcgp::expression
+ * having the same topology (inputs, outputs, rows, columns, levels-back, functions) as the prototype
+ *
+ * \param[in] prototype expression defining the topology of all islands
+ * \param[in] fitness the fitness to be maximized. It must be safe to call concurrently
+ * \param[in] n_islands number of islands (and threads)
+ * \param[in] topology the migration topology
+ * \param[in] lambda number of offspring per generation of each (1+lambda)-ES
+ * \param[in] migration_interval number of generations between two migrations
+ * \param[in] seed seed for the random number generator (initial expressions, random topology and mutations depend on this)
+ *
+ * @throw dcgp::input_error if the number of islands, lambda or the migration interval are 0
+ */
+island_model::island_model(const expression& prototype,
+        fitness_function fitness,
+        unsigned int n_islands,
+        migration_topology topology,
+        unsigned int lambda,
+        unsigned int migration_interval,
+        unsigned int seed
+        ) : m_fitness(fitness), m_lambda(lambda), m_migration_interval(migration_interval), m_pin(true), m_stop(false), m_accepted(0u), m_dropped(0u), m_best_chromosome(prototype.get()), m_best_fitness(-std::numeric_limits<double>::infinity()), m_telemetry(), m_telemetry_interval(1u), m_cache(nullptr)
+{
+    if (n_islands == 0) throw input_error("Number of islands is 0");
+    if (lambda == 0) throw input_error("Number of offspring is 0");
+    if (migration_interval == 0) throw input_error("Migration interval is 0");
+
+    std::default_random_engine e(seed);
+    m_islands.reserve(n_islands);
+    for (auto i = 0u; i < n_islands; ++i)
+    {
+        m_islands.emplace_back(expression(prototype.get_topology(), e()));
+    }
+
+    // We build the directed edges of the migration topology
+    for (auto i = 0u; i < n_islands; ++i)
+    {
+        if (n_islands == 1u) break;
+        if (topology == migration_topology::RING)
+        {
+            m_edges.push_back(std::make_pair(i, (i + 1u) % n_islands));
+        } else if (topology == migration_topology::FULLY_CONNECTED) {
+            for (auto j = 0u; j < n_islands; ++j)
+            {
+                if (j != i) m_edges.push_back(std::make_pair(i, j));
+            }
+        } else if (topology == migration_topology::RANDOM) {
+            // each island sends to ceil(log2(K)) distinct random destinations
+            std::vector<unsigned int> others;
+            for (auto j = 0u; j < n_islands; ++j)
+            {
+                if (j != i) others.push_back(j);
+            }
+            std::shuffle(others.begin(), others.end(), e);
+            unsigned int degree = 1u;
+            while ((1u << degree) < n_islands) ++degree;
+            degree = std::min<unsigned int>(degree, others.size());
+            for (auto j = 0u; j < degree; ++j)
+            {
+                m_edges.push_back(std::make_pair(i, others[j]));
+            }
+        }
+    }
+
+    for (auto edge : m_edges)
+    {
+        // the slots hold a chromosome each, reused by all the migrants going through them
+        m_channels.emplace_back(new spsc_queue<migrant>(channel_capacity, migrant{prototype.get(), 0.}));
+        m_islands[edge.first].m_out.push_back(m_channels.back().get());
+        m_islands[edge.second].m_in.push_back(m_channels.back().get());
+    }
+}
+
+/// Evolves all islands
+/**
+ * Runs all islands concurrently, each on its own thread, until one of them reaches the target fitness
+ * or all of them have performed max_gen generations. The islands keep their state across calls.
+ *
+ * \param[in] max_gen maximum number of generations per island
+ * \param[in] target target fitness. Evolution stops on all islands as soon as one island reaches it
+ *
+ * \return true if the target fitness was reached
+ */
+bool island_model::evolve(unsigned int max_gen, double target)
+{
+    m_stop = false;
+    m_accepted = 0u;
+    m_dropped = 0u;
+
+    std::vector<std::thread> threads;
+    threads.reserve(m_islands.size());
+    for (auto i = 0u; i < m_islands.size(); ++i)
+    {
+        threads.emplace_back(&island_model::run_island, this, i, max_gen, target);
+    }
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+
+    for (const auto &isl : m_islands)
+    {
+        if (isl.m_fitness > m_best_fitness)
+        {
+            m_best_fitness = isl.m_fitness;
+            m_best_chromosome = isl.m_ex.get();
+        }
+    }
+    return m_best_fitness >= target;
+}
+
+/// Sends the progress of the islands to a telemetry log
+/**
+ * Every interval generations, each island pushes a dcgp::telemetry_record (its parent fitness, the mean fitness and
+ * active sizes of its offspring, its evaluations and their rate) to the logger, as producer i for island i.
+ * Pushing never blocks the islands.
+ *
+ * \param[in] logger the logger, null to disable telemetry
+ * \param[in] interval number of generations between two records of an island
+ * \param[in] cache the cache of compiled expressions used by the fitness (see dcgp::jit_fitness), if any, whose hits and misses are recorded
+ *
+ * @throw dcgp::input_error if the logger has less producers than islands or interval is 0
+ */
+void island_model::set_telemetry(std::shared_ptr<telemetry_logger> logger, unsigned int interval, const jit_cache *cache)
+{
+    if (logger && logger->get_n_producers() < m_islands.size())
+    {
+        throw input_error("The telemetry logger needs one producer per island");
+    }
+    if (interval == 0u)
+    {
+        throw input_error("Telemetry interval is 0");
+    }
+    m_telemetry = std::move(logger);
+    m_telemetry_interval = interval;
+    m_cache = cache;
+}
+
+/// Gets, for each island, the number of generations performed during the last call to evolve
+std::vector<unsigned int> island_model::get_generations() const
+{
+    std::vector<unsigned int> retval;
+    for (const auto &isl : m_islands)
+    {
+        retval.push_back(isl.m_gen);
+    }
+    return retval;
+}
+
+/// Runs a (1+lambda)-ES on island i (called on its own thread)
+void island_model::run_island(unsigned int i, unsigned int max_gen, double target)
+{
+    if (m_pin) pin_this_thread(i);
+
+    island &isl = m_islands[i];
+    expression &ex = isl.m_ex;
+    std::vector<unsigned int> parent = ex.get();
+    double parent_fit = m_fitness(ex);
+    std::vector<unsigned int> best_offspring;
+    telemetry_window window;
+    const double start = m_telemetry ? m_telemetry->elapsed() : 0.;
+
+    unsigned int gen = 0u;
+    while (gen < max_gen && parent_fit < target && !m_stop.load(std::memory_order_relaxed))
+    {
+        ++gen;
+        double best_offspring_fit = -std::numeric_limits<double>::infinity();
+        // offspring with NaN fitness are never recorded: if all of them have it, best_offspring is stale (or empty)
+        bool recorded = false;
+        for (auto k = 0u; k < m_lambda; ++k)
+        {
+            ex.set(parent);
+            ex.mutate_active();
+            double f = m_fitness(ex);
+            if (m_telemetry) window.add(ex.get_active_nodes().size(), f);
+            if (f >= best_offspring_fit)
+            {
+                best_offspring_fit = f;
+                best_offspring = ex.get();
+                recorded = true;
+            }
+        }
+        // a parent with NaN fitness is replaced by any recorded offspring
+        if (recorded && (best_offspring_fit >= parent_fit || std::isnan(parent_fit)))
+        {
+            parent.swap(best_offspring);
+            parent_fit = best_offspring_fit;
+        }
+
+        // Immigrants replace the parent only if strictly better (the chromosomes are swapped, so that the slot
+        // keeps a buffer of the same size)
+        for (auto channel : isl.m_in)
+        {
+            while (migrant *mg = channel->front())
+            {
+                if (mg->m_fitness > parent_fit)
+                {
+                    parent.swap(mg->m_chromosome);
+                    parent_fit = mg->m_fitness;
+                    m_accepted.fetch_add(1u, std::memory_order_relaxed);
+                }
+                channel->release();
+            }
+        }
+
+        // Emigrants never block: if the channel is full the migrant is dropped, otherwise the parent is copied
+        // into the storage of the free slot
+        if (gen % m_migration_interval == 0u)
+        {
+            for (auto channel : isl.m_out)
+            {
+                migrant *mg = channel->claim();
+                if (!mg)
+                {
+                    m_dropped.fetch_add(1u, std::memory_order_relaxed);
+                    continue;
+                }
+                mg->m_chromosome = parent;
+                mg->m_fitness = parent_fit;
+                channel->publish();
+            }
+        }
+
+        if (m_telemetry && gen % m_telemetry_interval == 0u)
+        {
+            telemetry_record r = telemetry_record();
+            r.m_source = i;
+            r.m_generation = gen;
+            r.m_time = m_telemetry->elapsed();
+            r.m_best_fitness = parent_fit;
+            window.fill(r);
+            r.m_evaluations = 1u + static_cast<std::uint64_t>(gen) * m_lambda;
+            // the clock may not have advanced since the start of the run
+            r.m_evaluations_per_second = (r.m_time > start) ? static_cast<double>(r.m_evaluations) / (r.m_time - start) : std::numeric_limits<double>::quiet_NaN();
+            if (m_cache)
+            {
+                r.m_cache_hits = m_cache->get_hits();
+                r.m_cache_misses = m_cache->get_misses();
+            }
+            m_telemetry->push(i, r);
+        }
+    }
+    if (parent_fit >= target)
+    {
+        m_stop = true;
+    }
+    ex.set(parent);
+    isl.m_fitness = parent_fit;
+    isl.m_gen = gen;
+}
+
+} // end of namespace dcgp
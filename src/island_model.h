@@ -0,0 +1,109 @@
+#ifndef DCGP_ISLAND_MODEL_H
+#define DCGP_ISLAND_MODEL_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "expression.h"
+#include "fitness_functions.h"
+#include "rng.h"
+#include "spsc_queue.h"
+#include "telemetry.h"
+
+namespace dcgp {
+
+class jit_cache;
+
+enum migration_topology {
+    RING,               // island i sends its migrants to island i+1
+    FULLY_CONNECTED,    // island i sends its migrants to all other islands
+    RANDOM              // island i sends its migrants to a fixed random subset of the other islands
+    };
+
+/// Island model
+/**
+ * Evolves K independent (1+lambda)-ES populations of dcgp::expression, each on its own thread
+ * (pinned to a core where supported), that periodically send their best chromosome to their
+ * neighbours as defined by a dcgp::migration_topology. Migrants travel through
+ * lock-free dcgp::spsc_queue channels, one per directed edge of the topology: islands never wait
+ * on each other and a migrant that finds a full channel is simply dropped. Migrants are copied into, and swapped out
+ * of, chromosomes preallocated in the slots of the channels, so that migrating does not allocate memory.
+ *
+ * @author Dario Izzo (dario.izzo@gmail.com)
+ */
+class island_model {
+public:
+    island_model(const expression& prototype,
+            fitness_function fitness,
+            unsigned int n_islands,
+            migration_topology topology = RING,
+            unsigned int lambda = 4,
+            unsigned int migration_interval = 10,
+            unsigned int seed = rng::get_seed()
+            );
+
+    bool evolve(unsigned int max_gen, double target);
+
+    /// Gets the best chromosome found
+    const std::vector<unsigned int> & get_best_chromosome() const {return m_best_chromosome;};
+    /// Gets the fitness of the best chromosome found
+    double get_best_fitness() const {return m_best_fitness;};
+    /// Gets the number of islands
+    unsigned int get_n_islands() const {return static_cast<unsigned int>(m_islands.size());};
+    /// Gets, for each island, the number of generations performed during the last call to evolve
+    std::vector<unsigned int> get_generations() const;
+    /// Gets the number of migrants accepted in the last call to evolve
+    unsigned long get_accepted_migrants() const {return m_accepted.load();};
+    /// Gets the number of migrants dropped because a channel was full in the last call to evolve
+    unsigned long get_dropped_migrants() const {return m_dropped.load();};
+    /// Gets the directed migration edges as (source, destination) pairs
+    const std::vector<std::pair<unsigned int, unsigned int> > & get_edges() const {return m_edges;};
+
+    /// Enables or disables pinning of each island thread to a core (enabled by default)
+    void set_pinning(bool pin) {m_pin = pin;};
+
+    void set_telemetry(std::shared_ptr<telemetry_logger> logger, unsigned int interval = 1u, const jit_cache *cache = nullptr);
+
+private:
+    struct migrant
+    {
+        std::vector<unsigned int> m_chromosome;
+        double m_fitness;
+    };
+
+    struct island
+    {
+        island(const expression& ex) : m_ex(ex), m_fitness(0.), m_gen(0u) {}
+        expression m_ex;
+        double m_fitness;
+        unsigned int m_gen;
+        std::vector<spsc_queue<migrant>*> m_in;
+        std::vector<spsc_queue<migrant>*> m_out;
+    };
+
+    void run_island(unsigned int i, unsigned int max_gen, double target);
+
+    fitness_function m_fitness;
+    unsigned int m_lambda;
+    unsigned int m_migration_interval;
+    bool m_pin;
+    std::vector<island> m_islands;
+    // one channel per directed edge
+    std::vector<std::pair<unsigned int, unsigned int> > m_edges;
+    std::vector<std::unique_ptr<spsc_queue<migrant> > > m_channels;
+    std::atomic<bool> m_stop;
+    std::atomic<unsigned long> m_accepted;
+    std::atomic<unsigned long> m_dropped;
+    std::vector<unsigned int> m_best_chromosome;
+    double m_best_fitness;
+    // telemetry (island i is producer i), disabled if null
+    std::shared_ptr<telemetry_logger> m_telemetry;
+    unsigned int m_telemetry_interval;
+    const jit_cache *m_cache;
+};
+
+} // end of namespace dcgp
+
+#endif // DCGP_ISLAND_MODEL_H
@@ -0,0 +1,137 @@
+#ifndef DCGP_JIT_H
+#define DCGP_JIT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "basis_function.h"
+#include "dataset.h"
+#include "expression.h"
+#include "fitness_functions.h"
+
+namespace dcgp {
+
+/// Checks whether expressions can be compiled in-process on this platform (x86-64)
+bool jit_available();
+
+/// Gets a hash of the phenotype (active graph) of an expression
+std::uint64_t phenotype_hash(const expression& ex);
+
+/// Gets a canonical description of the phenotype (active graph) of an expression
+std::string phenotype(const expression& ex);
+
+/// Checks whether compiling an expression pays off
+bool jit_amortized(std::size_t rows, unsigned long expected_evaluations, std::size_t active_nodes);
+
+/// Expression compiled in-process to x86-64 machine code
+/**
+ * The active nodes of a dcgp::expression are translated, without any external tool, into one straight-line
+ * SSE2 loop over the points of column-major data, computing two points per iteration (packed instructions)
+ * and the last point, when their number is odd, in a scalar tail. Sums, differences, products and divisions are
+ * inlined, all the other functions (e.g. pow, sqrt) are called out lane by lane, so that the outputs are
+ * bit-for-bit those of the expression.
+ *
+ * AVX2 (four points per iteration) is not emitted: it needs VEX encodings, a cpuid and xgetbv check and a
+ * vzeroupper before every call out, while the calls out stay one point at a time, so that only the inlined
+ * arithmetic would gain.
+ *
+ * Compiling an expression takes a few microseconds, see dcgp::jit_amortized for when it pays off and dcgp::jit_cache
+ * to reuse the code of expressions having the same phenotype.
+ *
+ * @author Dario Izzo (dario.izzo@gmail.com)
+ */
+class jit_expression {
+public:
+    explicit jit_expression(const expression& ex);
+    ~jit_expression();
+    jit_expression(const jit_expression&) = delete;
+    jit_expression& operator=(const jit_expression&) = delete;
+
+    void operator()(const double *const *in, double *const *out, std::size_t rows) const;
+    std::vector<double> operator()(const std::vector<double>& in) const;
+
+    /// Gets the number of inputs
+    unsigned int get_n() const {return m_n;};
+    /// Gets the number of outputs
+    unsigned int get_m() const {return m_m;};
+    /// Gets the size of the machine code (in bytes)
+    std::size_t get_code_size() const {return m_code_size;};
+
+private:
+    using code_type = void (*)(const double *const*, double *const*, std::size_t, double*);
+
+    unsigned int m_n;
+    unsigned int m_m;
+    // number of value slots used by the code (one per active node)
+    std::size_t m_n_slots;
+    // the functions that are called out by the code
+    std::vector<basis_function> m_functions;
+    void *m_code;
+    std::size_t m_code_size;
+};
+
+/// Cache of compiled expressions
+/**
+ * Compiled expressions are keyed by the hash of their phenotype (see dcgp::phenotype_hash), so that offspring
+ * only differing in their inactive genes (or evaluated several times) are compiled once.
+ * When the cache is full it is emptied. The cache can be used concurrently by several threads.
+ */
+class jit_cache {
+public:
+    explicit jit_cache(std::size_t capacity = 1024u) : m_capacity(capacity), m_hits(0u), m_misses(0u) {};
+
+    std::shared_ptr<const jit_expression> get(const expression& ex);
+
+    /// Gets the number of expressions found in the cache (lock-free)
+    unsigned long get_hits() const {return m_hits.load(std::memory_order_relaxed);};
+    /// Gets the number of expressions compiled (lock-free)
+    unsigned long get_misses() const {return m_misses.load(std::memory_order_relaxed);};
+    /// Gets the number of compiled expressions in the cache
+    std::size_t size() const {std::lock_guard<std::mutex> lock(m_mutex); return m_entries.size();};
+
+private:
+    struct entry
+    {
+        std::string m_phenotype;
+        std::shared_ptr<const jit_expression> m_code;
+    };
+
+    std::size_t m_capacity;
+    std::unordered_map<std::uint64_t, entry> m_entries;
+    std::atomic<unsigned long> m_hits;
+    std::atomic<unsigned long> m_misses;
+    mutable std::mutex m_mutex;
+};
+
+/// Fitness on a dataset, computed by compiled expressions when it pays off
+/**
+ * Computes the same fitness as dcgp::simple_data_fit. Expressions are compiled (through a dcgp::jit_cache) when
+ * the platform supports it, the dataset is column-major and compiling is amortized (see dcgp::jit_amortized),
+ * otherwise they are interpreted. Can be used concurrently by several threads (e.g. as the fitness of dcgp::island_model).
+ */
+class jit_fitness {
+public:
+    jit_fitness(const dataset& data, fitness_type type = ERROR_BASED, double tol = 1e-10, unsigned long expected_evaluations = 1u, std::size_t cache_capacity = 1024u);
+
+    double operator()(const expression& ex) const;
+
+    /// Gets the cache of compiled expressions
+    const jit_cache& get_cache() const {return *m_cache;};
+
+private:
+    dataset m_data;
+    fitness_type m_type;
+    double m_tol;
+    unsigned long m_expected_evaluations;
+    std::shared_ptr<jit_cache> m_cache;
+};
+
+} // end of namespace dcgp
+
+#endif // DCGP_JIT_H
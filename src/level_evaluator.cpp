@@ -0,0 +1,297 @@
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+#include "exceptions.h"
+#include "level_evaluator.h"
+
+namespace dcgp {
+
+namespace {
+// Marks the steps copying an input
+const unsigned int no_function = std::numeric_limits<unsigned int>::max();
+
+// Number of times a task checks for its arguments before sleeping
+const unsigned int spin_checks = 1024u;
+}
+
+/// Constructor
+/** Computes the levels of the active nodes of an expression and splits them in chunks
+ *
+ * \param[in] ex the expression
+ * \param[in] n_threads number of threads evaluating the tasks (0 to use one per hardware thread)
+ * \param[in] tile_rows number of points per tile
+ * \param[in] chunk_nodes number of nodes per chunk (the last chunk of a level may be smaller)
+ *
+ * @throw dcgp::input_error if tile_rows or chunk_nodes are zero
+ */
+level_evaluator::level_evaluator(const expression& ex, unsigned int n_threads, std::size_t tile_rows, std::size_t chunk_nodes)
+    : m_topology(ex.get_topology()), m_n(ex.get_n()), m_m(ex.get_m()), m_n_threads(n_threads), m_tile_rows(tile_rows), m_slots(0u),
+      m_run(nullptr), m_generation(0u), m_active(0u), m_quit(false)
+{
+    if (tile_rows == 0u) throw input_error("Tile size is 0");
+    if (chunk_nodes == 0u) throw input_error("Chunk size is 0");
+    if (m_n_threads == 0u)
+    {
+        m_n_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const std::vector<unsigned int>& x = ex.get();
+    const std::vector<basis_function>& f = ex.get_f();
+    const unsigned int nodes = m_n + ex.get_r() * ex.get_c();
+
+    // the active nodes are sorted, so that the arguments of a node always come before it
+    std::vector<unsigned int> level(nodes, 0u);
+    for (auto i : ex.get_active_nodes())
+    {
+        if (i >= m_n)
+        {
+            const unsigned int idx = (i - m_n) * 3u;
+            level[i] = 1u + level[x[idx + 1u]];
+            if (f[x[idx]].m_arity > 1u)
+            {
+                level[i] = std::max(level[i], 1u + level[x[idx + 2u]]);
+            }
+        }
+        if (level[i] >= m_levels.size())
+        {
+            m_levels.resize(level[i] + 1u);
+        }
+        m_levels[level[i]].push_back(i);
+    }
+
+    // one slot per active node, in the order of the steps
+    std::vector<unsigned int> slot(nodes, 0u);
+    for (const auto &l : m_levels)
+    {
+        const std::size_t first = m_steps.size();
+        for (auto i : l)
+        {
+            slot[i] = static_cast<unsigned int>(m_slots++);
+            if (i < m_n)
+            {
+                m_steps.push_back(step{no_function, i, i, slot[i]});
+            } else {
+                const unsigned int idx = (i - m_n) * 3u;
+                // unary functions get their argument twice, as in dcgp::expression::eval_into
+                const unsigned int b = (f[x[idx]].m_arity > 1u) ? x[idx + 2u] : x[idx + 1u];
+                m_steps.push_back(step{x[idx], slot[x[idx + 1u]], slot[b], slot[i]});
+            }
+        }
+        const std::size_t after = m_chunks.size();
+        const std::size_t n_chunks = (l.size() + chunk_nodes - 1u) / chunk_nodes;
+        for (auto k = 0u; k < n_chunks; ++k)
+        {
+            m_chunks.push_back(chunk{first + l.size() * k / n_chunks, first + l.size() * (k + 1u) / n_chunks, after});
+        }
+    }
+    for (auto j = 0u; j < m_m; ++j)
+    {
+        m_outputs.push_back(slot[x[ex.get_r() * ex.get_c() * 3u + j]]);
+    }
+
+    try {
+        for (auto t = 1u; t < m_n_threads; ++t)
+        {
+            m_threads.emplace_back(&level_evaluator::pool_thread, this);
+        }
+    } catch (...) {
+        stop();
+        throw;
+    }
+}
+
+/// Destructor (stops and joins the threads)
+level_evaluator::~level_evaluator()
+{
+    stop();
+}
+
+// Stops and joins the threads of the pool
+void level_evaluator::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_pool_mutex);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    for (auto &th : m_threads)
+    {
+        th.join();
+    }
+    m_threads.clear();
+}
+
+// A thread of the pool: sleeps until an evaluation is started, then executes its tasks with the calling thread
+void level_evaluator::pool_thread() const
+{
+    unsigned long seen = 0u;
+    std::unique_lock<std::mutex> lock(m_pool_mutex);
+    while (true)
+    {
+        while (!m_quit && m_generation == seen)
+        {
+            m_wake.wait(lock);
+        }
+        if (m_quit) return;
+        seen = m_generation;
+        // the evaluation may already be over
+        if (!m_run) continue;
+        run &r = *m_run;
+        ++m_active;
+        lock.unlock();
+        work(r);
+        lock.lock();
+        if (--m_active == 0u)
+        {
+            m_idle.notify_all();
+        }
+    }
+}
+
+/// Computes the outputs of several points
+/**
+ * The calling thread and the get_n_threads() - 1 threads of the evaluator execute the tasks. If the threads are busy
+ * with an evaluation started by another thread, the calling thread executes all the tasks.
+ *
+ * \param[in] in the inputs, rows times n values (the n inputs of each point are contiguous)
+ * \param[out] out the outputs, rows times m values (the m outputs of each point are contiguous)
+ * \param[in] rows number of points
+ */
+void level_evaluator::operator()(const double *in, double *out, std::size_t rows) const
+{
+    if (rows == 0u) return;
+    DCGP_COUNT(COUNT_EVALUATIONS, rows);
+    run r;
+    r.m_in = in;
+    r.m_out = out;
+    r.m_rows = rows;
+    r.m_tiles = (rows + m_tile_rows - 1u) / m_tile_rows;
+    // two tiles per thread, so that a thread waiting for a tile can work on another one
+    r.m_in_flight = std::min<std::size_t>(r.m_tiles, 2u * m_n_threads);
+    r.m_values.resize(r.m_in_flight * m_slots * m_tile_rows);
+    r.m_done.reset(new std::atomic<std::size_t>[r.m_tiles]);
+    for (auto t = 0u; t < r.m_tiles; ++t)
+    {
+        r.m_done[t].store(0u, std::memory_order_relaxed);
+    }
+    r.m_next.store(0u, std::memory_order_relaxed);
+    r.m_parked.store(0u, std::memory_order_relaxed);
+
+    std::unique_lock<std::mutex> caller(m_call_mutex, std::try_to_lock);
+    if (!caller.owns_lock() || m_threads.empty() || r.m_tiles * m_chunks.size() == 1u)
+    {
+        work(r);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_pool_mutex);
+        m_run = &r;
+        ++m_generation;
+    }
+    m_wake.notify_all();
+    work(r);
+    // all the tasks are handed out: the threads which did not join yet must not, the others are waited for
+    std::unique_lock<std::mutex> lock(m_pool_mutex);
+    m_run = nullptr;
+    while (m_active != 0u)
+    {
+        m_idle.wait(lock);
+    }
+}
+
+// Executes tasks until there are none left. The tasks are handed out in groups of tiles in flight, level by level
+// within a group, so that a task only ever waits for tasks handed out before it
+void level_evaluator::work(run& r) const
+{
+    const std::size_t total = m_chunks.size() * r.m_tiles;
+    const std::size_t group = m_chunks.size() * r.m_in_flight;
+    for (std::size_t k = r.m_next.fetch_add(1u); k < total; k = r.m_next.fetch_add(1u))
+    {
+        const std::size_t g = k / group, rem = k % group;
+        const std::size_t tiles = std::min(r.m_in_flight, r.m_tiles - g * r.m_in_flight);
+        execute(r, g * r.m_in_flight + rem % tiles, rem / tiles);
+    }
+}
+
+// Computes a chunk of nodes on a tile, once its arguments (or, for the inputs, its memory) are available
+void level_evaluator::execute(run& r, std::size_t tile, std::size_t c) const
+{
+    const chunk& ch = m_chunks[c];
+    if (ch.m_after == 0u && tile >= r.m_in_flight)
+    {
+        // the memory is released once the outputs of the previous tile using it are written
+        wait_for(r, tile - r.m_in_flight, m_chunks.size() + 1u);
+    } else {
+        wait_for(r, tile, ch.m_after);
+    }
+
+    const std::vector<basis_function>& f = m_topology->get_f();
+    const std::size_t begin = tile * m_tile_rows;
+    const std::size_t count = std::min(m_tile_rows, r.m_rows - begin);
+    double *values = r.m_values.data() + (tile % r.m_in_flight) * m_slots * m_tile_rows;
+    for (std::size_t s = ch.m_begin; s < ch.m_end; ++s)
+    {
+        const step& st = m_steps[s];
+        double *dst = values + st.m_out * m_tile_rows;
+        if (st.m_function == no_function)
+        {
+            for (auto i = 0u; i < count; ++i)
+            {
+                dst[i] = r.m_in[(begin + i) * m_n + st.m_a];
+            }
+        } else {
+            const basis_function& fun = f[st.m_function];
+            const double *a = values + st.m_a * m_tile_rows, *b = values + st.m_b * m_tile_rows;
+            for (auto i = 0u; i < count; ++i)
+            {
+                dst[i] = fun(a[i], b[i]);
+            }
+        }
+    }
+
+    if (advance(r, tile) == m_chunks.size())
+    {
+        // the last chunk of the tile writes its outputs
+        for (auto j = 0u; j < m_m; ++j)
+        {
+            const double *src = values + m_outputs[j] * m_tile_rows;
+            for (auto i = 0u; i < count; ++i)
+            {
+                r.m_out[(begin + i) * m_m + j] = src[i];
+            }
+        }
+        advance(r, tile);
+    }
+}
+
+// Waits until a tile has progressed to value: spins briefly, then sleeps
+void level_evaluator::wait_for(run& r, std::size_t tile, std::size_t value) const
+{
+    for (auto k = 0u; k < spin_checks; ++k)
+    {
+        if (r.m_done[tile].load(std::memory_order_acquire) >= value) return;
+    }
+    std::unique_lock<std::mutex> lock(r.m_mutex);
+    // announced before checking again, see advance
+    r.m_parked.fetch_add(1u);
+    while (r.m_done[tile].load() < value)
+    {
+        r.m_progress.wait(lock);
+    }
+    r.m_parked.fetch_sub(1u);
+}
+
+// Increments the progress of a tile and wakes up the sleeping tasks, returns the new progress
+std::size_t level_evaluator::advance(run& r, std::size_t tile) const
+{
+    const std::size_t retval = r.m_done[tile].fetch_add(1u) + 1u;
+    // a task which announced itself after this check sees the new progress before sleeping
+    if (r.m_parked.load() != 0u)
+    {
+        std::lock_guard<std::mutex> lock(r.m_mutex);
+        r.m_progress.notify_all();
+    }
+    return retval;
+}
+
+} // end of namespace dcgp
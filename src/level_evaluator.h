@@ -0,0 +1,123 @@
+#ifndef DCGP_LEVEL_EVALUATOR_H
+#define DCGP_LEVEL_EVALUATOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "expression.h"
+
+namespace dcgp {
+
+/// Evaluator of very wide expressions, parallel over the nodes as well as over the points
+/**
+ * The active nodes of the expression are grouped in topological levels: the inputs form level 0 and each other node
+ * is one level above the highest of its arguments, so that the nodes of a level never depend on each other
+ * (in the Cartesian layout the nodes of a column always share a level, and several columns may be merged in one).
+ *
+ * The points are split in tiles and the nodes of each level in chunks. A task computes one chunk of nodes on one tile
+ * and waits only for the tasks of the lower levels of the same tile: there is no barrier between levels, so that
+ * different tiles progress through the levels independently. A bounded number of tiles is in flight at any time, each
+ * one using its own slice of memory.
+ *
+ * The threads are created with the evaluator and kept until it is destroyed. A task whose arguments are not ready spins
+ * briefly, then sleeps until the task it waits for is done.
+ *
+ * The outputs are those of dcgp::expression::eval_into. The evaluator keeps a copy of the active graph of the expression
+ * and its results do not depend on the evaluations, so that several threads can use it at the same time: an evaluation
+ * started while the threads are busy with another one is computed by its calling thread alone.
+ *
+ * @author Dario Izzo (dario.izzo@gmail.com)
+ */
+class level_evaluator {
+public:
+    level_evaluator(const expression& ex, unsigned int n_threads = 0u, std::size_t tile_rows = 128u, std::size_t chunk_nodes = 32u);
+    ~level_evaluator();
+    level_evaluator(const level_evaluator&) = delete;
+    level_evaluator& operator=(const level_evaluator&) = delete;
+
+    void operator()(const double *in, double *out, std::size_t rows) const;
+
+    /// Gets the number of inputs
+    unsigned int get_n() const {return m_n;};
+    /// Gets the number of outputs
+    unsigned int get_m() const {return m_m;};
+    /// Gets the number of threads
+    unsigned int get_n_threads() const {return m_n_threads;};
+    /// Gets the active nodes of each level (level 0 holds the active inputs)
+    const std::vector<std::vector<unsigned int> >& get_levels() const {return m_levels;};
+
+private:
+    // one active node: an input (m_function == no_function, m_a the input) or a basis function of two slots
+    struct step
+    {
+        unsigned int m_function;
+        unsigned int m_a;
+        unsigned int m_b;
+        unsigned int m_out;
+    };
+    // a range of steps of one level
+    struct chunk
+    {
+        std::size_t m_begin;
+        std::size_t m_end;
+        // number of chunks of the lower levels
+        std::size_t m_after;
+    };
+    // the state of one evaluation, shared by its threads
+    struct run
+    {
+        const double *m_in;
+        double *m_out;
+        std::size_t m_rows;
+        std::size_t m_tiles;
+        std::size_t m_in_flight;
+        std::vector<double> m_values;
+        // completed chunks of each tile, plus one when its outputs are written
+        std::unique_ptr<std::atomic<std::size_t>[]> m_done;
+        std::atomic<std::size_t> m_next;
+        // the tasks sleeping until a tile progresses
+        std::atomic<std::size_t> m_parked;
+        std::mutex m_mutex;
+        std::condition_variable m_progress;
+    };
+
+    void stop();
+    void pool_thread() const;
+    void work(run& r) const;
+    void execute(run& r, std::size_t tile, std::size_t c) const;
+    void wait_for(run& r, std::size_t tile, std::size_t value) const;
+    std::size_t advance(run& r, std::size_t tile) const;
+
+    // the topology, holding the basis functions
+    std::shared_ptr<const expression_topology> m_topology;
+    unsigned int m_n;
+    unsigned int m_m;
+    unsigned int m_n_threads;
+    std::size_t m_tile_rows;
+    std::vector<std::vector<unsigned int> > m_levels;
+    // the steps, level by level, and the chunks splitting them
+    std::vector<step> m_steps;
+    std::vector<chunk> m_chunks;
+    // number of values per point (one slot per active node)
+    std::size_t m_slots;
+    std::vector<unsigned int> m_outputs;
+    // the pool: get_n_threads() - 1 threads joining the evaluation pointed to by m_run whenever m_generation changes
+    std::vector<std::thread> m_threads;
+    mutable std::mutex m_call_mutex;
+    mutable std::mutex m_pool_mutex;
+    mutable std::condition_variable m_wake;
+    mutable std::condition_variable m_idle;
+    mutable run *m_run;
+    mutable unsigned long m_generation;
+    mutable unsigned int m_active;
+    bool m_quit;
+};
+
+} // end of namespace dcgp
+
+#endif // DCGP_LEVEL_EVALUATOR_H
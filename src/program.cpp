@@ -0,0 +1,296 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <tuple>
+
+#include "exceptions.h"
+#include "program.h"
+#include "wrapped_functions.h"
+
+namespace dcgp {
+
+namespace {
+// Value of an instruction given the values of its arguments
+double execute(const instruction& ins, double a, double b, const std::vector<basis_function>& f)
+{
+    switch (ins.m_op)
+    {
+        case OP_CONST: return ins.m_value;
+        case OP_SUM: return my_sum(a, b);
+        case OP_DIFF: return my_diff(a, b);
+        case OP_MUL: return my_mul(a, b);
+        case OP_DIV: return my_div(a, b);
+        case OP_POW_ABS: return my_pow(a, b);
+        case OP_POW: return std::pow(a, b);
+        case OP_SQRT_ABS: return my_sqrt(a, b);
+        case OP_SQRT: return std::sqrt(a);
+        case OP_ABS: return std::fabs(a);
+        case OP_CALL: return f[ins.m_function](a, b);
+    }
+    return 0.;
+}
+
+bool is_unary(op_code op)
+{
+    return op == OP_SQRT_ABS || op == OP_SQRT || op == OP_ABS;
+}
+
+std::uint64_t bits(double x)
+{
+    std::uint64_t retval;
+    std::memcpy(&retval, &x, sizeof(x));
+    return retval;
+}
+
+// Lowers the active graph of an expression to instructions, optimizing it on the fly
+class builder
+{
+public:
+    builder(unsigned int n, optimization_level level, const std::vector<basis_function>& f) : m_n(n), m_level(level), m_f(f), m_nonnegative(n, false) {}
+
+    // Gets the register holding the result of an instruction, emitting it only if needed
+    unsigned int emit(op_code op, unsigned int a, unsigned int b, double value = 0., unsigned int function = 0u)
+    {
+        if (op == OP_CONST) a = b = 0u;
+        if (is_unary(op)) b = 0u;
+        if (m_level != NO_OPTIMIZATION)
+        {
+            if ((op == OP_SUM || op == OP_MUL) && a > b) std::swap(a, b);
+            // identities exact in floating point
+            if (op == OP_ABS && m_nonnegative[a]) return a;
+            if (op == OP_SQRT_ABS && m_nonnegative[a]) op = OP_SQRT;
+            if (op == OP_POW_ABS && m_nonnegative[a]) op = OP_POW;
+            if ((op == OP_POW || op == OP_POW_ABS) && is(b, 1.)) return (op == OP_POW) ? a : emit(OP_ABS, a, 0u);
+            if ((op == OP_POW || op == OP_POW_ABS) && (is(b, 0.) || is(b, -0.))) return constant(1.);
+            if (op == OP_MUL && is(b, 1.)) return a;
+            if (op == OP_MUL && is(a, 1.)) return b;
+            if (op == OP_DIV && is(b, 1.)) return a;
+            if (op == OP_DIFF && is(b, 0.)) return a;
+            if (op == OP_SUM && is(b, -0.)) return a;
+            if (op == OP_SUM && is(a, -0.)) return b;
+            // identities valid on the reals only
+            if (m_level == ALGEBRAIC_OPTIMIZATION)
+            {
+                if (op == OP_DIFF && a == b) return constant(0.);
+                if (op == OP_DIV && a == b) return constant(1.);
+                if (op == OP_SUM && (is(a, 0.) || is(a, -0.))) return b;
+                if (op == OP_SUM && (is(b, 0.) || is(b, -0.))) return a;
+                if (op == OP_DIFF && is(b, -0.)) return a;
+                if (op == OP_MUL && (is(a, 0.) || is(b, 0.))) return constant(0.);
+                if (op == OP_DIV && is(a, 0.)) return constant(0.);
+            }
+            // constant folding
+            if (op != OP_CONST && is_constant(a) && (is_unary(op) || is_constant(b)))
+            {
+                instruction ins{op, a, b, 0., function};
+                return constant(execute(ins, m_code[a - m_n].m_value, is_unary(op) ? 0. : m_code[b - m_n].m_value, m_f));
+            }
+            // common subexpressions
+            auto key = std::make_tuple(static_cast<int>(op), a, b, bits(value), function);
+            auto it = m_cse.find(key);
+            if (it != m_cse.end()) return it->second;
+            m_cse[key] = static_cast<unsigned int>(m_nonnegative.size());
+        }
+        m_code.push_back(instruction{op, a, b, value, function});
+        bool nonnegative = false;
+        switch (op)
+        {
+            case OP_CONST: nonnegative = !std::isnan(value) && !std::signbit(value); break;
+            case OP_MUL: nonnegative = (a == b); break;
+            case OP_POW_ABS: case OP_POW: case OP_SQRT_ABS: case OP_SQRT: case OP_ABS: nonnegative = true; break;
+            default: break;
+        }
+        m_nonnegative.push_back(nonnegative);
+        return static_cast<unsigned int>(m_nonnegative.size() - 1u);
+    }
+
+    unsigned int constant(double value)
+    {
+        return emit(OP_CONST, 0u, 0u, value);
+    }
+
+    std::vector<instruction> m_code;
+
+private:
+    bool is_constant(unsigned int r) const
+    {
+        return r >= m_n && m_code[r - m_n].m_op == OP_CONST;
+    }
+    // checks whether a register holds the given constant (bit-for-bit, so that 0 and -0 differ)
+    bool is(unsigned int r, double value) const
+    {
+        return is_constant(r) && bits(m_code[r - m_n].m_value) == bits(value);
+    }
+
+    unsigned int m_n;
+    optimization_level m_level;
+    const std::vector<basis_function>& m_f;
+    // whether each register is known to be non negative (or NaN)
+    std::vector<bool> m_nonnegative;
+    std::map<std::tuple<int, unsigned int, unsigned int, std::uint64_t, unsigned int>, unsigned int> m_cse;
+};
+}
+
+/// Constructor
+/** Lowers the active graph of an expression to a program
+ *
+ * \param[in] ex the expression
+ * \param[in] level which rewrites are allowed
+ */
+program::program(const expression& ex, optimization_level level) : m_n(ex.get_n()), m_m(ex.get_m()), m_functions(ex.get_f())
+{
+    const std::vector<unsigned int>& x = ex.get();
+    builder b(m_n, level, m_functions);
+    std::map<unsigned int, unsigned int> reg;
+    for (auto i : ex.get_active_nodes())
+    {
+        if (i < m_n)
+        {
+            reg[i] = i;
+            continue;
+        }
+        const unsigned int idx = (i - m_n) * 3u;
+        const std::string& name = m_functions[x[idx]].m_name;
+        // the second connection of unary functions may not be active
+        const unsigned int a = reg[x[idx + 1]], c = (m_functions[x[idx]].m_arity > 1u) ? reg[x[idx + 2]] : a;
+        if (name == "sum") {
+            reg[i] = b.emit(OP_SUM, a, c);
+        } else if (name == "diff") {
+            reg[i] = b.emit(OP_DIFF, a, c);
+        } else if (name == "mul") {
+            reg[i] = b.emit(OP_MUL, a, c);
+        } else if (name == "div") {
+            reg[i] = b.emit(OP_DIV, a, c);
+        } else if (name == "pow") {
+            reg[i] = b.emit(OP_POW_ABS, a, c);
+        } else if (name == "sqrt") {
+            reg[i] = b.emit(OP_SQRT_ABS, a, c);
+        } else {
+            reg[i] = b.emit(OP_CALL, a, c, 0., x[idx]);
+        }
+    }
+    for (auto k = 0u; k < m_m; ++k)
+    {
+        m_outputs.push_back(reg[x[ex.get_r() * ex.get_c() * 3u + k]]);
+    }
+
+    if (level == NO_OPTIMIZATION)
+    {
+        m_code = b.m_code;
+        return;
+    }
+    // dead code elimination, then renumbering of the registers
+    std::vector<bool> live(m_n + b.m_code.size(), false);
+    for (auto r : m_outputs)
+    {
+        live[r] = true;
+    }
+    for (auto k = b.m_code.size(); k-- > 0u;)
+    {
+        const instruction& ins = b.m_code[k];
+        if (!live[m_n + k] || ins.m_op == OP_CONST) continue;
+        live[ins.m_a] = true;
+        if (!is_unary(ins.m_op)) live[ins.m_b] = true;
+    }
+    std::vector<unsigned int> renumber(live.size());
+    for (auto r = 0u; r < m_n; ++r)
+    {
+        renumber[r] = r;
+    }
+    for (auto k = 0u; k < b.m_code.size(); ++k)
+    {
+        if (!live[m_n + k]) continue;
+        instruction ins = b.m_code[k];
+        if (ins.m_op != OP_CONST)
+        {
+            ins.m_a = renumber[ins.m_a];
+            ins.m_b = is_unary(ins.m_op) ? 0u : renumber[ins.m_b];
+        }
+        renumber[m_n + k] = static_cast<unsigned int>(m_n + m_code.size());
+        m_code.push_back(ins);
+    }
+    for (auto &r : m_outputs)
+    {
+        r = renumber[r];
+    }
+}
+
+/// Runs the program without allocating memory
+/**
+ * \param[in] in the n inputs
+ * \param[out] out the m outputs
+ * \param[in] registers workspace of at least dcgp::program::get_registers values
+ */
+void program::operator()(const double *in, double *out, double *registers) const
+{
+    for (auto i = 0u; i < m_n; ++i)
+    {
+        registers[i] = in[i];
+    }
+    double *r = registers + m_n;
+    for (const auto &ins : m_code)
+    {
+        *r++ = execute(ins, registers[ins.m_a], registers[ins.m_b], m_functions);
+    }
+    for (auto k = 0u; k < m_m; ++k)
+    {
+        out[k] = registers[m_outputs[k]];
+    }
+}
+
+/// Runs the program (same signature as dcgp::expression::operator())
+/**
+ * \param[in] in the n inputs
+ *
+ * \return the m outputs
+ *
+ * @throw dcgp::input_error if the number of inputs is wrong
+ */
+std::vector<double> program::operator()(const std::vector<double>& in) const
+{
+    if (in.size() != m_n)
+    {
+        throw input_error("Input size is incompatible");
+    }
+    std::vector<double> registers(get_registers());
+    std::vector<double> retval(m_m);
+    (*this)(in.data(), retval.data(), registers.data());
+    return retval;
+}
+
+/// Gets a listing of the program
+/**
+ * \return one line per instruction and one per output, e.g. "r3 = r0 * r1"
+ */
+std::string program::human_readable() const
+{
+    static const char *symbols[] = {"", " + ", " - ", " * ", " / "};
+    std::ostringstream os;
+    for (auto k = 0u; k < m_code.size(); ++k)
+    {
+        const instruction& ins = m_code[k];
+        const std::string a = "r" + std::to_string(ins.m_a), b = "r" + std::to_string(ins.m_b);
+        os << "r" << m_n + k << " = ";
+        switch (ins.m_op)
+        {
+            case OP_CONST: os << ins.m_value; break;
+            case OP_SUM: case OP_DIFF: case OP_MUL: case OP_DIV: os << a << symbols[ins.m_op] << b; break;
+            case OP_POW_ABS: os << "pow(|" << a << "|, " << b << ")"; break;
+            case OP_POW: os << "pow(" << a << ", " << b << ")"; break;
+            case OP_SQRT_ABS: os << "sqrt(|" << a << "|)"; break;
+            case OP_SQRT: os << "sqrt(" << a << ")"; break;
+            case OP_ABS: os << "|" << a << "|"; break;
+            case OP_CALL: os << m_functions[ins.m_function].m_name << "(" << a << ", " << b << ")"; break;
+        }
+        os << "\n";
+    }
+    for (auto k = 0u; k < m_m; ++k)
+    {
+        os << "y" << k << " = r" << m_outputs[k] << "\n";
+    }
+    return os.str();
+}
+
+} // end of namespace dcgp
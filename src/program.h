@@ -0,0 +1,87 @@
+#ifndef DCGP_PROGRAM_H
+#define DCGP_PROGRAM_H
+
+#include <string>
+#include <vector>
+
+#include "basis_function.h"
+#include "expression.h"
+
+namespace dcgp {
+
+enum optimization_level {
+    NO_OPTIMIZATION,        // one instruction per active node
+    EXACT_OPTIMIZATION,     // only rewrites giving the same outputs as the expression (NaNs may differ in sign and payload)
+    ALGEBRAIC_OPTIMIZATION  // also rewrites valid on the reals only (e.g. x - x = 0, x / x = 1), which may turn NaNs and infinities into numbers
+    };
+
+enum op_code {
+    OP_CONST,       // the constant m_value
+    OP_SUM,         // a + b
+    OP_DIFF,        // a - b
+    OP_MUL,         // a * b
+    OP_DIV,         // a / b
+    OP_POW_ABS,     // pow(|a|, b)
+    OP_POW,         // pow(a, b), a known to be non negative
+    OP_SQRT_ABS,    // sqrt(|a|)
+    OP_SQRT,        // sqrt(a), a known to be non negative
+    OP_ABS,         // |a|
+    OP_CALL         // the m_function-th basis function of the expression, called on a and b
+    };
+
+/// Instruction of a dcgp::program
+struct instruction
+{
+    op_code m_op;
+    // the registers of the arguments
+    unsigned int m_a;
+    unsigned int m_b;
+    // the constant (OP_CONST) or the index of the basis function (OP_CALL)
+    double m_value;
+    unsigned int m_function;
+};
+
+/// Straight-line program computing an expression
+/**
+ * The active graph of a dcgp::expression lowered to a sequence of instructions, each one writing its own register:
+ * registers 0 to n-1 hold the inputs and the k-th instruction writes register n + k.
+ *
+ * While lowering, the graph is optimized: common subexpressions are computed once (also when their arguments
+ * are swapped, for sums and products), constants are folded, identities (e.g. x * 1, pow(|x|, 1), the absolute value of
+ * a non negative value) are removed, and the instructions not contributing to the outputs are dropped (e.g. the
+ * nodes folded into constants). The chromosome of the expression is not modified.
+ *
+ * @author Dario Izzo (dario.izzo@gmail.com)
+ */
+class program {
+public:
+    program(const expression& ex, optimization_level level = EXACT_OPTIMIZATION);
+
+    std::vector<double> operator()(const std::vector<double>& in) const;
+    void operator()(const double *in, double *out, double *registers) const;
+
+    /// Gets the number of inputs
+    unsigned int get_n() const {return m_n;};
+    /// Gets the number of outputs
+    unsigned int get_m() const {return m_m;};
+    /// Gets the number of registers needed to run the program (inputs included)
+    std::size_t get_registers() const {return m_n + m_code.size();};
+    /// Gets the instructions
+    const std::vector<instruction>& get_instructions() const {return m_code;};
+    /// Gets the registers holding the outputs
+    const std::vector<unsigned int>& get_outputs() const {return m_outputs;};
+    /// Gets the basis functions called by OP_CALL instructions
+    const std::vector<basis_function>& get_functions() const {return m_functions;};
+    std::string human_readable() const;
+
+private:
+    unsigned int m_n;
+    unsigned int m_m;
+    std::vector<instruction> m_code;
+    std::vector<unsigned int> m_outputs;
+    std::vector<basis_function> m_functions;
+};
+
+} // end of namespace dcgp
+
+#endif // DCGP_PROGRAM_H
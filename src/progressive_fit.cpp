@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <numeric>
+
+#include "exceptions.h"
+#include "progressive_fit.h"
+
+namespace dcgp {
+
+/// Constructor
+/** Stratifies the dataset and draws the subsamples of the first generation
+ *
+ * \param[in] data the dataset
+ * \param[in] min_sample number of points of the first (smallest) subsample
+ * \param[in] eta ratio between the sizes of consecutive subsamples, and between the number of candidates evaluated on them
+ * \param[in] n_strata number of strata (quantiles of the first output)
+ * \param[in] type the fitness type
+ * \param[in] tol the tolerance for HITS_BASED fitness
+ * \param[in] seed seed for the random number generator drawing the subsamples
+ *
+ * @throw dcgp::input_error if min_sample or n_strata are zero or eta is smaller than 2
+ */
+progressive_fit::progressive_fit(const dataset& data, std::size_t min_sample, unsigned int eta, unsigned int n_strata, fitness_type type, double tol, unsigned int seed) :
+        m_data(data), m_min_sample(min_sample), m_eta(eta), m_type(type), m_tol(tol), m_sorted(data.rows()), m_point_evaluations(0u), m_e(seed)
+{
+    if (min_sample == 0u)
+    {
+        throw input_error("The smallest subsample must contain at least one point");
+    }
+    if (eta < 2u)
+    {
+        throw input_error("Subsamples must grow by a factor of at least 2");
+    }
+    if (n_strata == 0u)
+    {
+        throw input_error("Number of strata must be at least 1");
+    }
+    std::iota(m_sorted.begin(), m_sorted.end(), std::size_t(0u));
+    if (data.get_m() > 0u)
+    {
+        std::stable_sort(m_sorted.begin(), m_sorted.end(), [&data](std::size_t a, std::size_t b) {return data.out(a, 0u) < data.out(b, 0u);});
+    }
+    const std::size_t n_nonempty = std::max(std::size_t(1u), std::min<std::size_t>(n_strata, data.rows()));
+    for (auto j = 1u; j <= n_nonempty; ++j)
+    {
+        m_strata.push_back(data.rows() * j / n_nonempty);
+    }
+    new_generation();
+}
+
+/// Draws new subsamples
+/**
+ * The same subsamples are used by all the following evaluations, until the next call.
+ */
+void progressive_fit::new_generation()
+{
+    const std::size_t rows = m_data.rows();
+    // shuffles every stratum, its shuffled points are then taken in order
+    std::vector<std::size_t> shuffled(m_sorted);
+    std::size_t begin = 0u;
+    for (auto end : m_strata)
+    {
+        std::shuffle(shuffled.begin() + begin, shuffled.begin() + end, m_e);
+        begin = end;
+    }
+
+    m_sizes.clear();
+    m_order.clear();
+    m_order.reserve(rows);
+    std::vector<std::size_t> taken(m_strata.size(), 0u);
+    for (std::size_t target = std::min(m_min_sample, rows); m_order.size() < rows; target = std::min(target * m_eta, rows))
+    {
+        // each stratum contributes in proportion to its size
+        for (auto j = 0u; j < m_strata.size(); ++j)
+        {
+            const std::size_t first = (j == 0u) ? 0u : m_strata[j - 1];
+            const std::size_t quota = std::max(taken[j], (m_strata[j] * target) / rows - (first * target) / rows);
+            for (; taken[j] < quota; ++taken[j])
+            {
+                m_order.push_back(shuffled[first + taken[j]]);
+            }
+        }
+        m_sizes.push_back(m_order.size());
+    }
+}
+
+/// Evaluates a batch of candidates by successive halving
+/**
+ * \param[in] candidates the expressions
+ *
+ * \return the fitness of each candidate, that of dcgp::simple_data_fit up to rounding for those evaluated on the whole dataset
+ * (see dcgp::progressive_fit::get_evaluated_points)
+ * and estimated for the others
+ *
+ * @throw dcgp::input_error if a candidate is incompatible with the dataset
+ */
+std::vector<double> progressive_fit::operator()(const std::vector<expression>& candidates)
+{
+    std::vector<double> sums(candidates.size(), 0.);
+    std::vector<double> retval(candidates.size(), 0.);
+    m_evaluated.assign(candidates.size(), 0u);
+    std::vector<std::size_t> alive(candidates.size());
+    std::iota(alive.begin(), alive.end(), std::size_t(0u));
+
+    std::size_t begin = 0u;
+    for (auto k = 0u; k < m_sizes.size(); ++k)
+    {
+        const std::size_t end = m_sizes[k];
+        for (auto c : alive)
+        {
+            sums[c] += simple_data_fit(candidates[c], m_data, m_order.data() + begin, end - begin, m_type, m_tol);
+            retval[c] = sums[c] * static_cast<double>(m_data.rows()) / static_cast<double>(end);
+            m_evaluated[c] = end;
+        }
+        m_point_evaluations += static_cast<unsigned long long>(alive.size()) * (end - begin);
+        begin = end;
+
+        // the best 1/eta candidates move on to the next subsample
+        std::size_t keep = std::max(std::size_t(1u), (alive.size() + m_eta - 1u) / m_eta);
+        std::partial_sort(alive.begin(), alive.begin() + std::min(keep, alive.size()), alive.end(), [&sums](std::size_t a, std::size_t b) {return sums[a] > sums[b];});
+        alive.resize(std::min(keep, alive.size()));
+    }
+    return retval;
+}
+
+/// Evaluates a candidate on the whole dataset
+/**
+ * \param[in] ex the expression
+ *
+ * \return its fitness, as computed by dcgp::simple_data_fit
+ *
+ * @throw dcgp::input_error if the expression is incompatible with the dataset
+ */
+double progressive_fit::operator()(const expression& ex) const
+{
+    return simple_data_fit(ex, m_data, m_type, m_tol);
+}
+
+} // end of namespace dcgp
@@ -0,0 +1,77 @@
+#ifndef DCGP_PROGRESSIVE_FIT_H
+#define DCGP_PROGRESSIVE_FIT_H
+
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include "dataset.h"
+#include "expression.h"
+#include "fitness_functions.h"
+#include "rng.h"
+
+namespace dcgp {
+
+/// Progressive subsampled fitness evaluation
+/**
+ * Evaluates a batch of candidates (e.g. the offspring of one generation) by successive halving: all candidates
+ * are first evaluated on a small subsample of the dataset, then only the best 1/eta of them are evaluated on a
+ * subsample eta times larger, and so on up to the whole dataset. Most candidates are thus discarded after
+ * having been evaluated on a small fraction of the points.
+ *
+ * The subsamples are stratified on the first output (each one contains about the same fraction of every
+ * quantile of the output) and nested (each one contains the previous), so that moving a candidate
+ * to the next subsample only costs the evaluation of the new points. They are drawn again at each call to
+ * dcgp::progressive_fit::new_generation and stay fixed in between, so that all the candidates evaluated
+ * in the same generation are compared on the same points.
+ *
+ * The fitness of the candidates reaching the whole dataset equals that of dcgp::simple_data_fit up to rounding of
+ * the summation order.
+ * The fitness of the others is estimated by rescaling their fitness on the largest subsample they reached
+ * to the size of the dataset.
+ *
+ * @author Dario Izzo (dario.izzo@gmail.com)
+ */
+class progressive_fit {
+public:
+    progressive_fit(const dataset& data,
+            std::size_t min_sample = 1024u,
+            unsigned int eta = 2u,
+            unsigned int n_strata = 16u,
+            fitness_type type = ERROR_BASED,
+            double tol = 1e-10,
+            unsigned int seed = rng::get_seed()
+            );
+
+    void new_generation();
+    std::vector<double> operator()(const std::vector<expression>& candidates);
+    double operator()(const expression& ex) const;
+
+    /// Gets the sizes of the nested subsamples of the current generation (the last one is the whole dataset)
+    const std::vector<std::size_t>& get_sample_sizes() const {return m_sizes;};
+    /// Gets the number of points each candidate of the last batch was evaluated on
+    const std::vector<std::size_t>& get_evaluated_points() const {return m_evaluated;};
+    /// Gets the total number of point evaluations performed
+    unsigned long long get_point_evaluations() const {return m_point_evaluations;};
+
+private:
+    dataset m_data;
+    std::size_t m_min_sample;
+    unsigned int m_eta;
+    fitness_type m_type;
+    double m_tol;
+    // point indices sorted by their first output
+    std::vector<std::size_t> m_sorted;
+    // (exclusive) end of each stratum in m_sorted
+    std::vector<std::size_t> m_strata;
+    // point indices of the current generation, each subsample being a prefix
+    std::vector<std::size_t> m_order;
+    std::vector<std::size_t> m_sizes;
+    std::vector<std::size_t> m_evaluated;
+    unsigned long long m_point_evaluations;
+    std::default_random_engine m_e;
+};
+
+} // end of namespace dcgp
+
+#endif // DCGP_PROGRESSIVE_FIT_H
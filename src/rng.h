@@ -1,3 +1,6 @@
+#ifndef DCGP_RNG_H
+#define DCGP_RNG_H
+
 #include <random>
 namespace dcgp {
 class rng {
@@ -6,4 +9,6 @@ public:
 private:
 	static std::random_device m_rdev;
 };
-}
\ No newline at end of file
+}
+
+#endif // DCGP_RNG_H
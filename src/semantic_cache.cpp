@@ -0,0 +1,289 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include "exceptions.h"
+#include "semantic_cache.h"
+
+namespace dcgp {
+
+namespace {
+// Evicted columns kept for reuse
+const std::size_t max_pooled_columns = 16u;
+
+inline std::uint64_t mix(std::uint64_t h, std::uint64_t v)
+{
+    h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    return h;
+}
+
+std::uint64_t hash_column(const std::vector<double>& values)
+{
+    std::uint64_t h = 0xcbf29ce484222325ull;
+    for (auto v : values)
+    {
+        std::uint64_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        h = mix(h, bits);
+    }
+    return h;
+}
+}
+
+std::size_t semantic_cache::node_key_hash::operator()(const node_key& k) const noexcept
+{
+    return static_cast<std::size_t>(mix(mix(k.m_function, k.m_a), k.m_b));
+}
+
+/// Constructor
+/** Creates an empty cache for a dataset, copying the columns of its inputs
+ *
+ * \param[in] data the dataset (its storage is shared, not copied)
+ * \param[in] f the function set of the expressions to be evaluated
+ * \param[in] max_bytes memory the cached columns may use (the inputs excluded)
+ *
+ * @throw dcgp::input_error if the dataset is empty or max_bytes cannot hold one column
+ */
+semantic_cache::semantic_cache(const dataset& data, const std::vector<basis_function>& f, std::size_t max_bytes)
+    : m_data(data), m_max_bytes(max_bytes), m_next_id(data.get_n()), m_bytes(0u), m_hits(0u), m_misses(0u), m_merged(0u)
+{
+    if (data.rows() == 0u)
+    {
+        throw input_error("Dataset is empty");
+    }
+    if (max_bytes < data.rows() * sizeof(double))
+    {
+        throw input_error("Cache size cannot hold one column");
+    }
+    for (const auto &b : f)
+    {
+        m_functions.push_back(b.m_name);
+    }
+    for (auto j = 0u; j < data.get_n(); ++j)
+    {
+        std::shared_ptr<std::vector<double> > values = std::make_shared<std::vector<double> >(data.rows());
+        const strided_view col = data.column(j);
+        for (auto i = 0u; i < data.rows(); ++i)
+        {
+            (*values)[i] = col[i];
+        }
+        m_inputs.push_back(values);
+    }
+}
+
+/// Computes the columns of the outputs of an expression, reusing the cached columns of its nodes
+/**
+ * The columns of the active nodes not found in the cache are computed, each value as in dcgp::expression::eval_into,
+ * and cached. The returned columns stay valid after they are evicted from the cache.
+ *
+ * \param[in] ex the expression
+ *
+ * \return the column of each output
+ *
+ * @throw dcgp::input_error if the expression does not have the inputs of the dataset or uses another function set
+ */
+std::vector<semantic_cache::column> semantic_cache::evaluate(const expression& ex)
+{
+    if (ex.get_n() != m_data.get_n())
+    {
+        throw input_error("Dataset is incompatible with the expression inputs");
+    }
+    const std::vector<basis_function>& f = ex.get_f();
+    if (f.size() != m_functions.size() || !std::equal(f.begin(), f.end(), m_functions.begin(), [](const basis_function& b, const std::string& name) {return b.m_name == name;}))
+    {
+        throw input_error("Expression uses another function set");
+    }
+    const std::vector<unsigned int>& x = ex.get();
+    const unsigned int n = ex.get_n();
+    const std::size_t rows = m_data.rows();
+    std::vector<std::uint64_t> ids(n + ex.get_r() * ex.get_c());
+    std::vector<column> columns(ids.size());
+
+    // the lock is released only while computing a column
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (auto i : ex.get_active_nodes())
+    {
+        if (i < n)
+        {
+            ids[i] = i;
+            columns[i] = m_inputs[i];
+            continue;
+        }
+        const unsigned int idx = (i - n) * 3u;
+        const basis_function& fun = f[x[idx]];
+        // unary functions ignore their second argument
+        const unsigned int b = (fun.m_arity > 1u) ? x[idx + 2u] : x[idx + 1u];
+        const node_key key{x[idx], ids[x[idx + 1u]], ids[b]};
+        auto k = m_keys.find(key);
+        if (k != m_keys.end())
+        {
+            entry& e = m_columns.at(k->second);
+            m_lru.splice(m_lru.begin(), m_lru, e.m_lru);
+            ids[i] = k->second;
+            columns[i] = e.m_column;
+            ++m_hits;
+            continue;
+        }
+        ++m_misses;
+        std::shared_ptr<std::vector<double> > values = allocate();
+        lock.unlock();
+        values->resize(rows);
+        const double *a = columns[x[idx + 1u]]->data(), *bv = columns[b]->data();
+        double *dst = values->data();
+        for (auto r = 0u; r < rows; ++r)
+        {
+            dst[r] = fun(a[r], bv[r]);
+        }
+        const std::uint64_t h = hash_column(*values);
+        lock.lock();
+        ids[i] = insert(key, std::move(values), h, columns[i]);
+    }
+    lock.unlock();
+
+    std::vector<column> retval(ex.get_m());
+    for (auto j = 0u; j < ex.get_m(); ++j)
+    {
+        retval[j] = columns[x[ex.get_r() * ex.get_c() * 3u + j]];
+    }
+    return retval;
+}
+
+/// Empties the cache (the columns of the inputs excluded), keeping the statistics
+void semantic_cache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_keys.clear();
+    m_columns.clear();
+    m_by_hash.clear();
+    m_lru.clear();
+    m_bytes = 0u;
+}
+
+unsigned long semantic_cache::get_hits() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_hits;
+}
+
+unsigned long semantic_cache::get_misses() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_misses;
+}
+
+unsigned long semantic_cache::get_merged() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_merged;
+}
+
+std::size_t semantic_cache::get_columns() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_columns.size();
+}
+
+std::size_t semantic_cache::get_keys() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_keys.size();
+}
+
+std::size_t semantic_cache::get_bytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bytes;
+}
+
+// Gets the memory for a column, from the pool if possible. Called with the lock held
+std::shared_ptr<std::vector<double> > semantic_cache::allocate()
+{
+    if (m_pool.empty())
+    {
+        return std::make_shared<std::vector<double> >();
+    }
+    std::shared_ptr<std::vector<double> > retval = std::move(m_pool.back());
+    m_pool.pop_back();
+    return retval;
+}
+
+// Caches a computed column of hash h, or merges it with an equal cached one. Returns its id, and the cached column.
+// Called with the lock held
+std::uint64_t semantic_cache::insert(const node_key& key, std::shared_ptr<std::vector<double> > values, std::uint64_t h, column& cached)
+{
+    auto range = m_by_hash.equal_range(h);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        entry& e = m_columns.at(it->second);
+        if (std::memcmp(e.m_column->data(), values->data(), values->size() * sizeof(double)) == 0)
+        {
+            m_lru.splice(m_lru.begin(), m_lru, e.m_lru);
+            bind(key, it->second);
+            cached = e.m_column;
+            ++m_merged;
+            if (m_pool.size() < max_pooled_columns) m_pool.push_back(std::move(values));
+            return it->second;
+        }
+    }
+    const std::uint64_t id = m_next_id++;
+    m_lru.push_front(id);
+    m_columns[id] = entry{values, h, m_lru.begin(), std::vector<node_key>()};
+    m_by_hash.emplace(h, id);
+    bind(key, id);
+    m_bytes += values->size() * sizeof(double);
+    cached = std::move(values);
+    evict();
+    return id;
+}
+
+// Makes a node key lead to a cached column. Called with the lock held
+void semantic_cache::bind(const node_key& key, std::uint64_t id)
+{
+    auto k = m_keys.find(key);
+    if (k != m_keys.end())
+    {
+        if (k->second == id) return;
+        // computed concurrently into another column
+        std::vector<node_key>& keys = m_columns.at(k->second).m_keys;
+        keys.erase(std::find(keys.begin(), keys.end(), key));
+        k->second = id;
+    } else {
+        m_keys.emplace(key, id);
+    }
+    m_columns.at(id).m_keys.push_back(key);
+}
+
+// Evicts the least recently used columns until the cache fits its memory. Called with the lock held
+void semantic_cache::evict()
+{
+    while (m_bytes > m_max_bytes && m_lru.size() > 1u)
+    {
+        const std::uint64_t id = m_lru.back();
+        m_lru.pop_back();
+        auto c = m_columns.find(id);
+        auto range = m_by_hash.equal_range(c->second.m_hash);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (it->second == id)
+            {
+                m_by_hash.erase(it);
+                break;
+            }
+        }
+        for (const auto &key : c->second.m_keys)
+        {
+            m_keys.erase(key);
+        }
+        m_bytes -= c->second.m_column->size() * sizeof(double);
+        // the memory is reused only if no evaluation holds the column: the fence orders the reuse after the
+        // reads of the evaluations which released it (use_count is a relaxed load)
+        if (c->second.m_column.use_count() == 1 && m_pool.size() < max_pooled_columns)
+        {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            m_pool.push_back(std::move(c->second.m_column));
+        }
+        m_columns.erase(c);
+    }
+}
+
+} // end of namespace dcgp
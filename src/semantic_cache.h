@@ -0,0 +1,109 @@
+#ifndef DCGP_SEMANTIC_CACHE_H
+#define DCGP_SEMANTIC_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "dataset.h"
+#include "expression.h"
+
+namespace dcgp {
+
+/// Population-wide cache of the values of the nodes on a dataset
+/**
+ * The values a node takes on all the points of the dataset (its column) only depend on its function and on the
+ * columns of its arguments. Each distinct column gets a semantic id (the inputs have ids 0 to n-1) and each node is
+ * keyed structurally by (function, semantic ids of its arguments), so that the nodes of different expressions
+ * computing the same sub-expression, whatever their position in the chromosome, share one column. Columns which
+ * turn out to be equal to a cached one (compared by hash, then bit by bit) are merged under the same id, so that
+ * also different sub-expressions having the same values (e.g. x + y and y + x) share the nodes built on them.
+ *
+ * The columns are kept in a pool bounded in bytes, the least recently used ones being evicted first together with
+ * the keys of the nodes leading to them, and the memory of evicted columns is reused. The cache is safe to use
+ * concurrently, e.g. by the threads of dcgp::steady_state through a fitness function calling dcgp::simple_data_fit
+ * with the cache: an evaluation takes the lock once to look up its nodes, and once more per column it computes
+ * (outside the lock). All expressions must use the same function set.
+ *
+ * @author Dario Izzo (dario.izzo@gmail.com)
+ */
+class semantic_cache {
+public:
+    /// A column of values, one per point of the dataset
+    using column = std::shared_ptr<const std::vector<double> >;
+
+    semantic_cache(const dataset& data, const std::vector<basis_function>& f, std::size_t max_bytes = 256u << 20);
+
+    std::vector<column> evaluate(const expression& ex);
+    void clear();
+
+    /// Gets the dataset
+    const dataset& get_data() const {return m_data;};
+    /// Gets the number of nodes whose column was found in the cache
+    unsigned long get_hits() const;
+    /// Gets the number of nodes whose column had to be computed
+    unsigned long get_misses() const;
+    /// Gets the number of computed columns which were equal to a cached one
+    unsigned long get_merged() const;
+    /// Gets the number of cached columns (the inputs excluded)
+    std::size_t get_columns() const;
+    /// Gets the number of node keys leading to the cached columns
+    std::size_t get_keys() const;
+    /// Gets the memory used by the cached columns, in bytes
+    std::size_t get_bytes() const;
+
+private:
+    // a node: its function and the semantic ids of its arguments
+    struct node_key
+    {
+        std::uint64_t m_function;
+        std::uint64_t m_a;
+        std::uint64_t m_b;
+        bool operator==(const node_key& other) const {return m_function == other.m_function && m_a == other.m_a && m_b == other.m_b;};
+    };
+    struct node_key_hash
+    {
+        std::size_t operator()(const node_key& k) const noexcept;
+    };
+    struct entry
+    {
+        std::shared_ptr<std::vector<double> > m_column;
+        std::uint64_t m_hash;
+        std::list<std::uint64_t>::iterator m_lru;
+        // the keys of the nodes leading to the column, evicted with it
+        std::vector<node_key> m_keys;
+    };
+
+    std::shared_ptr<std::vector<double> > allocate();
+    std::uint64_t insert(const node_key& key, std::shared_ptr<std::vector<double> > values, std::uint64_t h, column& cached);
+    void bind(const node_key& key, std::uint64_t id);
+    void evict();
+
+    dataset m_data;
+    std::vector<std::string> m_functions;
+    std::size_t m_max_bytes;
+    mutable std::mutex m_mutex;
+    // the columns of the inputs, never evicted
+    std::vector<column> m_inputs;
+    std::unordered_map<node_key, std::uint64_t, node_key_hash> m_keys;
+    std::unordered_map<std::uint64_t, entry> m_columns;
+    std::unordered_multimap<std::uint64_t, std::uint64_t> m_by_hash;
+    // the ids of the cached columns, most recently used first
+    std::list<std::uint64_t> m_lru;
+    // the memory of evicted columns, to be reused
+    std::vector<std::shared_ptr<std::vector<double> > > m_pool;
+    std::uint64_t m_next_id;
+    std::size_t m_bytes;
+    unsigned long m_hits;
+    unsigned long m_misses;
+    unsigned long m_merged;
+};
+
+} // end of namespace dcgp
+
+#endif // DCGP_SEMANTIC_CACHE_H
@@ -0,0 +1,153 @@
+#ifndef DCGP_SPSC_QUEUE_H
+#define DCGP_SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace dcgp {
+
+/// Bounded lock-free single-producer / single-consumer queue
+/**
+ * A fixed capacity ring buffer that can be safely used by exactly one producer thread
+ * and one consumer thread at the same time. Neither dcgp::spsc_queue::push nor
+ * dcgp::spsc_queue::pop ever block: a push on a full queue and a pop on an empty
+ * queue simply return false, leaving the decision on what to do (drop, retry, ...) to the caller.
+ *
+ * @author Dario Izzo (dario.izzo@gmail.com)
+ */
+template <typename T>
+class spsc_queue
+{
+public:
+    /// Constructor
+    /**
+     * \param[in] capacity maximum number of elements the queue can hold
+     */
+    explicit spsc_queue(std::size_t capacity) : m_buffer(capacity + 1u), m_head(0u), m_tail(0u) {}
+
+    /// Constructor from a prototype element
+    /**
+     * Every slot starts as a copy of the prototype, so that elements owning memory (e.g. vectors) can be
+     * assigned in place through dcgp::spsc_queue::claim without allocating.
+     *
+     * \param[in] capacity maximum number of elements the queue can hold
+     * \param[in] prototype the initial value of the slots
+     */
+    spsc_queue(std::size_t capacity, const T &prototype) : m_buffer(capacity + 1u, prototype), m_head(0u), m_tail(0u) {}
+
+    /// Pushes an element (producer side)
+    /**
+     * \param[in] value the element to be moved into the queue
+     *
+     * \return false if the queue is full (the element is then left untouched), true otherwise
+     */
+    bool push(T &&value)
+    {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        const std::size_t next = increment(tail);
+        if (next == m_head.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        m_buffer[tail] = std::move(value);
+        m_tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    /// Pushes a copy of an element (producer side)
+    bool push(const T &value)
+    {
+        T copy(value);
+        return push(std::move(copy));
+    }
+
+    /// Pops an element (consumer side)
+    /**
+     * \param[out] value where the front element is moved to
+     *
+     * \return false if the queue is empty, true otherwise
+     */
+    bool pop(T &value)
+    {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        value = std::move(m_buffer[head]);
+        m_head.store(increment(head), std::memory_order_release);
+        return true;
+    }
+
+    /// Gets the free slot at the back of the queue (producer side)
+    /**
+     * The slot keeps the storage of the element last popped from it: it is filled in place and then made visible
+     * to the consumer by dcgp::spsc_queue::publish.
+     *
+     * \return the slot, or nullptr if the queue is full
+     */
+    T *claim()
+    {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (increment(tail) == m_head.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+        return &m_buffer[tail];
+    }
+
+    /// Pushes the slot returned by dcgp::spsc_queue::claim (producer side)
+    void publish()
+    {
+        m_tail.store(increment(m_tail.load(std::memory_order_relaxed)), std::memory_order_release);
+    }
+
+    /// Gets the front element in place (consumer side)
+    /**
+     * \return the front element, or nullptr if the queue is empty. It stays in the queue until dcgp::spsc_queue::release
+     */
+    T *front()
+    {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+        return &m_buffer[head];
+    }
+
+    /// Pops the element returned by dcgp::spsc_queue::front, leaving its storage in the slot (consumer side)
+    void release()
+    {
+        m_head.store(increment(m_head.load(std::memory_order_relaxed)), std::memory_order_release);
+    }
+
+    /// Checks whether the queue is empty (only approximate if called concurrently)
+    bool empty() const
+    {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+    /// Gets the capacity of the queue
+    std::size_t capacity() const {return m_buffer.size() - 1u;}
+
+private:
+    std::size_t increment(std::size_t idx) const
+    {
+        return (idx + 1u == m_buffer.size()) ? 0u : idx + 1u;
+    }
+
+    std::vector<T> m_buffer;
+    // head and tail are padded onto separate cache lines to avoid false sharing between producer and consumer
+    char m_pad0[64];
+    std::atomic<std::size_t> m_head;
+    char m_pad1[64];
+    std::atomic<std::size_t> m_tail;
+    char m_pad2[64];
+};
+
+} // end of namespace dcgp
+
+#endif // DCGP_SPSC_QUEUE_H
@@ -0,0 +1,339 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#include "steady_state.h"
+#include "exceptions.h"
+#include "jit.h"
+
+namespace dcgp {
+
+namespace {
+// Fitness used to rank the individuals: NaN is the worst
+inline double ranked(double f)
+{
+    return std::isnan(f) ? -std::numeric_limits<double>::infinity() : f;
+}
+}
+
+/// Acquires the individual spinlock
+void steady_state::individual::lock()
+{
+    while (m_lock.exchange(true, std::memory_order_acquire))
+    {
+        std::this_thread::yield();
+    }
+}
+
+/// Releases the individual spinlock
+void steady_state::individual::unlock()
+{
+    m_lock.store(false, std::memory_order_release);
+}
+
+/// Constructor
+/** Constructs a steady-state engine and its initial population of random expressions having the same
+ * topology (inputs, outputs, rows, columns, levels-back, functions) as the prototype
+ *
+ * \param[in] prototype expression defining the topology of all individuals
+ * \param[in] fitness the fitness to be maximized. It must be safe to call concurrently
+ * \param[in] pop_size the population size
+ * \param[in] n_threads number of worker threads
+ * \param[in] tournament_size number of individuals competing in each tournament (at least 2)
+ * \param[in] seed seed for the random number generator (initial population and mutations depend on this)
+ *
+ * @throw dcgp::input_error if the population size or the number of threads are 0, or the tournament size is not in [2, pop_size]
+ */
+steady_state::steady_state(const expression& prototype,
+        fitness_function fitness,
+        unsigned int pop_size,
+        unsigned int n_threads,
+        unsigned int tournament_size,
+        unsigned int seed
+        ) : m_prototype(prototype), m_fitness(fitness), m_tournament_size(tournament_size), m_n_threads(n_threads), m_population(pop_size), m_stop(false), m_evaluations(0u), m_insertions(0u), m_total_evaluations(0u), m_e(seed), m_telemetry(), m_telemetry_interval(1000u), m_cache(nullptr)
+{
+    if (pop_size == 0) throw input_error("Population size is 0");
+    if (n_threads == 0) throw input_error("Number of threads is 0");
+    if (tournament_size < 2 || tournament_size > pop_size) throw input_error("Tournament size must be in [2, population size]");
+
+    for (auto &ind : m_population)
+    {
+        expression ex(prototype.get_topology(), m_e());
+        ind.m_chromosome = ex.get();
+        ind.m_fitness = m_fitness(ex);
+    }
+}
+
+/// Constructor from a checkpoint
+/** Resumes a steady-state engine from a checkpoint as returned by dcgp::steady_state::get_checkpoint
+ *
+ * \param[in] cp the checkpoint
+ * \param[in] fitness the fitness to be maximized. It must be safe to call concurrently
+ * \param[in] n_threads number of worker threads
+ * \param[in] tournament_size number of individuals competing in each tournament (at least 2)
+ *
+ * @throw dcgp::input_error if the checkpoint is invalid, if the number of threads is 0 or the tournament size is not in [2, pop_size]
+ */
+steady_state::steady_state(const checkpoint& cp,
+        fitness_function fitness,
+        unsigned int n_threads,
+        unsigned int tournament_size
+        ) : m_prototype(make_expression(cp, 0u)), m_fitness(fitness), m_tournament_size(tournament_size), m_n_threads(n_threads), m_population(cp.size()), m_stop(false), m_evaluations(0u), m_insertions(0u), m_total_evaluations(cp.m_generation), m_e(), m_telemetry(), m_telemetry_interval(1000u), m_cache(nullptr)
+{
+    if (cp.size() == 0) throw input_error("Population size is 0");
+    if (n_threads == 0) throw input_error("Number of threads is 0");
+    if (tournament_size < 2 || tournament_size > cp.size()) throw input_error("Tournament size must be in [2, population size]");
+
+    std::istringstream ss(cp.m_rng_state);
+    ss >> m_e;
+    if (!ss) throw input_error("Invalid random engine state in checkpoint");
+
+    for (auto i = 0u; i < m_population.size(); ++i)
+    {
+        // set checks the chromosome against the topology bounds
+        m_prototype.set(cp.get_chromosome(i));
+        m_population[i].m_chromosome = m_prototype.get();
+        m_population[i].m_fitness = cp.m_fitness[i];
+    }
+}
+
+/// Evolves the population
+/**
+ * Runs the worker threads until one of them finds an individual reaching the target fitness or
+ * max_evals fitness evaluations have been performed overall. The population is kept across calls.
+ * The iterations evaluating nothing (a tournament won and lost by the same individual, or a mutation leaving
+ * the chromosome untouched) count toward max_evals, so that evolve returns even if the population has NaN fitness
+ * only or no gene can be mutated.
+ *
+ * \param[in] max_evals maximum number of fitness evaluations (split evenly among the workers)
+ * \param[in] target target fitness
+ *
+ * \return true if the target fitness was reached
+ */
+bool steady_state::evolve(unsigned long max_evals, double target)
+{
+    m_stop = false;
+    m_worker_evaluations.assign(m_n_threads, 0u);
+    m_worker_insertions.assign(m_n_threads, 0u);
+
+    std::vector<std::thread> threads;
+    threads.reserve(m_n_threads);
+    for (auto t = 0u; t < m_n_threads; ++t)
+    {
+        unsigned long share = max_evals / m_n_threads + ((t < max_evals % m_n_threads) ? 1u : 0u);
+        threads.emplace_back(&steady_state::run_worker, this, t, m_e(), share, target);
+    }
+    for (auto &th : threads)
+    {
+        th.join();
+    }
+
+    m_evaluations = 0u;
+    m_insertions = 0u;
+    for (auto t = 0u; t < m_n_threads; ++t)
+    {
+        m_evaluations += m_worker_evaluations[t];
+        m_insertions += m_worker_insertions[t];
+    }
+    m_total_evaluations += m_evaluations;
+    return get_best_fitness() >= target;
+}
+
+/// Gets the chromosome of the best individual in the population
+std::vector<unsigned int> steady_state::get_best_chromosome() const
+{
+    unsigned int best = 0u;
+    for (auto i = 1u; i < m_population.size(); ++i)
+    {
+        if (m_population[i].m_fitness > m_population[best].m_fitness) best = i;
+    }
+    return m_population[best].m_chromosome;
+}
+
+/// Gets the fitness of the best individual in the population
+double steady_state::get_best_fitness() const
+{
+    double retval = -std::numeric_limits<double>::infinity();
+    for (const auto &ind : m_population)
+    {
+        if (ind.m_fitness > retval) retval = ind.m_fitness;
+    }
+    return retval;
+}
+
+/// Gets the chromosomes of the whole population (not to be called while evolving)
+std::vector<std::vector<unsigned int> > steady_state::get_chromosomes() const
+{
+    std::vector<std::vector<unsigned int> > retval;
+    for (const auto &ind : m_population)
+    {
+        retval.push_back(ind.m_chromosome);
+    }
+    return retval;
+}
+
+/// Gets the fitness of the whole population (not to be called while evolving)
+std::vector<double> steady_state::get_fitness() const
+{
+    std::vector<double> retval;
+    for (const auto &ind : m_population)
+    {
+        retval.push_back(ind.m_fitness);
+    }
+    return retval;
+}
+
+/// Gets a checkpoint of the engine (not to be called while evolving)
+/**
+ * The checkpoint contains the population, the random engine state, the total number of evaluations
+ * (stored as generation) and the best fitness, and can be used to resume the engine with the constructor
+ * from a dcgp::checkpoint
+ *
+ * \return the dcgp::checkpoint
+ */
+checkpoint steady_state::get_checkpoint() const
+{
+    checkpoint retval = make_checkpoint(m_prototype);
+    retval.m_chromosomes.reserve(m_population.size() * retval.chromosome_length());
+    for (const auto &ind : m_population)
+    {
+        retval.push_back(ind.m_chromosome, ind.m_fitness);
+    }
+    std::ostringstream ss;
+    ss << m_e;
+    retval.m_rng_state = ss.str();
+    retval.m_generation = m_total_evaluations;
+    retval.m_best_fitness = get_best_fitness();
+    return retval;
+}
+
+/// Sends the progress of the workers to a telemetry log
+/**
+ * Every interval evaluations, each worker pushes a dcgp::telemetry_record (the best and mean fitness of the population,
+ * the active sizes of its offspring, its evaluations and their rate) to the logger, as producer t for worker t.
+ * Pushing never blocks the workers.
+ *
+ * \param[in] logger the logger, null to disable telemetry
+ * \param[in] interval number of evaluations of a worker between two of its records
+ * \param[in] cache the cache of compiled expressions used by the fitness (see dcgp::jit_fitness), if any, whose hits and misses are recorded
+ *
+ * @throw dcgp::input_error if the logger has less producers than workers or interval is 0
+ */
+void steady_state::set_telemetry(std::shared_ptr<telemetry_logger> logger, unsigned long interval, const jit_cache *cache)
+{
+    if (logger && logger->get_n_producers() < m_n_threads)
+    {
+        throw input_error("The telemetry logger needs one producer per worker");
+    }
+    if (interval == 0u)
+    {
+        throw input_error("Telemetry interval is 0");
+    }
+    m_telemetry = std::move(logger);
+    m_telemetry_interval = interval;
+    m_cache = cache;
+}
+
+/// Runs the tournament / mutate / evaluate / replace loop of one worker (called on its own thread)
+void steady_state::run_worker(unsigned int t, unsigned int seed, unsigned long max_evals, double target)
+{
+    std::default_random_engine e(seed);
+    std::uniform_int_distribution<unsigned int> pick(0u, static_cast<unsigned int>(m_population.size() - 1u));
+    expression ex(m_prototype.get_topology(), e());
+    std::vector<unsigned int> parent;
+    // skipped counts the iterations which evaluate nothing, so that the loop always ends
+    unsigned long evals = 0u, skipped = 0u, insertions = 0u;
+    telemetry_window window;
+    const double start = m_telemetry ? m_telemetry->elapsed() : 0.;
+
+    while (evals + skipped < max_evals && !m_stop.load(std::memory_order_relaxed))
+    {
+        // Tournament: the fitness is read lock-free, the chromosome under the winner lock
+        unsigned int winner = pick(e);
+        unsigned int loser = winner;
+        for (auto k = 1u; k < m_tournament_size; ++k)
+        {
+            unsigned int i = pick(e);
+            double f = ranked(m_population[i].m_fitness.load(std::memory_order_relaxed));
+            if (f > ranked(m_population[winner].m_fitness.load(std::memory_order_relaxed))) winner = i;
+            if (f <= ranked(m_population[loser].m_fitness.load(std::memory_order_relaxed))) loser = i;
+        }
+        if (winner == loser)
+        {
+            ++skipped;
+            continue;
+        }
+
+        m_population[winner].lock();
+        parent = m_population[winner].m_chromosome;
+        m_population[winner].unlock();
+
+        ex.set(parent);
+        ex.mutate_active();
+        // mutating a gene that admits one value only leaves the chromosome untouched: clones would just erode diversity
+        if (ex.get() == parent)
+        {
+            ++skipped;
+            continue;
+        }
+        double f = m_fitness(ex);
+        ++evals;
+        if (m_telemetry) window.add(ex.get_active_nodes().size(), f);
+
+        // Replacement: the loser fitness is checked again under its lock as another worker may have replaced it
+        individual &ind = m_population[loser];
+        ind.lock();
+        if (ranked(f) >= ranked(ind.m_fitness.load(std::memory_order_relaxed)))
+        {
+            ind.m_chromosome = ex.get();
+            ind.m_fitness.store(f, std::memory_order_relaxed);
+            ++insertions;
+        }
+        ind.unlock();
+
+        if (f >= target)
+        {
+            m_stop = true;
+        }
+
+        if (m_telemetry && evals % m_telemetry_interval == 0u)
+        {
+            telemetry_record r = telemetry_record();
+            r.m_source = t;
+            r.m_generation = evals;
+            r.m_time = m_telemetry->elapsed();
+            window.fill(r);
+            // the fitness of the population is read lock-free
+            double best = -std::numeric_limits<double>::infinity(), sum = 0.;
+            unsigned long finite = 0u;
+            for (const auto &other : m_population)
+            {
+                const double fit = other.m_fitness.load(std::memory_order_relaxed);
+                best = std::max(best, fit);
+                if (std::isfinite(fit))
+                {
+                    sum += fit;
+                    ++finite;
+                }
+            }
+            r.m_best_fitness = best;
+            r.m_mean_fitness = finite ? sum / static_cast<double>(finite) : std::numeric_limits<double>::quiet_NaN();
+            r.m_evaluations = evals;
+            // the clock may not have advanced since the start of the run
+            r.m_evaluations_per_second = (r.m_time > start) ? static_cast<double>(evals) / (r.m_time - start) : std::numeric_limits<double>::quiet_NaN();
+            if (m_cache)
+            {
+                r.m_cache_hits = m_cache->get_hits();
+                r.m_cache_misses = m_cache->get_misses();
+            }
+            m_telemetry->push(t, r);
+        }
+    }
+    m_worker_evaluations[t] = evals;
+    m_worker_insertions[t] = insertions;
+}
+
+} // end of namespace dcgp
@@ -0,0 +1,99 @@
+#ifndef DCGP_STEADY_STATE_H
+#define DCGP_STEADY_STATE_H
+
+#include <atomic>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "checkpoint.h"
+#include "expression.h"
+#include "fitness_functions.h"
+#include "rng.h"
+#include "telemetry.h"
+
+namespace dcgp {
+
+class jit_cache;
+
+/// Steady-state asynchronous evolution
+/**
+ * Evolves one shared population of dcgp::expression using several worker threads and no generations.
+ * Each worker repeatedly runs a tournament among a few random individuals, mutates (dcgp::expression::mutate_active)
+ * a copy of the winner, evaluates it and lets it replace the loser of the same tournament if it is not worse.
+ *
+ * Every individual is guarded by its own spinlock and its fitness can be read lock-free, so workers only
+ * ever contend on the few individuals they are touching: there is no barrier and no global lock,
+ * and a slow offspring (e.g. with a large active graph) never stalls the other workers.
+ *
+ * @author Dario Izzo (dario.izzo@gmail.com)
+ */
+class steady_state {
+public:
+    steady_state(const expression& prototype,
+            fitness_function fitness,
+            unsigned int pop_size,
+            unsigned int n_threads,
+            unsigned int tournament_size = 4,
+            unsigned int seed = rng::get_seed()
+            );
+    steady_state(const checkpoint& cp,
+            fitness_function fitness,
+            unsigned int n_threads,
+            unsigned int tournament_size = 4
+            );
+
+    bool evolve(unsigned long max_evals, double target);
+
+    std::vector<unsigned int> get_best_chromosome() const;
+    double get_best_fitness() const;
+    /// Gets the number of fitness evaluations performed in the last call to evolve
+    unsigned long get_evaluations() const {return m_evaluations;};
+    /// Gets the number of fitness evaluations performed since the engine was created (including resumed runs)
+    unsigned long get_total_evaluations() const {return m_total_evaluations;};
+    /// Gets the number of offspring that entered the population in the last call to evolve
+    unsigned long get_insertions() const {return m_insertions;};
+    /// Gets the population size
+    unsigned int get_pop_size() const {return static_cast<unsigned int>(m_population.size());};
+    std::vector<std::vector<unsigned int> > get_chromosomes() const;
+    std::vector<double> get_fitness() const;
+    checkpoint get_checkpoint() const;
+    void set_telemetry(std::shared_ptr<telemetry_logger> logger, unsigned long interval = 1000u, const jit_cache *cache = nullptr);
+
+private:
+    struct individual
+    {
+        individual() : m_fitness(0.), m_lock(false) {}
+        void lock();
+        void unlock();
+        std::vector<unsigned int> m_chromosome;
+        std::atomic<double> m_fitness;
+        std::atomic<bool> m_lock;
+        // pads individuals onto different cache lines
+        char m_pad[64];
+    };
+
+    void run_worker(unsigned int t, unsigned int seed, unsigned long max_evals, double target);
+
+    expression m_prototype;
+    fitness_function m_fitness;
+    unsigned int m_tournament_size;
+    unsigned int m_n_threads;
+    std::vector<individual> m_population;
+    std::vector<unsigned long> m_worker_evaluations;
+    std::vector<unsigned long> m_worker_insertions;
+    std::atomic<bool> m_stop;
+    unsigned long m_evaluations;
+    unsigned long m_insertions;
+    unsigned long m_total_evaluations;
+    // the random engine seeding the workers
+    std::default_random_engine m_e;
+    // telemetry (worker t is producer t), disabled if null
+    std::shared_ptr<telemetry_logger> m_telemetry;
+    unsigned long m_telemetry_interval;
+    const jit_cache *m_cache;
+};
+
+} // end of namespace dcgp
+
+#endif // DCGP_STEADY_STATE_H
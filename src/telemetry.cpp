@@ -0,0 +1,213 @@
+#include <cstring>
+#include <fstream>
+
+#include "exceptions.h"
+#include "telemetry.h"
+
+namespace dcgp {
+
+namespace {
+// Header of the binary telemetry logs: magic, byte order mark, version and size of the records that follow it
+struct telemetry_header
+{
+    char m_magic[8];
+    std::uint32_t m_byte_order;
+    std::uint32_t m_version;
+    std::uint32_t m_record_size;
+    std::uint32_t m_reserved;
+};
+
+const char telemetry_magic[8] = {'D', 'C', 'G', 'P', 'T', 'L', 'M', 'Y'};
+const std::uint32_t telemetry_byte_order = 0x01020304u;
+const std::uint32_t telemetry_version = 1u;
+
+void write_csv(std::FILE *file, const telemetry_record& r)
+{
+    std::fprintf(file, "%u,%llu,%.17g,%.17g,%.17g,%.17g,%.17g,%.17g,%llu,%.17g,%llu,%llu\n", r.m_source,
+                 static_cast<unsigned long long>(r.m_generation), r.m_time, r.m_best_fitness, r.m_mean_fitness,
+                 r.m_active_min, r.m_active_mean, r.m_active_max, static_cast<unsigned long long>(r.m_evaluations),
+                 r.m_evaluations_per_second, static_cast<unsigned long long>(r.m_cache_hits), static_cast<unsigned long long>(r.m_cache_misses));
+}
+}
+
+/// Constructor
+/** Creates the log file and starts the consumer thread
+ *
+ * \param[in] filename the log file (overwritten)
+ * \param[in] n_producers number of producers, each one having its own queue
+ * \param[in] format CSV or binary
+ * \param[in] capacity number of records each queue can hold
+ *
+ * @throw dcgp::input_error if n_producers or capacity are zero or the file cannot be created
+ */
+telemetry_logger::telemetry_logger(const std::string& filename, unsigned int n_producers, telemetry_format format, std::size_t capacity)
+    : m_format(format), m_file(nullptr), m_start(std::chrono::steady_clock::now()), m_closing(false), m_pushing(0u), m_stop(false), m_dropped(0u), m_written(0u)
+{
+    if (n_producers == 0u) throw input_error("Number of producers is 0");
+    if (capacity == 0u) throw input_error("Queue capacity is 0");
+    m_file = std::fopen(filename.c_str(), (format == TELEMETRY_CSV) ? "w" : "wb");
+    if (!m_file)
+    {
+        throw input_error("Could not open " + filename);
+    }
+    if (format == TELEMETRY_CSV)
+    {
+        std::fputs("source,generation,time,best_fitness,mean_fitness,active_min,active_mean,active_max,evaluations,evaluations_per_second,cache_hits,cache_misses\n", m_file);
+    } else {
+        telemetry_header h;
+        std::memcpy(h.m_magic, telemetry_magic, sizeof(h.m_magic));
+        h.m_byte_order = telemetry_byte_order;
+        h.m_version = telemetry_version;
+        h.m_record_size = sizeof(telemetry_record);
+        h.m_reserved = 0u;
+        if (std::fwrite(&h, sizeof(h), 1u, m_file) != 1u)
+        {
+            std::fclose(m_file);
+            throw input_error("Could not write " + filename);
+        }
+    }
+    for (auto i = 0u; i < n_producers; ++i)
+    {
+        m_queues.emplace_back(new spsc_queue<telemetry_record>(capacity));
+    }
+    m_consumer = std::thread(&telemetry_logger::consume, this);
+}
+
+/// Destructor (see dcgp::telemetry_logger::close)
+telemetry_logger::~telemetry_logger()
+{
+    close();
+}
+
+/// Pushes a record, never blocking
+/**
+ * Must only be called by one thread per producer. A record accepted (true returned) is always written, even if
+ * the logger is being closed concurrently.
+ *
+ * \param[in] producer the producer
+ * \param[in] record the record
+ *
+ * \return false if the record was dropped because the queue of the producer is full or the logger is closed
+ *
+ * @throw dcgp::input_error if the producer does not exist
+ */
+bool telemetry_logger::push(unsigned int producer, const telemetry_record& record)
+{
+    if (producer >= m_queues.size())
+    {
+        throw input_error("Producer " + std::to_string(producer) + " does not exist");
+    }
+    // announces the push before checking for close, which waits for the pushes announced to be done
+    m_pushing.fetch_add(1u);
+    const bool retval = !m_closing.load() && m_queues[producer]->push(record);
+    m_pushing.fetch_sub(1u);
+    if (!retval)
+    {
+        m_dropped.fetch_add(1u, std::memory_order_relaxed);
+    }
+    return retval;
+}
+
+/// Writes the records still queued, stops the consumer and closes the file
+/**
+ * New pushes are refused first, and the pushes in progress (on other threads) are waited for, so that all
+ * the records accepted are written. Records pushed afterwards are dropped. Closing a closed logger does nothing.
+ */
+void telemetry_logger::close()
+{
+    if (!m_consumer.joinable()) return;
+    m_closing = true;
+    while (m_pushing.load() != 0u)
+    {
+        std::this_thread::yield();
+    }
+    m_stop = true;
+    m_consumer.join();
+    std::fclose(m_file);
+    m_file = nullptr;
+}
+
+// Writes the queued records, returns false if there were none
+bool telemetry_logger::drain()
+{
+    bool retval = false;
+    telemetry_record r;
+    for (auto &q : m_queues)
+    {
+        while (q->pop(r))
+        {
+            if (m_format == TELEMETRY_CSV)
+            {
+                write_csv(m_file, r);
+            } else {
+                std::fwrite(&r, sizeof(r), 1u, m_file);
+            }
+            m_written.fetch_add(1u, std::memory_order_relaxed);
+            retval = true;
+        }
+    }
+    return retval;
+}
+
+// The consumer thread: drains the queues, sleeping when they are empty
+void telemetry_logger::consume()
+{
+    while (!m_stop.load())
+    {
+        if (!drain())
+        {
+            std::fflush(m_file);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    // the records pushed before close
+    drain();
+    std::fflush(m_file);
+}
+
+/// Loads the records of a binary telemetry log
+/**
+ * \param[in] filename the log file, written by a dcgp::telemetry_logger with the TELEMETRY_BINARY format
+ *
+ * \return the records, in the order they were written
+ *
+ * @throw dcgp::input_error if the file cannot be read or is not a binary telemetry log of this machine
+ */
+std::vector<telemetry_record> load_telemetry(const std::string& filename)
+{
+    std::ifstream is(filename, std::ios::binary);
+    if (!is)
+    {
+        throw input_error("Could not open " + filename);
+    }
+    telemetry_header h;
+    if (!is.read(reinterpret_cast<char*>(&h), sizeof(h)) || std::memcmp(h.m_magic, telemetry_magic, sizeof(h.m_magic)) != 0)
+    {
+        throw input_error(filename + " is not a d-CGP telemetry log");
+    }
+    if (h.m_byte_order != telemetry_byte_order)
+    {
+        throw input_error(filename + " was written on a machine with a different byte order");
+    }
+    if (h.m_version != telemetry_version)
+    {
+        throw input_error("Unsupported telemetry log version " + std::to_string(h.m_version));
+    }
+    if (h.m_record_size != sizeof(telemetry_record))
+    {
+        throw input_error(filename + " has records of " + std::to_string(h.m_record_size) + " bytes, expected " + std::to_string(sizeof(telemetry_record)));
+    }
+    std::vector<telemetry_record> retval;
+    telemetry_record r;
+    while (is.read(reinterpret_cast<char*>(&r), sizeof(r)))
+    {
+        retval.push_back(r);
+    }
+    if (is.gcount() != 0)
+    {
+        throw input_error(filename + " is truncated");
+    }
+    return retval;
+}
+
+} // end of namespace dcgp
@@ -0,0 +1,153 @@
+#ifndef DCGP_TELEMETRY_H
+#define DCGP_TELEMETRY_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spsc_queue.h"
+
+namespace dcgp {
+
+enum telemetry_format {
+    TELEMETRY_CSV,      // one line per record, with a header line
+    TELEMETRY_BINARY    // a header (magic, byte order mark, version, record size) followed by the raw records (see dcgp::load_telemetry)
+    };
+
+/// Fixed-size record of the progress of an evolution driver
+struct telemetry_record
+{
+    // the island (dcgp::island_model) or worker (dcgp::steady_state) sending the record
+    std::uint32_t m_source;
+    std::uint32_t m_reserved;
+    // the generation (dcgp::island_model) or the evaluations of the worker (dcgp::steady_state)
+    std::uint64_t m_generation;
+    // seconds since the logger was created
+    double m_time;
+    double m_best_fitness;
+    // mean (finite) fitness of the offspring (dcgp::island_model) or of the population (dcgp::steady_state)
+    double m_mean_fitness;
+    // number of active nodes of the offspring evaluated since the previous record
+    double m_active_min;
+    double m_active_mean;
+    double m_active_max;
+    // fitness evaluations of the source since the start of the run, and their rate (NaN if no time was measured)
+    std::uint64_t m_evaluations;
+    double m_evaluations_per_second;
+    // hits and misses of the cache of compiled expressions, if any (see dcgp::jit_cache)
+    std::uint64_t m_cache_hits;
+    std::uint64_t m_cache_misses;
+};
+
+/// Statistics of the offspring evaluated by a producer between two records
+class telemetry_window {
+public:
+    telemetry_window() {reset();};
+
+    /// Adds an offspring
+    void add(std::size_t active_nodes, double fitness)
+    {
+        const double active = static_cast<double>(active_nodes);
+        m_active_min = std::min(m_active_min, active);
+        m_active_max = std::max(m_active_max, active);
+        m_active_sum += active;
+        ++m_count;
+        if (std::isfinite(fitness))
+        {
+            m_fitness_sum += fitness;
+            ++m_finite;
+        }
+    }
+
+    /// Writes the active sizes and the mean fitness of the offspring in a record, and starts a new window
+    void fill(telemetry_record& r)
+    {
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        r.m_active_min = m_count ? m_active_min : nan;
+        r.m_active_mean = m_count ? m_active_sum / static_cast<double>(m_count) : nan;
+        r.m_active_max = m_count ? m_active_max : nan;
+        r.m_mean_fitness = m_finite ? m_fitness_sum / static_cast<double>(m_finite) : nan;
+        reset();
+    }
+
+private:
+    void reset()
+    {
+        m_active_min = std::numeric_limits<double>::infinity();
+        m_active_max = 0.;
+        m_active_sum = 0.;
+        m_fitness_sum = 0.;
+        m_count = 0u;
+        m_finite = 0u;
+    }
+
+    double m_active_min;
+    double m_active_max;
+    double m_active_sum;
+    double m_fitness_sum;
+    unsigned long m_count;
+    unsigned long m_finite;
+};
+
+/// Asynchronous log of telemetry records
+/**
+ * Each producer (e.g. each island of a dcgp::island_model) pushes fixed-size dcgp::telemetry_record into its own
+ * lock-free dcgp::spsc_queue, and a background thread drains the queues to a CSV or binary file.
+ * Pushing never blocks: if the consumer falls behind and the queue of a producer is full, the record is dropped
+ * and counted (see dcgp::telemetry_logger::get_dropped). Closing waits for the pushes in progress, so that every
+ * record accepted is written, whether the producers have been joined or not.
+ *
+ * Binary logs start with a header (magic, byte order mark, version and record size, as dcgp::checkpoint files),
+ * checked by dcgp::load_telemetry.
+ */
+class telemetry_logger {
+public:
+    telemetry_logger(const std::string& filename, unsigned int n_producers, telemetry_format format = TELEMETRY_CSV, std::size_t capacity = 4096u);
+    ~telemetry_logger();
+    telemetry_logger(const telemetry_logger&) = delete;
+    telemetry_logger& operator=(const telemetry_logger&) = delete;
+
+    bool push(unsigned int producer, const telemetry_record& record);
+    void close();
+
+    /// Gets the seconds elapsed since the logger was created (the time base of the records)
+    double elapsed() const {return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();};
+    /// Gets the number of producers
+    unsigned int get_n_producers() const {return static_cast<unsigned int>(m_queues.size());};
+    /// Gets the number of records dropped because the queue of their producer was full
+    unsigned long get_dropped() const {return m_dropped.load(std::memory_order_relaxed);};
+    /// Gets the number of records written to the file
+    unsigned long get_written() const {return m_written.load(std::memory_order_relaxed);};
+
+private:
+    void consume();
+    bool drain();
+
+    std::vector<std::unique_ptr<spsc_queue<telemetry_record> > > m_queues;
+    telemetry_format m_format;
+    std::FILE *m_file;
+    std::chrono::steady_clock::time_point m_start;
+    // set by close before waiting for the pushes in progress (m_pushing) to be done
+    std::atomic<bool> m_closing;
+    std::atomic<unsigned long> m_pushing;
+    // tells the consumer to drain the queues one last time and stop
+    std::atomic<bool> m_stop;
+    std::atomic<unsigned long> m_dropped;
+    std::atomic<unsigned long> m_written;
+    std::thread m_consumer;
+};
+
+/// Loads the records of a binary telemetry log
+std::vector<telemetry_record> load_telemetry(const std::string& filename);
+
+} // end of namespace dcgp
+
+#endif // DCGP_TELEMETRY_H
@@ -0,0 +1,78 @@
+#include <utility>
+
+#include "exceptions.h"
+#include "topology.h"
+
+namespace dcgp {
+
+/// Constructor
+/** Constructs the topology of a d-cgp expression, computing the bounds of its genes
+ *
+ * \param[in] n number of inputs (independent variables)
+ * \param[in] m number of outputs (dependent variables)
+ * \param[in] r number of rows of the cartesian cgp
+ * \param[in] c number of columns of the cartesian cgp
+ * \param[in] l number of levels-back allowed for the cartesian cgp
+ * \param[in] f function set. An std::vector of dcgp::basis_function
+ *
+ * @throw dcgp::input_error if any of n, m, r, c, l or the number of functions is 0
+ */
+expression_topology::expression_topology(unsigned int n, unsigned int m, unsigned int r, unsigned int c, unsigned int l, std::vector<basis_function> f)
+    : m_n(n), m_m(m), m_r(r), m_c(c), m_l(l), m_f(std::move(f)), m_lb((3 * m_r * m_c) + m_m, 0), m_ub((3 * m_r * m_c) + m_m, 0)
+{
+    if (n == 0) throw input_error("Number of inputs is 0");
+    if (m == 0) throw input_error("Number of outputs is 0");
+    if (c == 0) throw input_error("Number of columns is 0");
+    if (r == 0) throw input_error("Number of rows is 0");
+    if (l == 0) throw input_error("Number of level-backs is 0");
+    if (m_f.size()==0) throw input_error("Number of basis functions is 0");
+
+    for (const auto &f : m_f) {
+        m_node_ops.push_back(instrument_node_op(f.m_name));
+    }
+
+    // Bounds for the function genes
+    for (auto i = 0u; i < (3 * m_r * m_c); i+=3) {
+        m_ub[i] = m_f.size() - 1;
+    }
+
+    // Bounds for the output genes
+    for (auto i = 3u * m_r * m_c; i < m_ub.size(); ++i) {
+        m_ub[i] = m_n + m_r * m_c - 1;
+        if (m_l <= m_c) {
+            m_lb[i] = m_n + m_r * (m_c - m_l);
+        }
+    }
+
+    // Bounds for the node connection genes
+    for (auto i = 0u; i < m_c; ++i) {
+        for (auto j = 0u; j < m_r; ++j) {
+            m_ub[((i * m_r) + j) * 3 + 1] = m_n + i * m_r - 1;
+            m_ub[((i * m_r) + j) * 3 + 2] = m_n + i * m_r - 1;
+            if (i >= m_l) {
+                m_lb[((i * m_r) + j) * 3 + 1] = m_n + m_r * (i - m_l);
+                m_lb[((i * m_r) + j) * 3 + 2] = m_n + m_r * (i - m_l);
+            }
+        }
+    }
+}
+
+/// Builds a topology to be shared by several expressions
+/**
+ * \param[in] n number of inputs (independent variables)
+ * \param[in] m number of outputs (dependent variables)
+ * \param[in] r number of rows of the cartesian cgp
+ * \param[in] c number of columns of the cartesian cgp
+ * \param[in] l number of levels-back allowed for the cartesian cgp
+ * \param[in] f function set. An std::vector of dcgp::basis_function
+ *
+ * \return the topology, to be passed to the constructor of dcgp::expression
+ *
+ * @throw dcgp::input_error if any of n, m, r, c, l or the number of functions is 0
+ */
+std::shared_ptr<const expression_topology> make_topology(unsigned int n, unsigned int m, unsigned int r, unsigned int c, unsigned int l, std::vector<basis_function> f)
+{
+    return std::make_shared<expression_topology>(n, m, r, c, l, std::move(f));
+}
+
+} // end of namespace dcgp
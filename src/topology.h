@@ -0,0 +1,64 @@
+#ifndef DCGP_TOPOLOGY_H
+#define DCGP_TOPOLOGY_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "basis_function.h"
+#include "instrumentation.h"
+
+namespace dcgp {
+
+/// Topology of a d-CGP expression
+/**
+ * Everything defining a dcgp::expression but its chromosome: the number of inputs, outputs, rows, columns and
+ * levels-back, the function set and the bounds of each gene. A topology is immutable once built and is meant to be
+ * shared (through a std::shared_ptr) by all the expressions having it, so that building or copying an expression
+ * only allocates its chromosome and its active nodes and genes.
+ *
+ * @author Dario Izzo (dario.izzo@gmail.com)
+ */
+class expression_topology {
+public:
+    expression_topology(unsigned int n, unsigned int m, unsigned int r, unsigned int c, unsigned int l, std::vector<basis_function> f);
+
+    /// Gets the number of inputs
+    unsigned int get_n() const {return m_n;};
+    /// Gets the number of outputs
+    unsigned int get_m() const {return m_m;};
+    /// Gets the number of rows
+    unsigned int get_r() const {return m_r;};
+    /// Gets the number of columns
+    unsigned int get_c() const {return m_c;};
+    /// Gets the number of levels-back
+    unsigned int get_l() const {return m_l;};
+    /// Gets the functions
+    const std::vector<basis_function>& get_f() const {return m_f;};
+    /// Gets the lower bounds of the genes
+    const std::vector<unsigned int>& get_lb() const {return m_lb;};
+    /// Gets the upper bounds of the genes
+    const std::vector<unsigned int>& get_ub() const {return m_ub;};
+    /// Gets the number of genes of a chromosome
+    std::size_t size() const {return m_lb.size();};
+    /// Gets the node operation counting the evaluations of each function (see dcgp::instrument_node_op)
+    const std::vector<instrumentation_node_op>& get_node_ops() const {return m_node_ops;};
+
+private:
+    unsigned int m_n;
+    unsigned int m_m;
+    unsigned int m_r;
+    unsigned int m_c;
+    unsigned int m_l;
+    std::vector<basis_function> m_f;
+    std::vector<unsigned int> m_lb;
+    std::vector<unsigned int> m_ub;
+    std::vector<instrumentation_node_op> m_node_ops;
+};
+
+/// Builds a topology to be shared by several expressions
+std::shared_ptr<const expression_topology> make_topology(unsigned int n, unsigned int m, unsigned int r, unsigned int c, unsigned int l, std::vector<basis_function> f);
+
+} // end of namespace dcgp
+
+#endif // DCGP_TOPOLOGY_H
@@ -0,0 +1,209 @@
+#include <atomic>
+#include <cmath>
+
+#include "exceptions.h"
+#include "window_fit.h"
+
+namespace dcgp {
+
+namespace {
+// The ids of the windows, starting from 1
+std::atomic<unsigned long long> window_ids(0u);
+}
+
+/// Constructor
+/** Creates an empty window
+ *
+ * \param[in] n number of inputs
+ * \param[in] m number of outputs
+ * \param[in] capacity maximum number of points
+ *
+ * @throw dcgp::input_error if capacity is zero
+ */
+data_window::data_window(unsigned int n, unsigned int m, std::size_t capacity) : m_id(++window_ids), m_n(n), m_m(m), m_capacity(capacity), m_begin(0u), m_end(0u)
+{
+    if (capacity == 0u)
+    {
+        throw input_error("Window capacity is 0");
+    }
+    m_data.resize(capacity * (n + m));
+}
+
+/// Copy constructor
+/** Copies the points of a window, the copy having its own id
+ *
+ * \param[in] other the window
+ */
+data_window::data_window(const data_window& other)
+    : m_id(++window_ids), m_n(other.m_n), m_m(other.m_m), m_capacity(other.m_capacity), m_begin(other.m_begin), m_end(other.m_end), m_data(other.m_data)
+{
+}
+
+/// Copy assignment
+/** Copies the points of a window and takes a new id, as the points followed so far are gone
+ *
+ * \param[in] other the window
+ *
+ * \return a reference to this window
+ */
+data_window& data_window::operator=(const data_window& other)
+{
+    m_id = ++window_ids;
+    m_n = other.m_n;
+    m_m = other.m_m;
+    m_capacity = other.m_capacity;
+    m_begin = other.m_begin;
+    m_end = other.m_end;
+    m_data = other.m_data;
+    return *this;
+}
+
+/// Pushes a point, retiring the oldest one if the window is full
+/**
+ * \param[in] in pointer to the n inputs
+ * \param[in] out pointer to the m outputs
+ */
+void data_window::push(const double *in, const double *out)
+{
+    double *dst = m_data.data() + (m_end % m_capacity) * (m_n + m_m);
+    for (auto j = 0u; j < m_n; ++j) dst[j] = in[j];
+    for (auto j = 0u; j < m_m; ++j) dst[m_n + j] = out[j];
+    ++m_end;
+    if (m_end - m_begin > m_capacity) ++m_begin;
+}
+
+/// Pushes all the points of a chunk, in order
+/**
+ * \param[in] chunk the points
+ *
+ * @throw dcgp::input_error if the chunk does not have the inputs and outputs of the window
+ */
+void data_window::push(const dataset& chunk)
+{
+    if (chunk.get_n() != m_n || chunk.get_m() != m_m)
+    {
+        throw input_error("Chunk is incompatible with the window inputs and outputs");
+    }
+    for (auto i = 0u; i < chunk.rows(); ++i)
+    {
+        double *dst = m_data.data() + (m_end % m_capacity) * (m_n + m_m);
+        const strided_view point = chunk.row(i);
+        for (auto j = 0u; j < m_n + m_m; ++j) dst[j] = point[j];
+        ++m_end;
+        if (m_end - m_begin > m_capacity) ++m_begin;
+    }
+}
+
+/// Copies the points of the window, oldest first
+/**
+ * \return a dataset holding the points of the window
+ */
+dataset data_window::to_dataset() const
+{
+    dataset retval(rows(), m_n, m_m, ROW_MAJOR);
+    for (unsigned long long k = m_begin; k < m_end; ++k)
+    {
+        const double *point = row(k);
+        const std::size_t i = static_cast<std::size_t>(k - m_begin);
+        for (auto j = 0u; j < m_n; ++j) retval.set_in(i, j, point[j]);
+        for (auto j = 0u; j < m_m; ++j) retval.set_out(i, j, point[m_n + j]);
+    }
+    return retval;
+}
+
+/// Constructor
+/** Creates the accumulator of an expression, accounting for no point
+ *
+ * \param[in] ex the expression (copied)
+ * \param[in] type the fitness type
+ * \param[in] tol the tolerance for HITS_BASED fitness
+ */
+window_fit::window_fit(const expression& ex, fitness_type type, double tol)
+    : m_ex(ex), m_type(type), m_tol(tol), m_out(ex.get_m()), m_window(0u), m_begin(0u), m_end(0u), m_sum(0.), m_c(0.), m_retired(0u), m_evaluated(0u)
+{
+}
+
+/// Brings the fitness up to date with a window
+/**
+ * Subtracts the contributions of the points retired from the window since the last update and adds those of
+ * the points pushed into it. Updating from another window starts again from scratch.
+ *
+ * \param[in] window the window
+ *
+ * \return the fitness of the expression on the points of the window, as computed by dcgp::simple_data_fit
+ * (up to the rounding of the sums)
+ *
+ * @throw dcgp::input_error if the window does not have the inputs and outputs of the expression
+ */
+double window_fit::update(const data_window& window)
+{
+    if (window.get_n() != m_ex.get_n() || window.get_m() != m_ex.get_m())
+    {
+        throw input_error("Window is incompatible with the expression inputs and outputs");
+    }
+    if (window.get_id() != m_window || window.capacity() != m_contributions.size() || m_end < window.begin())
+    {
+        reset(window);
+    }
+    const std::size_t capacity = m_contributions.size();
+    for (; m_begin < window.begin(); ++m_begin)
+    {
+        add(-m_contributions[m_begin % capacity]);
+        ++m_retired;
+    }
+    // the subtractions cancel the additions only up to rounding: once a window of points has been retired,
+    // the sum is recomputed from the contributions still accounted for
+    if (m_retired >= capacity)
+    {
+        m_sum = 0.;
+        m_c = 0.;
+        for (unsigned long long k = m_begin; k < m_end; ++k) add(m_contributions[k % capacity]);
+        m_retired = 0u;
+    }
+    const unsigned int n = m_ex.get_n(), m = m_ex.get_m();
+    for (; m_end < window.end(); ++m_end)
+    {
+        const double *point = window.row(m_end);
+        m_ex.eval_into(point, m_out.data(), m_ws);
+        DCGP_COUNT(COUNT_FITNESS_POINTS, 1u);
+        // same rule as dcgp::simple_data_fit: non finite outputs are ignored
+        double contribution = 0.;
+        for (auto j = 0u; j < m; ++j)
+        {
+            if (!std::isfinite(m_out[j])) continue;
+            const double err = std::fabs(point[n + j] - m_out[j]);
+            if (m_type == ERROR_BASED) {
+                contribution += 1.0 / (1.0 + err);
+            } else if (err < m_tol) {
+                contribution += 1.0;
+            }
+        }
+        m_contributions[m_end % capacity] = contribution;
+        add(contribution);
+        ++m_evaluated;
+    }
+    return get_fitness();
+}
+
+// Adds to the compensated sum
+void window_fit::add(double x)
+{
+    const double t = m_sum + x;
+    if (std::fabs(m_sum) >= std::fabs(x)) m_c += (m_sum - t) + x;
+    else m_c += (x - t) + m_sum;
+    m_sum = t;
+}
+
+// Forgets all the points accounted for, and starts following a window from its oldest point
+void window_fit::reset(const data_window& window)
+{
+    m_window = window.get_id();
+    m_contributions.assign(window.capacity(), 0.);
+    m_begin = window.begin();
+    m_end = window.begin();
+    m_sum = 0.;
+    m_c = 0.;
+    m_retired = 0u;
+}
+
+} // end of namespace dcgp
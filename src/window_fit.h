@@ -0,0 +1,110 @@
+#ifndef DCGP_WINDOW_FIT_H
+#define DCGP_WINDOW_FIT_H
+
+#include <cstddef>
+#include <vector>
+
+#include "dataset.h"
+#include "expression.h"
+#include "fitness_functions.h"
+
+namespace dcgp {
+
+/// Sliding window over a stream of points
+/**
+ * Keeps the last capacity points pushed, each one numbered by its position in the stream: the window holds the
+ * points begin() to end() - 1, and pushing a point into a full window retires the oldest one.
+ *
+ * Each window has a unique id (see dcgp::data_window::get_id), also taken anew by copies and by assignment, so that
+ * dcgp::window_fit recognises the window it follows whatever its address.
+ *
+ * @author Dario Izzo (dario.izzo@gmail.com)
+ */
+class data_window {
+public:
+    data_window(unsigned int n, unsigned int m, std::size_t capacity);
+    data_window(const data_window& other);
+    data_window& operator=(const data_window& other);
+
+    void push(const double *in, const double *out);
+    void push(const dataset& chunk);
+    dataset to_dataset() const;
+
+    /// Gets the number of inputs
+    unsigned int get_n() const {return m_n;};
+    /// Gets the number of outputs
+    unsigned int get_m() const {return m_m;};
+    /// Gets the id of the window, unique in the process
+    unsigned long long get_id() const {return m_id;};
+    /// Gets the maximum number of points
+    std::size_t capacity() const {return m_capacity;};
+    /// Gets the number of points
+    std::size_t rows() const {return static_cast<std::size_t>(m_end - m_begin);};
+    /// Gets the position in the stream of the oldest point
+    unsigned long long begin() const {return m_begin;};
+    /// Gets the position in the stream of the next point to be pushed
+    unsigned long long end() const {return m_end;};
+    /// Gets the n inputs then the m outputs of the point at position k of the stream (begin() <= k < end())
+    const double *row(unsigned long long k) const {return m_data.data() + (k % m_capacity) * (m_n + m_m);};
+
+private:
+    unsigned long long m_id;
+    unsigned int m_n;
+    unsigned int m_m;
+    std::size_t m_capacity;
+    unsigned long long m_begin;
+    unsigned long long m_end;
+    std::vector<double> m_data;
+};
+
+/// Fitness of an expression on a sliding window, updated incrementally
+/**
+ * The fitness of dcgp::simple_data_fit is a sum over the points, so that when the window slides the contributions
+ * of the new points can be added and those of the retired points subtracted: an update costs the evaluation of
+ * the points pushed since the previous one, not of the whole window. The contribution of each point is kept
+ * until it is retired, and the sum is compensated and periodically recomputed from them, so that it does not drift.
+ *
+ * The first update (and the updates after the window moved past all the points accounted for) evaluates
+ * the whole window.
+ *
+ * @author Dario Izzo (dario.izzo@gmail.com)
+ */
+class window_fit {
+public:
+    window_fit(const expression& ex, fitness_type type = ERROR_BASED, double tol = 1e-10);
+
+    double update(const data_window& window);
+
+    /// Gets the fitness on the window as of the last update
+    double get_fitness() const {return m_sum + m_c;};
+    /// Gets the expression
+    const expression& get_expression() const {return m_ex;};
+    /// Gets the number of points evaluated since construction
+    unsigned long long get_evaluated() const {return m_evaluated;};
+
+private:
+    void add(double x);
+    void reset(const data_window& window);
+
+    expression m_ex;
+    fitness_type m_type;
+    double m_tol;
+    workspace m_ws;
+    std::vector<double> m_out;
+    // the id of the window last updated from (0 if none)
+    unsigned long long m_window;
+    // the contribution of each point accounted for, indexed by its position modulo the window capacity
+    std::vector<double> m_contributions;
+    // the points accounted for
+    unsigned long long m_begin;
+    unsigned long long m_end;
+    // compensated (Kahan-Babuska-Neumaier) sum of the contributions
+    double m_sum;
+    double m_c;
+    std::size_t m_retired;
+    unsigned long long m_evaluated;
+};
+
+} // end of namespace dcgp
+
+#endif // DCGP_WINDOW_FIT_H
@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <string>
 #include <boost/algorithm/string/predicate.hpp>
 #include <iostream>
@@ -9,6 +11,112 @@
 
 namespace dcgp {
 
+namespace {
+const double inf = std::numeric_limits<double>::infinity();
+
+// A part of a dcgp::interval: its finite range, or one of its infinities (lo == hi)
+struct piece
+{
+    double m_lo;
+    double m_hi;
+};
+
+unsigned int pieces(const interval& x, piece (&p)[3])
+{
+    unsigned int retval = 0u;
+    if (x.m_neg_inf) p[retval++] = piece{-inf, -inf};
+    if (x.has_finite()) p[retval++] = piece{x.m_lo, x.m_hi};
+    if (x.m_pos_inf) p[retval++] = piece{inf, inf};
+    return retval;
+}
+
+// The values to be tried for an argument: the bounds, and the zeros if contained
+unsigned int samples(const piece& p, double (&s)[4])
+{
+    unsigned int retval = 0u;
+    s[retval++] = p.m_lo;
+    s[retval++] = p.m_hi;
+    if (p.m_lo < 0. && 0. < p.m_hi)
+    {
+        s[retval++] = 0.;
+        s[retval++] = -0.;
+    }
+    return retval;
+}
+
+// Adds the range of op between the values at the corners of two finite ranges (op monotone in each argument)
+void add_corners(interval& retval, const piece& x, const piece& y, double (*op)(double, double))
+{
+    const double c[4] = {op(x.m_lo, y.m_lo), op(x.m_lo, y.m_hi), op(x.m_hi, y.m_lo), op(x.m_hi, y.m_hi)};
+    retval.add_range(*std::min_element(c, c + 4), *std::max_element(c, c + 4));
+}
+
+// Enclosure of one of the arithmetic operations, on independent arguments. On two finite ranges the corners are
+// enough (the divisor range being split around zero), otherwise one argument is a single infinity and the
+// result only depends on the sign of the other one, so that trying its bounds and zeros is enough
+interval arithmetic(const interval& x, const interval& y, double (*op)(double, double), bool divide)
+{
+    interval retval;
+    retval.m_nan = x.m_nan || y.m_nan;
+    piece px[3], py[3];
+    const unsigned int nx = pieces(x, px), ny = pieces(y, py);
+    for (auto i = 0u; i < nx; ++i)
+    {
+        for (auto j = 0u; j < ny; ++j)
+        {
+            const piece &a = px[i], &b = py[j];
+            if (std::isfinite(a.m_lo) && std::isfinite(b.m_lo))
+            {
+                if (divide && b.m_lo <= 0. && 0. <= b.m_hi)
+                {
+                    const double tiny = std::numeric_limits<double>::denorm_min();
+                    if (b.m_lo < 0.) add_corners(retval, a, piece{b.m_lo, std::min(b.m_hi, -tiny)}, op);
+                    if (b.m_hi > 0.) add_corners(retval, a, piece{std::max(b.m_lo, tiny), b.m_hi}, op);
+                    // divided by zero (whose sign is not tracked): infinite, or NaN for 0 / 0
+                    if (a.m_lo < 0. || a.m_hi > 0.)
+                    {
+                        retval.m_neg_inf = true;
+                        retval.m_pos_inf = true;
+                    }
+                    if (a.m_lo <= 0. && 0. <= a.m_hi) retval.m_nan = true;
+                } else {
+                    add_corners(retval, a, b, op);
+                }
+            } else {
+                double sa[4], sb[4];
+                const unsigned int na = samples(a, sa), nb = samples(b, sb);
+                for (auto k = 0u; k < na; ++k)
+                {
+                    for (auto l = 0u; l < nb; ++l)
+                    {
+                        retval.add(op(sa[k], sb[l]));
+                    }
+                }
+            }
+        }
+    }
+    return retval;
+}
+
+// Enclosure of |x|
+interval absolute(const interval& x)
+{
+    interval retval;
+    retval.m_nan = x.m_nan;
+    retval.m_pos_inf = x.m_neg_inf || x.m_pos_inf;
+    if (x.has_finite())
+    {
+        if (x.m_lo <= 0. && 0. <= x.m_hi)
+        {
+            retval.add_range(0., std::max(-x.m_lo, x.m_hi));
+        } else {
+            retval.add_range(std::min(std::fabs(x.m_lo), std::fabs(x.m_hi)), std::max(std::fabs(x.m_lo), std::fabs(x.m_hi)));
+        }
+    }
+    return retval;
+}
+}
+
 double my_sum(double x, double y)
 {
         return x + y;
@@ -109,9 +217,16 @@ double my_div(double x, double y)
 }
 
 double d_my_div(const std::vector<double>& b, const std::vector<double>& c)
+{
+    std::vector<double> scratch;
+    return d_my_div_into(b, c, scratch);
+}
+
+double d_my_div_into(const std::vector<double>& b, const std::vector<double>& c, std::vector<double>& scratch)
 {
     unsigned int n = b.size() - 1u;
-    std::vector<double> a(b.size());
+    if (scratch.size() < b.size()) scratch.resize(b.size());
+    double *a = scratch.data();
     a[0] = b[0] / c[0];
 
     for (auto i = 1u; i <= n; ++i) 
@@ -145,12 +260,17 @@ double my_pow(double b, double c)
 }
 
 double d_my_pow(const std::vector<double>& b, const std::vector<double>& c)
+{
+    std::vector<double> scratch;
+    return d_my_pow_into(b, c, scratch);
+}
+
+double d_my_pow_into(const std::vector<double>& b, const std::vector<double>& c, std::vector<double>& scratch)
 {
     // We derive this by setting a = exp(c * ln(|b|))
     unsigned int n = b.size() - 1u;
-    std::vector<double> a(b.size());
-    std::vector<double> f(b.size());
-    std::vector<double> g(b.size());
+    if (scratch.size() < 3u * b.size()) scratch.resize(3u * b.size());
+    double *a = scratch.data(), *f = a + b.size(), *g = f + b.size();
 
     // We take care of the abs
     double sign = 1;
@@ -224,10 +344,17 @@ double my_sqrt(double b, double c)
 }
 
 double d_my_sqrt(const std::vector<double>& b, const std::vector<double>& c)
+{
+    std::vector<double> scratch;
+    return d_my_sqrt_into(b, c, scratch);
+}
+
+double d_my_sqrt_into(const std::vector<double>& b, const std::vector<double>& c, std::vector<double>& scratch)
 {
     (void)c;
     unsigned int n = b.size() - 1u;
-    std::vector<double> a(b.size());
+    if (scratch.size() < b.size()) scratch.resize(b.size());
+    double *a = scratch.data();
     double sign = 1;
     if (b[0] < 0)
     {
@@ -261,6 +388,88 @@ std::string print_my_sqrt(const std::string& s1, const std::string& s2)
     return ("sqrt(|" + s1 + "|)");
 }
 
+interval i_my_sum(const interval& x, const interval& y, bool same)
+{
+    if (!same) return arithmetic(x, y, my_sum, false);
+    // 2 * x
+    interval retval;
+    retval.m_nan = x.m_nan;
+    retval.m_neg_inf = x.m_neg_inf;
+    retval.m_pos_inf = x.m_pos_inf;
+    if (x.has_finite()) retval.add_range(2. * x.m_lo, 2. * x.m_hi);
+    return retval;
+}
+
+interval i_my_diff(const interval& x, const interval& y, bool same)
+{
+    if (!same) return arithmetic(x, y, my_diff, false);
+    // 0, or NaN for the infinities
+    interval retval;
+    retval.m_nan = x.m_nan || x.m_neg_inf || x.m_pos_inf;
+    if (x.has_finite()) retval.add(0.);
+    return retval;
+}
+
+interval i_my_mul(const interval& x, const interval& y, bool same)
+{
+    if (!same) return arithmetic(x, y, my_mul, false);
+    // x^2, never negative
+    const interval a = absolute(x);
+    interval retval;
+    retval.m_nan = a.m_nan;
+    retval.m_pos_inf = a.m_pos_inf;
+    if (a.has_finite()) retval.add_range(a.m_lo * a.m_lo, a.m_hi * a.m_hi);
+    return retval;
+}
+
+interval i_my_div(const interval& x, const interval& y, bool same)
+{
+    if (!same) return arithmetic(x, y, my_div, true);
+    // 1, or NaN for zero and the infinities
+    interval retval;
+    retval.m_nan = x.m_nan || x.m_neg_inf || x.m_pos_inf || x.contains(0.);
+    if (x.has_finite() && (x.m_lo < 0. || x.m_hi > 0.)) retval.add(1.);
+    return retval;
+}
+
+interval i_my_pow(const interval& x, const interval& y, bool same)
+{
+    (void)same;
+    // pow(a, y) = exp(y * log(a)) with a = |x| >= 0: its extremes on a box are at the corners, never NaN unless an
+    // argument is NaN (but pow(NaN, 0) = pow(1, NaN) = 1)
+    const interval a = absolute(x);
+    interval retval;
+    retval.m_nan = a.m_nan || y.m_nan;
+    if ((a.m_nan && y.contains(0.)) || (y.m_nan && a.contains(1.))) retval.add(1.);
+    piece pa[3], py[3];
+    const unsigned int na = pieces(a, pa), ny = pieces(y, py);
+    for (auto i = 0u; i < na; ++i)
+    {
+        for (auto j = 0u; j < ny; ++j)
+        {
+            double c[6] = {my_pow(pa[i].m_lo, py[j].m_lo), my_pow(pa[i].m_lo, py[j].m_hi), my_pow(pa[i].m_hi, py[j].m_lo), my_pow(pa[i].m_hi, py[j].m_hi), 1., 1.};
+            unsigned int count = 4u;
+            // the indeterminate corners: pow(1, y) and pow(a, 0) are 1
+            if (pa[i].m_lo <= 1. && 1. <= pa[i].m_hi) ++count;
+            if (py[j].m_lo <= 0. && 0. <= py[j].m_hi) ++count;
+            retval.add_range(*std::min_element(c, c + count), *std::max_element(c, c + count));
+        }
+    }
+    return retval;
+}
+
+interval i_my_sqrt(const interval& x, const interval& y, bool same)
+{
+    (void)y;
+    (void)same;
+    interval retval;
+    const interval a = absolute(x);
+    retval.m_nan = a.m_nan;
+    retval.m_pos_inf = a.m_pos_inf;
+    if (a.has_finite()) retval.add_range(std::sqrt(a.m_lo), std::sqrt(a.m_hi));
+    return retval;
+}
+
 double d_not_implemented(const std::vector<double>& b, const std::vector<double>& c)
 {
     (void)b;
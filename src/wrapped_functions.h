@@ -4,9 +4,13 @@
 #include <string>
 #include <vector>
 #include "exceptions.h"
+#include "interval.h"
 
 namespace dcgp {
 
+// The d_my_*_into versions compute the same derivatives with their temporaries in scratch (grown if smaller),
+// so that reusing it no memory is allocated (see dcgp::expression::differentiate_into)
+
 /*--------------------------------------------------------------------------
 *                                  BINARY FUNCTIONS
 *------------------------------------------------------------------------**/
@@ -28,11 +32,13 @@ std::string print_my_mul(const std::string& s1, const std::string& s2);
 // f = b / c
 double my_div(double b, double c);
 double d_my_div(const std::vector<double>& b, const std::vector<double>& c);
+double d_my_div_into(const std::vector<double>& b, const std::vector<double>& c, std::vector<double>& scratch);
 std::string print_my_div(const std::string& s1, const std::string& s2);
 
 // f = pow(|b|,c)
 double my_pow(double b, double c);
 double d_my_pow(const std::vector<double>& b, const std::vector<double>& c);
+double d_my_pow_into(const std::vector<double>& b, const std::vector<double>& c, std::vector<double>& scratch);
 std::string print_my_pow(const std::string& s1, const std::string& s2);
 
 /*--------------------------------------------------------------------------
@@ -42,8 +48,21 @@ std::string print_my_pow(const std::string& s1, const std::string& s2);
 // f = sqrt(|b|)
 double my_sqrt(double b, double c);
 double d_my_sqrt(const std::vector<double>& b, const std::vector<double>& c);
+double d_my_sqrt_into(const std::vector<double>& b, const std::vector<double>& c, std::vector<double>& scratch);
 std::string print_my_sqrt(const std::string& s1, const std::string& s2);
 
+/*--------------------------------------------------------------------------
+*                                  INTERVAL FUNCTIONS
+*------------------------------------------------------------------------**/
+// Enclosures of the values of the functions above on all the combinations of their arguments (see dcgp::interval).
+// same is true when both arguments are the same quantity (e.g. x - x is 0, not the range of differences)
+interval i_my_sum(const interval& b, const interval& c, bool same);
+interval i_my_diff(const interval& b, const interval& c, bool same);
+interval i_my_mul(const interval& b, const interval& c, bool same);
+interval i_my_div(const interval& b, const interval& c, bool same);
+interval i_my_pow(const interval& b, const interval& c, bool same);
+interval i_my_sqrt(const interval& b, const interval& c, bool same);
+
 /*--------------------------------------------------------------------------
 *                                  HELPER FUNCTIONS
 *------------------------------------------------------------------------**/
@@ -0,0 +1,127 @@
+#include <iostream>
+#include <iomanip>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "../src/dcgp.h"
+
+/// Archives a sequence of mutated chromosomes and checks they can be read back by index
+bool test_fails(
+        unsigned int n,
+        unsigned int m,
+        unsigned int r,
+        unsigned int c,
+        unsigned int l,
+        unsigned int N) // number of chromosomes
+{
+    dcgp::function_set basic_set({"sum","diff","mul","div","sqrt","pow"});
+    dcgp::expression ex(n, m, r, c, l, basic_set(), 123);
+    std::vector<std::vector<unsigned int> > chromosomes;
+    {
+        dcgp::archive_writer writer("test_archive.bin", ex);
+        for (auto i = 0u; i < N; ++i)
+        {
+            ex.mutate_active();
+            chromosomes.push_back(ex.get());
+            writer.push_back(ex.get(), 0.25 * i);
+        }
+        // the destructor closes the archive
+    }
+
+    dcgp::archive arch("test_archive.bin");
+    if (arch.size() != N || arch.chromosome_length() != ex.get().size()) return true;
+    if (arch.get_n() != n || arch.get_m() != m || arch.get_r() != r || arch.get_c() != c || arch.get_l() != l) return true;
+    if (arch.get_function_names() != std::vector<std::string>({"sum","diff","mul","div","sqrt","pow"})) return true;
+
+    dcgp::expression loaded = arch.make_expression(0u);
+    std::vector<std::string> in_sym;
+    for (auto i = 0u; i < n; ++i)
+    {
+        in_sym.push_back("x" + std::to_string(i));
+    }
+    // random access, backwards
+    for (auto i = N; i-- > 0u;)
+    {
+        const unsigned int *x = arch.chromosome(i);
+        if (!std::equal(chromosomes[i].begin(), chromosomes[i].end(), x)) return true;
+        if (arch.fitness(i) != 0.25 * i) return true;
+        arch.load(i, loaded);
+        ex.set(chromosomes[i]);
+        if (loaded(in_sym) != ex(in_sym)) return true;
+    }
+
+    // out of range access must throw
+    try {
+        arch.chromosome(N);
+        return true;
+    } catch (const dcgp::input_error&) {}
+    std::remove("test_archive.bin");
+    return false;
+}
+
+/// A file that is not an archive must be rejected
+bool test_invalid_fails()
+{
+    {
+        std::ofstream os("test_archive_invalid.bin", std::ios::binary);
+        os << std::string(200, 'x');
+    }
+    bool fails = true;
+    try {
+        dcgp::archive arch("test_archive_invalid.bin");
+    } catch (const dcgp::input_error&) {
+        fails = false;
+    }
+    std::remove("test_archive_invalid.bin");
+    return fails;
+}
+
+/// A header whose sizes wrap around when multiplied must be rejected
+bool test_overflow_fails()
+{
+    dcgp::function_set basic_set({"sum","diff"});
+    dcgp::expression ex(1, 1, 1, 2, 3, basic_set(), 123);
+    {
+        dcgp::archive_writer writer("test_archive_overflow.bin", ex);
+        writer.push_back(ex.get(), 1.);
+    }
+    std::string bytes;
+    {
+        std::ifstream is("test_archive_overflow.bin", std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+    }
+    // 2^62 chromosomes: their size in bytes, as that of their fitness values, is a multiple of 2^64
+    std::string huge_size = bytes;
+    const std::uint64_t size = std::uint64_t(1u) << 62u;
+    std::memcpy(&huge_size[48], &size, sizeof(size));
+    // 2^31 rows and 2 columns: 3 * r * c is 0 in 32 bits, and the chromosome length is that of the outputs only
+    std::string huge_rows = bytes;
+    const std::uint32_t r = 1u << 31u, length = 1u;
+    std::memcpy(&huge_rows[24], &r, sizeof(r));
+    std::memcpy(&huge_rows[40], &length, sizeof(length));
+    for (const auto &corrupted : {huge_size, huge_rows})
+    {
+        {
+            std::ofstream os("test_archive_overflow.bin", std::ios::binary | std::ios::trunc);
+            os.write(corrupted.data(), static_cast<std::streamsize>(corrupted.size()));
+        }
+        try {
+            dcgp::archive arch("test_archive_overflow.bin");
+            std::remove("test_archive_overflow.bin");
+            return true;
+        } catch (const dcgp::input_error&) {}
+    }
+    std::remove("test_archive_overflow.bin");
+    return false;
+}
+
+/// This test checks that chromosomes written in an archive are read back correctly through the memory map
+int main() {
+    return test_fails(2,4,2,3,4, 100) ||
+           test_fails(1,1,1,100,101, 1000) ||
+           test_fails(3,2,10,10,11, 0) ||
+           test_invalid_fails() ||
+           test_overflow_fails();
+}
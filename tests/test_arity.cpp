@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../src/dcgp.h"
+
+// Marks the nodes an output depends on, following only the connections read by each function
+void mark(const dcgp::expression& ex, unsigned int node, std::vector<bool>& used)
+{
+    if (used[node]) return;
+    used[node] = true;
+    if (node < ex.get_n()) return;
+    const unsigned int idx = (node - ex.get_n()) * 3u;
+    mark(ex, ex.get()[idx + 1], used);
+    if (ex.get_f()[ex.get()[idx]].m_arity > 1u) mark(ex, ex.get()[idx + 2], used);
+}
+
+/// Checks that the second connection of unary nodes is neither active nor mutated
+bool test_fails(
+        unsigned int n,
+        unsigned int m,
+        unsigned int r,
+        unsigned int c,
+        unsigned int l,
+        unsigned int seed)
+{
+    dcgp::function_set sqrt_set({"sum","mul","sqrt"});
+    dcgp::expression ex(n, m, r, c, l, sqrt_set(), seed);
+    std::default_random_engine re(seed);
+    std::vector<double> in(n);
+    for (auto k = 0u; k < 100u; ++k)
+    {
+        // the active nodes are exactly those the outputs depend on
+        std::vector<bool> used(n + r * c, false);
+        for (auto j = 0u; j < m; ++j)
+        {
+            mark(ex, ex.get()[r * c * 3u + j], used);
+        }
+        std::vector<unsigned int> expected_nodes;
+        for (auto i = 0u; i < used.size(); ++i)
+        {
+            if (used[i]) expected_nodes.push_back(i);
+        }
+        if (ex.get_active_nodes() != expected_nodes) return true;
+        for (auto g : ex.get_active_genes())
+        {
+            if (g < r * c * 3u && g % 3u == 2u && ex.get_f()[ex.get()[g - 2u]].m_arity < 2u) return true;
+        }
+
+        // the values and the derivatives do not depend on the inactive nodes
+        for (auto j = 0u; j < n; ++j) in[j] = std::uniform_real_distribution<double>(-3, 3)(re);
+        std::vector<double> out = ex(in), out_program = dcgp::program(ex)(in);
+        std::vector<std::vector<double> > jet = ex.differentiate(0u, 1u, in);
+        for (auto j = 0u; j < m; ++j)
+        {
+            if (std::memcmp(&out[j], &jet[0][j], sizeof(double)) != 0) return true;
+            if (std::memcmp(&out[j], &out_program[j], sizeof(double)) != 0 && !(std::isnan(out[j]) && std::isnan(out_program[j]))) return true;
+        }
+        if (dcgp::jit_available())
+        {
+            std::vector<double> out_jit = dcgp::jit_expression(ex)(in);
+            if (std::memcmp(out.data(), out_jit.data(), m * sizeof(double)) != 0) return true;
+        }
+
+        // only active genes are mutated
+        const std::vector<unsigned int> before = ex.get(), active = ex.get_active_genes();
+        ex.mutate_active();
+        for (auto g = 0u; g < before.size(); ++g)
+        {
+            if (before[g] != ex.get()[g] && std::find(active.begin(), active.end(), g) == active.end()) return true;
+        }
+    }
+    return false;
+}
+
+/// Checks the active graph of a hand written chromosome
+bool test_sqrt_fails()
+{
+    dcgp::function_set sqrt_set({"sum","sqrt"});
+    dcgp::expression ex(2, 1, 1, 2, 2, sqrt_set(), 123);
+    // sqrt(|x0|) + sqrt(|x0|): x1 is connected, but not read
+    ex.set({1, 0, 1, 0, 2, 2, 3});
+    if (ex.get_active_nodes() != std::vector<unsigned int>({0, 2, 3})) return true;
+    if (ex.get_active_genes() != std::vector<unsigned int>({0, 1, 3, 4, 5, 6})) return true;
+    if (ex(std::vector<double>({-4., 1.}))[0] != 4.) return true;
+    if (ex.differentiate(1u, 1u, {-4., 1.})[1][0] != 0.) return true;
+    // phenotypes do not depend on the connection not read
+    dcgp::expression other(ex);
+    other.set({1, 0, 0, 0, 2, 2, 3});
+    return dcgp::phenotype(ex) != dcgp::phenotype(other);
+}
+
+/// This test checks that unary functions do not activate their second connection
+int main() {
+    return test_fails(2, 1, 1, 20, 21, 123) ||
+           test_fails(3, 2, 2, 10, 11, 456) ||
+           test_fails(1, 3, 5, 5, 6, 789) ||
+           test_sqrt_fails();
+}
@@ -0,0 +1,111 @@
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <cstdio>
+#include <ctime>
+
+#include "../src/dcgp.h"
+
+/// Compares the content of two checkpoints
+bool differ(const dcgp::checkpoint& a, const dcgp::checkpoint& b)
+{
+    return a.m_n != b.m_n || a.m_m != b.m_m || a.m_r != b.m_r || a.m_c != b.m_c || a.m_l != b.m_l ||
+           a.m_function_names != b.m_function_names || a.m_chromosomes != b.m_chromosomes || a.m_fitness != b.m_fitness ||
+           a.m_rng_state != b.m_rng_state || a.m_generation != b.m_generation || a.m_best_fitness != b.m_best_fitness;
+}
+
+/// A single-threaded steady-state run resumed from a checkpoint must continue exactly as the original run
+bool test_resume_fails()
+{
+    dcgp::function_set basic_set({"sum","diff","mul","div","sqrt"});
+    dcgp::expression prototype(2, 1, 2, 10, 11, basic_set(), 123);
+    std::default_random_engine re(12);
+    std::vector<std::vector<double> > in, out;
+    for (auto i = 0u; i < 20; ++i)
+    {
+        double x = std::uniform_real_distribution<double>(-1, 1)(re);
+        double y = std::uniform_real_distribution<double>(-1, 1)(re);
+        in.push_back({x, y});
+        out.push_back({x * y + y});
+    }
+    auto fitness = [&in, &out](const dcgp::expression& ex) {return dcgp::simple_data_fit(ex, in, out);};
+
+    dcgp::steady_state engine(prototype, fitness, 30, 1, 4, 123);
+    engine.evolve(1000u, 1e10);
+    dcgp::save_checkpoint(engine.get_checkpoint(), "test_checkpoint.bin");
+    engine.evolve(1000u, 1e10);
+
+    dcgp::steady_state resumed(dcgp::load_checkpoint("test_checkpoint.bin"), fitness, 1, 4);
+    std::remove("test_checkpoint.bin");
+    resumed.evolve(1000u, 1e10);
+
+    std::cout << "Total evaluations: " << engine.get_total_evaluations() << " vs " << resumed.get_total_evaluations() << std::endl;
+    return differ(engine.get_checkpoint(), resumed.get_checkpoint());
+}
+
+/// A large checkpoint must survive a round trip and be written quickly
+bool test_roundtrip_fails(unsigned int pop_size)
+{
+    dcgp::function_set basic_set({"sum","diff","mul","div"});
+    dcgp::expression ex(1, 1, 1, 15, 16, basic_set(), 123);
+    dcgp::checkpoint cp = dcgp::make_checkpoint(ex);
+    cp.m_chromosomes.reserve(pop_size * cp.chromosome_length());
+    for (auto i = 0u; i < pop_size; ++i)
+    {
+        ex.mutate_active();
+        cp.push_back(ex.get(), i * 0.5);
+    }
+    cp.m_rng_state = "42";
+    cp.m_generation = 1234567u;
+    cp.m_best_fitness = 3.14;
+
+    std::stringstream ss(std::ios::in | std::ios::out | std::ios::binary);
+    clock_t begin = clock();
+    dcgp::save_checkpoint(cp, ss);
+    clock_t end = clock();
+    std::cout << pop_size << " individuals written in " << double(end - begin) / CLOCKS_PER_SEC << " seconds" << std::endl;
+    dcgp::checkpoint loaded = dcgp::load_checkpoint(ss);
+
+    // the expression rebuilt from the checkpoint must be equivalent to the original one
+    dcgp::expression rebuilt = dcgp::make_expression(loaded, 0u);
+    rebuilt.set(loaded.get_chromosome(pop_size - 1));
+    std::vector<std::string> in_sym({"x"});
+    if (rebuilt(in_sym) != ex(in_sym)) return true;
+
+    // a corrupted checkpoint must be rejected
+    std::stringstream bad("DCGPCKPX", std::ios::in | std::ios::binary);
+    try {
+        dcgp::load_checkpoint(bad);
+        return true;
+    } catch (const dcgp::input_error&) {}
+
+    // a corrupted block size must be rejected before the block is allocated
+    std::string blob;
+    {
+        std::stringstream good(std::ios::in | std::ios::out | std::ios::binary);
+        dcgp::save_checkpoint(cp, good);
+        blob = good.str();
+    }
+    // the chromosomes follow the magic, byte order, version, topology and function names
+    std::size_t offset = 8u + 4u * 8u;
+    for (const auto &name : cp.m_function_names) offset += 4u + name.size();
+    const std::uint64_t huge = std::uint64_t(1u) << 60u;
+    std::memcpy(&blob[offset], &huge, sizeof(huge));
+    std::stringstream oversized(blob, std::ios::in | std::ios::binary);
+    try {
+        dcgp::load_checkpoint(oversized);
+        return true;
+    } catch (const dcgp::input_error&) {}
+
+    return differ(cp, loaded);
+}
+
+/// This test checks that checkpoints survive a round trip and allow to resume an evolution exactly
+int main() {
+    return test_resume_fails() ||
+           test_roundtrip_fails(10) ||
+           test_roundtrip_fails(100000);
+}
@@ -0,0 +1,84 @@
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../src/dcgp.h"
+
+// bit-for-bit equality (NaNs included)
+bool same_bits(double a, double b)
+{
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+/// Checks that compiled expressions compute bit-for-bit the outputs of the interpreter
+bool test_fails(
+        unsigned int n,
+        unsigned int m,
+        unsigned int r,
+        unsigned int c,
+        unsigned int l,
+        unsigned int N, // number of points
+        unsigned int seed)
+{
+    dcgp::function_set all_set({"sum","diff","mul","div","pow","sqrt"});
+    dcgp::expression ex(n, m, r, c, l, all_set(), seed);
+    std::default_random_engine re(seed);
+    dcgp::dataset rows(N, n, m, dcgp::ROW_MAJOR), columns(N, n, m, dcgp::COLUMN_MAJOR);
+    for (auto i = 0u; i < N; ++i)
+    {
+        for (auto j = 0u; j < n; ++j)
+        {
+            // includes zeros and negative values (div by zero, pow and sqrt of |x|)
+            double value = (i % 17u == 0u) ? 0. : std::uniform_real_distribution<double>(-3, 3)(re);
+            rows.set_in(i, j, value);
+            columns.set_in(i, j, value);
+        }
+    }
+    // several expressions, sharing nothing
+    for (auto k = 0u; k < 3u; ++k)
+    {
+        ex.mutate_active();
+        dcgp::compiled_expression compiled(ex);
+        if (compiled.get_n() != n || compiled.get_m() != m) return true;
+        std::vector<double> batch_rows(N * m), batch_columns(N * m);
+        compiled(rows, batch_rows.data());
+        compiled(columns, batch_columns.data());
+        std::vector<double> in(n);
+        for (auto i = 0u; i < N; ++i)
+        {
+            for (auto j = 0u; j < n; ++j) in[j] = rows.in(i, j);
+            std::vector<double> expected = ex(in);
+            std::vector<double> out = compiled(in);
+            for (auto j = 0u; j < m; ++j)
+            {
+                if (!same_bits(out[j], expected[j])) return true;
+                if (!same_bits(batch_rows[i * m + j], expected[j])) return true;
+                if (!same_bits(batch_columns[i * m + j], expected[j])) return true;
+            }
+        }
+    }
+    return false;
+}
+
+/// Compilation failures are reported
+bool test_compiler_error_fails()
+{
+    dcgp::function_set basic_set({"sum","diff","mul","div"});
+    dcgp::expression ex(2, 1, 2, 3, 4, basic_set(), 123);
+    try {
+        dcgp::compiled_expression compiled(ex, "cc", "-DNOT_A_FLAG -fno-such-option");
+    } catch (const dcgp::input_error&) {
+        return false;
+    }
+    return true;
+}
+
+/// This test checks the C code generation
+int main() {
+    return test_fails(2, 1, 1, 20, 21, 1000, 123) ||
+           test_fails(3, 2, 2, 10, 11, 1000, 456) ||
+           test_fails(1, 3, 5, 5, 6, 100, 789) ||
+           test_fails(4, 4, 1, 50, 51, 500, 1) ||
+           test_compiler_error_fails();
+}
@@ -0,0 +1,152 @@
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "../src/dcgp.h"
+
+// equality of the outputs, bit-for-bit if numbers (NaNs may differ in sign and payload)
+bool same(double a, double b)
+{
+    if (std::isnan(a) || std::isnan(b)) return std::isnan(a) && std::isnan(b);
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+/// Checks that frozen models (also rebuilt from their blob) predict the outputs of the expression
+bool test_fails(
+        unsigned int n,
+        unsigned int m,
+        unsigned int r,
+        unsigned int c,
+        unsigned int l,
+        unsigned int N, // number of points
+        unsigned int seed)
+{
+    dcgp::function_set all_set({"sum","diff","mul","div","pow","sqrt"});
+    dcgp::expression ex(n, m, r, c, l, all_set(), seed);
+    std::default_random_engine re(seed);
+    std::vector<double> in(N * n);
+    for (auto &x : in) x = std::uniform_real_distribution<double>(-3, 3)(re);
+    for (auto i = 0u; i < N; i += 13u) in[i * n] = 0.;
+
+    for (auto k = 0u; k < 5u; ++k)
+    {
+        ex.mutate_active();
+        dcgp::compiled_model model(ex);
+        std::vector<char> blob = model.serialize();
+        dcgp::compiled_model loaded(blob.data(), blob.size());
+        if (loaded.get_n() != n || loaded.get_m() != m || loaded.get_operations() != model.get_operations()) return true;
+
+        std::vector<double> out(N * m), out_loaded(N * m), workspace;
+        model.predict(in.data(), out.data(), N);
+        loaded.predict(in.data(), out_loaded.data(), N, workspace);
+        if (workspace.size() != loaded.get_workspace_size()) return true;
+        // concurrent predictions
+        std::vector<std::vector<double> > outs(4, std::vector<double>(N * m));
+        std::vector<std::thread> threads;
+        for (auto t = 0u; t < 4u; ++t)
+        {
+            threads.emplace_back([&loaded, &in, &outs, t, N]() {loaded.predict(in.data(), outs[t].data(), N);});
+        }
+        for (auto &th : threads) th.join();
+        for (auto i = 0u; i < N; ++i)
+        {
+            std::vector<double> point(in.begin() + i * n, in.begin() + (i + 1) * n);
+            std::vector<double> expected = ex(point);
+            for (auto j = 0u; j < m; ++j)
+            {
+                if (!same(out[i * m + j], expected[j]) || !same(out_loaded[i * m + j], expected[j])) return true;
+                for (auto t = 0u; t < 4u; ++t)
+                {
+                    if (!same(outs[t][i * m + j], expected[j])) return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+/// Registers are reused, and models still too large for the workspace on the stack predict in the workspace of the caller
+bool test_large_fails(unsigned int length, unsigned int N)
+{
+    dcgp::function_set sum_set({"sum"});
+    // a chain of sums: node k adds x to node k - 1, so that all nodes are active, either as one output or all outputs
+    for (unsigned int m : {1u, length})
+    {
+        dcgp::expression ex(1, m, 1, length, length + 1u, sum_set(), 123);
+        std::vector<unsigned int> x = ex.get();
+        for (auto k = 1u; k < length; ++k)
+        {
+            x[k * 3u + 1u] = k;
+            x[k * 3u + 2u] = 0u;
+        }
+        for (auto j = 0u; j < m; ++j)
+        {
+            x[length * 3u + j] = length - j;
+        }
+        ex.set(x);
+        dcgp::compiled_model model(ex);
+        std::vector<double> in(N), out(N * m), workspace;
+        for (auto i = 0u; i < N; ++i) in[i] = 0.01 * i;
+        if (m == 1u)
+        {
+            // x and the last sum are live at once
+            if (model.get_operations() != length || model.get_registers() > 3u) return true;
+            model.predict(in.data(), out.data(), N);
+        }
+        else
+        {
+            // all the sums are live until the end, the last one taking the register of x
+            if (model.get_registers() != length || model.get_workspace_size() < 64u * length) return true;
+            try {
+                model.predict(in.data(), out.data(), N);
+                return true;
+            } catch (const dcgp::input_error&) {}
+            model.predict(in.data(), out.data(), N, workspace);
+            if (workspace.size() != model.get_workspace_size()) return true;
+        }
+        for (auto i = 0u; i < N; ++i)
+        {
+            std::vector<double> expected = ex(std::vector<double>{in[i]});
+            for (auto j = 0u; j < m; ++j)
+            {
+                if (!same(out[i * m + j], expected[j])) return true;
+            }
+        }
+    }
+    return false;
+}
+
+/// A corrupted blob must be rejected
+bool test_corrupted_fails()
+{
+    dcgp::function_set sum_set({"sum"});
+    dcgp::expression ex(2, 1, 1, 1, 1, sum_set(), 123);
+    ex.set({0, 0, 1, 2}); // x0 + x1
+    std::vector<char> blob = dcgp::compiled_model(ex).serialize();
+    std::vector<std::vector<char> > corrupted(3, blob);
+    corrupted[0][0] = 'X';
+    corrupted[1].pop_back();
+    // the sum reads a register not yet written (the header takes 32 bytes)
+    std::memset(corrupted[2].data() + 32 + 4, 0x7f, 4);
+    for (const auto &c : corrupted)
+    {
+        try {
+            dcgp::compiled_model model(c.data(), c.size());
+            return true;
+        } catch (const dcgp::input_error&) {}
+    }
+    return false;
+}
+
+/// This test checks the frozen inference models
+int main() {
+    return test_fails(2, 1, 1, 20, 21, 1000, 123) ||
+           test_fails(3, 2, 2, 10, 11, 5000, 456) ||
+           test_fails(1, 3, 5, 5, 6, 7, 789) ||
+           test_fails(4, 4, 1, 50, 51, 3000, 1) ||
+           test_large_fails(300u, 1000u) ||
+           test_corrupted_fails();
+}
@@ -0,0 +1,93 @@
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "../src/dcgp.h"
+
+/// Checks that a CSV file is parsed exactly, whatever the number of threads
+bool test_fails(
+        unsigned int n,
+        unsigned int m,
+        unsigned int N, // number of points
+        dcgp::dataset_layout layout,
+        unsigned int n_threads)
+{
+    std::default_random_engine re(123);
+    dcgp::dataset data(N, n, m, layout);
+    {
+        std::ofstream os("test_csv.csv");
+        os << "header line, ignored\r\n";
+        for (auto i = 0u; i < N; ++i)
+        {
+            for (auto j = 0u; j < n + m; ++j)
+            {
+                double value = std::uniform_real_distribution<double>(-1e3, 1e3)(re);
+                // short decimals (fast path) and full precision values (slow path)
+                if (j % 2u == 0u) value = static_cast<int>(value * 100) / 100.;
+                if (j < n) data.set_in(i, j, value);
+                else data.set_out(i, j - n, value);
+                os << std::setprecision(j % 2u == 0u ? 6 : 17) << value << (j + 1u < n + m ? " , " : "");
+            }
+            os << (i % 3u == 0u ? "\r\n" : "\n");
+            if (i % 7u == 0u) os << "\n";
+        }
+    }
+    dcgp::dataset parsed = dcgp::load_csv("test_csv.csv", n, m, layout, true, ',', n_threads);
+    if (parsed.rows() != N || parsed.get_n() != n || parsed.get_m() != m || parsed.layout() != layout) return true;
+    for (auto i = 0u; i < N; ++i)
+    {
+        for (auto j = 0u; j < n + m; ++j)
+        {
+            if (parsed.row(i)[j] != data.row(i)[j]) return true;
+        }
+    }
+
+    // conversion to the binary format
+    dcgp::csv_to_binary_dataset("test_csv.csv", "test_csv.bin", n, m, true, ',', n_threads);
+    dcgp::dataset mapped = dcgp::load_binary_dataset("test_csv.bin");
+    std::remove("test_csv.csv");
+    std::remove("test_csv.bin");
+    if (mapped.rows() != N) return true;
+    for (auto i = 0u; i < N; ++i)
+    {
+        for (auto j = 0u; j < n + m; ++j)
+        {
+            if (mapped.row(i)[j] != data.row(i)[j]) return true;
+        }
+    }
+    return false;
+}
+
+/// A malformed CSV file must be rejected
+bool test_invalid_fails(const std::string& content)
+{
+    {
+        std::ofstream os("test_csv_invalid.csv");
+        os << content;
+    }
+    bool fails = true;
+    try {
+        dcgp::load_csv("test_csv_invalid.csv", 2, 1, dcgp::COLUMN_MAJOR, false, ',', 2);
+    } catch (const dcgp::input_error&) {
+        fails = false;
+    }
+    std::remove("test_csv_invalid.csv");
+    return fails;
+}
+
+/// This test checks the parallel CSV loader
+int main() {
+    return test_fails(2, 1, 100, dcgp::COLUMN_MAJOR, 1) ||
+           test_fails(2, 1, 100, dcgp::ROW_MAJOR, 4) ||
+           test_fails(3, 2, 10001, dcgp::COLUMN_MAJOR, 7) ||
+           test_fails(1, 1, 3, dcgp::COLUMN_MAJOR, 16) ||
+           test_fails(4, 1, 0, dcgp::ROW_MAJOR, 3) ||
+           test_fails(5, 3, 5000, dcgp::ROW_MAJOR, 0) ||
+           test_invalid_fails("1,2,3\n4,5\n") ||
+           test_invalid_fails("1,2,3\n4,5,6,7\n") ||
+           test_invalid_fails("1,2,3\n4,x,6\n") ||
+           test_invalid_fails("1;2;3\n");
+}
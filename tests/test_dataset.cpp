@@ -0,0 +1,87 @@
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <cstdint>
+
+#include "../src/dcgp.h"
+
+/// Checks storage, views and slices of a dataset against the nested vectors it was built from
+bool test_fails(
+        unsigned int n,
+        unsigned int m,
+        unsigned int N, // number of points
+        dcgp::dataset_layout layout)
+{
+    std::default_random_engine re(123);
+    std::vector<std::vector<double> > in(N, std::vector<double>(n)), out(N, std::vector<double>(m));
+    for (auto i = 0u; i < N; ++i)
+    {
+        for (auto j = 0u; j < n; ++j) in[i][j] = std::uniform_real_distribution<double>(-1, 1)(re);
+        for (auto j = 0u; j < m; ++j) out[i][j] = std::uniform_real_distribution<double>(-1, 1)(re);
+    }
+    dcgp::dataset data(in, out, layout);
+    if (data.rows() != N || data.get_n() != n || data.get_m() != m) return true;
+
+    // one aligned allocation, aligned columns
+    if (reinterpret_cast<std::uintptr_t>(data.data()) % 64 != 0) return true;
+    if (layout == dcgp::COLUMN_MAJOR && (data.ld() * sizeof(double)) % 64 != 0) return true;
+
+    for (auto i = 0u; i < N; ++i)
+    {
+        for (auto j = 0u; j < n; ++j)
+        {
+            if (data.in(i, j) != in[i][j] || data.row(i)[j] != in[i][j] || data.column(j)[i] != in[i][j]) return true;
+        }
+        for (auto j = 0u; j < m; ++j)
+        {
+            if (data.out(i, j) != out[i][j] || data.row(i)[n + j] != out[i][j] || data.column(n + j)[i] != out[i][j]) return true;
+        }
+    }
+
+    // slices share the storage
+    dcgp::dataset half = data.slice(N / 2, N - N / 2);
+    for (auto i = 0u; i < half.rows(); ++i)
+    {
+        if (half.in(i, 0) != in[N / 2 + i][0] || half.out(i, m - 1) != out[N / 2 + i][m - 1]) return true;
+    }
+    data.set_in(N - 1, 0, 42.);
+    if (half.in(half.rows() - 1, 0) != 42.) return true;
+    data.set_in(N - 1, 0, in[N - 1][0]);
+
+    try {
+        data.slice(N / 2, N);
+        return true;
+    } catch (const dcgp::input_error&) {}
+
+    // the fitness on a dataset must be the same as on the nested vectors
+    dcgp::function_set basic_set({"sum","diff","mul","div"});
+    dcgp::expression ex(n, m, 3, 5, 6, basic_set(), 123);
+    for (auto k = 0u; k < 10; ++k)
+    {
+        ex.mutate_active();
+        if (dcgp::simple_data_fit(ex, data) != dcgp::simple_data_fit(ex, in, out)) return true;
+        if (dcgp::simple_data_fit(ex, data, dcgp::HITS_BASED, 0.5) != dcgp::simple_data_fit(ex, in, out, dcgp::HITS_BASED, 0.5)) return true;
+        // and so must be the outputs
+        std::vector<double> outputs = ex.eval(data);
+        if (outputs.size() != N * m) return true;
+        for (auto i = 0u; i < N; ++i)
+        {
+            std::vector<double> expected = ex(in[i]);
+            for (auto j = 0u; j < m; ++j)
+            {
+                if (outputs[i * m + j] != expected[j] && !(std::isnan(outputs[i * m + j]) && std::isnan(expected[j]))) return true;
+            }
+        }
+    }
+    return false;
+}
+
+/// This test checks the dcgp::dataset container in both layouts
+int main() {
+    return test_fails(2, 4, 100, dcgp::ROW_MAJOR) ||
+           test_fails(2, 4, 100, dcgp::COLUMN_MAJOR) ||
+           test_fails(1, 1, 13, dcgp::COLUMN_MAJOR) ||
+           test_fails(5, 3, 1000, dcgp::ROW_MAJOR) ||
+           test_fails(5, 3, 1001, dcgp::COLUMN_MAJOR);
+}
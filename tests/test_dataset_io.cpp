@@ -0,0 +1,125 @@
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "../src/dcgp.h"
+
+/// Checks that a dataset saved in binary form is memory-mapped back unchanged
+bool test_fails(
+        unsigned int n,
+        unsigned int m,
+        unsigned int N, // number of points
+        dcgp::dataset_layout layout)
+{
+    std::default_random_engine re(123);
+    dcgp::dataset data(N, n, m, layout);
+    for (auto i = 0u; i < N; ++i)
+    {
+        for (auto j = 0u; j < n; ++j) data.set_in(i, j, std::uniform_real_distribution<double>(-1, 1)(re));
+        for (auto j = 0u; j < m; ++j) data.set_out(i, j, std::uniform_real_distribution<double>(-1, 1)(re));
+    }
+    dcgp::save_binary_dataset(data, "test_dataset_io.bin");
+    dcgp::dataset mapped = dcgp::load_binary_dataset("test_dataset_io.bin");
+    // the mapping must outlive the file name
+    std::remove("test_dataset_io.bin");
+
+    if (mapped.rows() != N || mapped.get_n() != n || mapped.get_m() != m || mapped.writable()) return true;
+    if (mapped.layout() != dcgp::COLUMN_MAJOR || reinterpret_cast<std::uintptr_t>(mapped.data()) % 64 != 0) return true;
+    // a non-const read-only dataset can be read
+    for (auto i = 0u; i < N; ++i)
+    {
+        for (auto j = 0u; j < n + m; ++j)
+        {
+            if (mapped.row(i)[j] != data.row(i)[j]) return true;
+        }
+        if (mapped.in(i, 0) != data.in(i, 0) || mapped.out(i, m - 1) != data.out(i, m - 1)) return true;
+    }
+
+    // fitness evaluation reads straight from the mapping
+    dcgp::function_set basic_set({"sum","diff","mul","div"});
+    dcgp::expression ex(n, m, 3, 5, 6, basic_set(), 123);
+    for (auto k = 0u; k < 10; ++k)
+    {
+        ex.mutate_active();
+        if (dcgp::simple_data_fit(ex, mapped) != dcgp::simple_data_fit(ex, data)) return true;
+    }
+
+    // a mapped dataset is read-only
+    try {
+        mapped.writable_data();
+        return true;
+    } catch (const dcgp::input_error&) {}
+    try {
+        mapped.set_in(0, 0, 1.);
+        return true;
+    } catch (const dcgp::input_error&) {}
+    try {
+        mapped.set_out(0, 0, 1.);
+        return true;
+    } catch (const dcgp::input_error&) {}
+    return false;
+}
+
+/// A file that is not a binary dataset must be rejected
+bool test_invalid_fails()
+{
+    {
+        std::ofstream os("test_dataset_io_invalid.bin", std::ios::binary);
+        os << std::string(200, 'x');
+    }
+    bool fails = true;
+    try {
+        dcgp::load_binary_dataset("test_dataset_io_invalid.bin");
+    } catch (const dcgp::input_error&) {
+        fails = false;
+    }
+    std::remove("test_dataset_io_invalid.bin");
+    return fails;
+}
+
+/// A header whose number of rows wraps around when multiplied must be rejected
+bool test_overflow_fails()
+{
+    dcgp::dataset data(10, 2, 1);
+    dcgp::save_binary_dataset(data, "test_dataset_io_overflow.bin");
+    std::string bytes;
+    {
+        std::ifstream is("test_dataset_io_overflow.bin", std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+    }
+    // 2^61 rows of 8 bytes are 2^64 bytes per column
+    const std::uint64_t rows = std::uint64_t(1u) << 61u;
+    std::memcpy(&bytes[32], &rows, sizeof(rows));
+    {
+        std::ofstream os("test_dataset_io_overflow.bin", std::ios::binary | std::ios::trunc);
+        os.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+    bool fails = false;
+    try {
+        dcgp::load_binary_dataset("test_dataset_io_overflow.bin");
+        fails = true;
+    } catch (const dcgp::input_error&) {}
+    try {
+        dcgp::binary_file_source source("test_dataset_io_overflow.bin");
+        fails = true;
+    } catch (const dcgp::input_error&) {}
+    std::remove("test_dataset_io_overflow.bin");
+    return fails;
+}
+
+/// This test checks the binary dataset format round trip
+int main() {
+    return test_fails(2, 4, 100, dcgp::ROW_MAJOR) ||
+           test_fails(2, 4, 100, dcgp::COLUMN_MAJOR) ||
+           test_fails(1, 1, 13, dcgp::COLUMN_MAJOR) ||
+           test_fails(5, 3, 10001, dcgp::ROW_MAJOR) ||
+           test_fails(3, 1, 0, dcgp::COLUMN_MAJOR) ||
+           test_invalid_fails() ||
+           test_overflow_fails();
+}
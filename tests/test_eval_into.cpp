@@ -0,0 +1,77 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <random>
+#include <vector>
+
+#include "../src/dcgp.h"
+
+// Counts the heap allocations of the whole program
+static unsigned long allocations = 0u;
+
+void* operator new(std::size_t size)
+{
+    ++allocations;
+    if (void *p = std::malloc(size == 0u ? 1u : size)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+/// Checks that the workspace versions give the same results as operator() and differentiate, without allocating
+bool test_fails(
+        unsigned int n,
+        unsigned int m,
+        unsigned int r,
+        unsigned int c,
+        unsigned int l,
+        unsigned int order,
+        unsigned int seed)
+{
+    dcgp::function_set all_set({"sum","diff","mul","div","pow","sqrt"});
+    dcgp::expression ex(n, m, r, c, l, all_set(), seed);
+    std::default_random_engine re(seed);
+    std::vector<double> in(n), out(m), jets((order + 1) * m);
+    dcgp::workspace ws;
+    for (auto k = 0u; k < 50u; ++k)
+    {
+        ex.mutate_active();
+        for (auto j = 0u; j < n; ++j) in[j] = std::uniform_real_distribution<double>(0.5, 3)(re);
+        std::vector<double> expected = ex(in);
+        ex.eval_into(in.data(), out.data(), ws);
+        if (std::memcmp(out.data(), expected.data(), m * sizeof(double)) != 0) return true;
+        const unsigned int wrt = k % n;
+        std::vector<std::vector<double> > expected_jets = ex.differentiate(wrt, order, in);
+        ex.differentiate_into(wrt, order, in.data(), jets.data(), ws);
+        for (auto j = 0u; j <= order; ++j)
+        {
+            if (std::memcmp(&jets[j * m], expected_jets[j].data(), m * sizeof(double)) != 0) return true;
+        }
+
+        // once warm, evaluating again does not allocate
+        const unsigned long before = allocations;
+        for (auto i = 0u; i < 10u; ++i)
+        {
+            ex.eval_into(in.data(), out.data(), ws);
+            ex.differentiate_into(wrt, order, in.data(), jets.data(), ws);
+        }
+        if (allocations != before) return true;
+    }
+    try {
+        ex.differentiate_into(n, order, in.data(), jets.data(), ws);
+        return true;
+    } catch (const dcgp::input_error&) {}
+    return false;
+}
+
+/// This test checks the allocation-free evaluation and differentiation
+int main() {
+    return test_fails(2, 1, 1, 20, 21, 2, 123) ||
+           test_fails(3, 2, 2, 10, 11, 4, 456) ||
+           test_fails(1, 3, 5, 5, 6, 1, 789) ||
+           test_fails(4, 4, 1, 50, 51, 0, 1);
+}
@@ -0,0 +1,115 @@
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/dcgp.h"
+
+// Runs some instrumented work: evaluations, mutations and one fitness computation on data having a NaN target output
+void work(unsigned int seed, unsigned int evaluations, unsigned int mutations)
+{
+    dcgp::function_set basic_set({"sum","diff","mul","div"});
+    dcgp::expression ex(2, 1, 1, 10, 11, basic_set(), seed);
+    dcgp::workspace ws;
+    std::vector<double> in = {1.5, -0.5}, out(1);
+    for (auto i = 0u; i < evaluations; ++i)
+    {
+        ex.eval_into(in.data(), out.data(), ws);
+    }
+    for (auto i = 0u; i < mutations; ++i)
+    {
+        ex.mutate_active();
+    }
+    dcgp::dataset data({{0., 0.}, {1., 1.}}, {{0.}, {1.}});
+    dcgp::simple_data_fit(ex, data);
+}
+
+/// Checks the counters (or that they stay at zero when the instrumentation is not built)
+bool test_fails(unsigned int n_threads)
+{
+    dcgp::reset_instrumentation();
+    std::vector<std::thread> threads;
+    for (auto t = 0u; t < n_threads; ++t)
+    {
+        threads.emplace_back(work, 123u + t, 1000u, 100u);
+    }
+    for (auto &th : threads)
+    {
+        th.join();
+    }
+    const dcgp::instrumentation_snapshot s = dcgp::get_instrumentation();
+    if (s.m_enabled != dcgp::instrumentation_enabled()) return true;
+    if (s.to_json().find(s.m_enabled ? "\"enabled\": true" : "\"enabled\": false") == std::string::npos) return true;
+    if (s.to_text().find("instrumentation: ") != 0u) return true;
+    if (!s.m_enabled)
+    {
+        return s.m_counters[dcgp::COUNT_EVALUATIONS] != 0u || s.m_timer_calls[dcgp::TIME_MUTATION] != 0u;
+    }
+
+    // 1000 evaluations with eval_into and 2 points of the fitness per thread
+    if (s.m_counters[dcgp::COUNT_EVALUATIONS] != n_threads * 1002u) return true;
+    if (s.m_counters[dcgp::COUNT_MUTATIONS] != n_threads * 100u) return true;
+    if (s.m_counters[dcgp::COUNT_FITNESS_POINTS] != n_threads * 2u) return true;
+    // the construction and the mutations which changed a gene update the active nodes
+    if (s.m_counters[dcgp::COUNT_ACTIVE_UPDATES] < n_threads || s.m_counters[dcgp::COUNT_ACTIVE_UPDATES] > n_threads * 101u) return true;
+    unsigned long long histogram = 0u, ops = 0u;
+    for (auto k = 0u; k < dcgp::instrumentation_active_buckets; ++k) histogram += s.m_active_sizes[k];
+    for (auto k = 0u; k < dcgp::N_INSTRUMENTATION_NODE_OPS; ++k) ops += s.m_node_ops[k];
+    if (histogram != s.m_counters[dcgp::COUNT_ACTIVE_UPDATES]) return true;
+    if (ops < s.m_counters[dcgp::COUNT_EVALUATIONS] || s.m_node_ops[dcgp::NODE_POW] != 0u || s.m_node_ops[dcgp::NODE_OTHER] != 0u) return true;
+    if (s.m_timer_calls[dcgp::TIME_MUTATION] != n_threads * 100u || s.m_timer_calls[dcgp::TIME_FITNESS] != n_threads) return true;
+    // the workspace grew once per thread
+    if (s.m_counters[dcgp::COUNT_ALLOCATIONS] < n_threads) return true;
+
+    dcgp::reset_instrumentation();
+    return dcgp::get_instrumentation().m_counters[dcgp::COUNT_EVALUATIONS] != 0u;
+}
+
+/// Checks the non finite outputs
+bool test_non_finite_fails()
+{
+    dcgp::function_set div_set({"div"});
+    dcgp::expression ex(1, 1, 1, 1, 1, div_set(), 123);
+    // x / x is NaN in 0
+    ex.set({0, 0, 0, 1});
+    dcgp::reset_instrumentation();
+    dcgp::dataset data({{0.}, {1.}, {2.}}, {{1.}, {1.}, {1.}});
+    if (dcgp::simple_data_fit(ex, data) != 2.) return true;
+    return dcgp::get_instrumentation().m_counters[dcgp::COUNT_NON_FINITE_OUTPUTS] != (dcgp::instrumentation_enabled() ? 1u : 0u);
+}
+
+/// Checks that the evaluations of some outputs count the node operations they computed, as those of all outputs
+bool test_outputs_fails()
+{
+    dcgp::function_set set({"sum","mul"});
+    dcgp::expression ex(1, 2, 1, 3, 4, set(), 123);
+    // the outputs x * (x + x) and x * x
+    ex.set({0, 0, 0, 1, 1, 0, 1, 0, 0, 2, 3});
+    dcgp::workspace ws;
+    const double in = 2.;
+    const unsigned int outputs[2] = {0u, 1u};
+    double out[2];
+    const unsigned long long enabled = dcgp::instrumentation_enabled() ? 1u : 0u;
+    dcgp::reset_instrumentation();
+    ex.eval_into(&in, out, ws);
+    dcgp::instrumentation_snapshot s = dcgp::get_instrumentation();
+    if (s.m_counters[dcgp::COUNT_EVALUATIONS] != enabled || s.m_node_ops[dcgp::NODE_SUM] != enabled || s.m_node_ops[dcgp::NODE_MUL] != 2u * enabled) return true;
+    dcgp::reset_instrumentation();
+    ex.eval_outputs_into(&in, outputs, 2u, out, ws);
+    s = dcgp::get_instrumentation();
+    if (s.m_counters[dcgp::COUNT_EVALUATIONS] != enabled || s.m_node_ops[dcgp::NODE_SUM] != enabled || s.m_node_ops[dcgp::NODE_MUL] != 2u * enabled) return true;
+    // the first output only needs the sum and one product
+    dcgp::reset_instrumentation();
+    ex.eval_outputs_into(&in, outputs, 1u, out, ws);
+    s = dcgp::get_instrumentation();
+    return s.m_counters[dcgp::COUNT_EVALUATIONS] != enabled || s.m_node_ops[dcgp::NODE_SUM] != enabled || s.m_node_ops[dcgp::NODE_MUL] != enabled;
+}
+
+/// This test checks the instrumentation counters
+int main() {
+    return test_fails(1) ||
+           test_fails(4) ||
+           test_non_finite_fails() ||
+           test_outputs_fails();
+}
@@ -0,0 +1,109 @@
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "../src/dcgp.h"
+
+/// Checks that the outputs on random points of random boxes are in the enclosures computed on the boxes
+bool test_enclosure_fails(const std::vector<std::string>& functions, unsigned int seed)
+{
+    const double inf = std::numeric_limits<double>::infinity();
+    dcgp::function_set set(functions);
+    std::default_random_engine re(seed);
+    std::uniform_real_distribution<double> dist(-3., 3.);
+    // box bounds, including zeros and infinities
+    const double special[] = {0., -0., 1., -1., inf, -inf};
+    for (auto trial = 0u; trial < 200u; ++trial)
+    {
+        dcgp::expression ex(2, 2, 3, 6, 7, set(), seed + trial);
+        std::vector<dcgp::interval> box(2);
+        std::vector<std::vector<double> > values(2);
+        for (auto j = 0u; j < 2u; ++j)
+        {
+            double lo = dist(re), hi = dist(re);
+            if (trial % 3u == 1u) lo = special[(trial + j) % 6u];
+            if (lo > hi) std::swap(lo, hi);
+            // the bounds, zero if inside, and random points
+            values[j] = {lo, hi};
+            if (lo <= 0. && 0. <= hi) values[j].push_back(0.);
+            for (auto k = 0u; k < 10u; ++k) values[j].push_back(std::uniform_real_distribution<double>(std::max(lo, -1e10), std::min(hi, 1e10))(re));
+            for (auto v : values[j]) box[j].add(v);
+            if (trial % 7u == 0u)
+            {
+                box[j].m_nan = true;
+                values[j].push_back(std::numeric_limits<double>::quiet_NaN());
+            }
+        }
+        const std::vector<dcgp::interval> enclosure = ex(box);
+        for (auto a : values[0])
+        {
+            for (auto b : values[1])
+            {
+                const std::vector<double> out = ex(std::vector<double>{a, b});
+                for (auto k = 0u; k < out.size(); ++k)
+                {
+                    if (!enclosure[k].contains(out[k]))
+                    {
+                        std::cout << ex << "\non " << box[0] << " x " << box[1] << ": " << out[k] << " not in " << enclosure[k] << " for " << a << ", " << b << std::endl;
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+    return false;
+}
+
+/// Checks the expressions which are provably never finite, and the pre-screened fitness
+bool test_prescreen_fails()
+{
+    dcgp::function_set set({"diff","div","pow"});
+    dcgp::dataset data({{0.5}, {1.}, {2.}, {-3.}}, {{1.}, {1.}, {1.}, {1.}});
+    const std::vector<dcgp::interval> box = dcgp::input_box(data);
+    if (box.size() != 1u || box[0].m_lo != -3. || box[0].m_hi != 2. || box[0].m_nan) return true;
+    dcgp::expression ex(1, 1, 1, 2, 3, set(), 123);
+    // x / (x - x): inf or NaN everywhere
+    ex.set({0, 0, 0, 1, 0, 1, 2});
+    if (!dcgp::nowhere_finite(ex, box) || dcgp::simple_data_fit(ex, data, box) != 0. || dcgp::simple_data_fit(ex, data) != 0.) return true;
+    // pow(|x - x|, x) = pow(0, x) is 0 for x > 0, but inf everywhere on negative inputs
+    ex.set({0, 0, 0, 2, 1, 0, 2});
+    if (dcgp::nowhere_finite(ex, box) || !dcgp::nowhere_finite(ex, {dcgp::interval(-3., -1.)})) return true;
+    // (x / x) - x is finite
+    ex.set({1, 0, 0, 0, 1, 0, 2});
+    if (dcgp::nowhere_finite(ex, box)) return true;
+    // the pre-screened fitness is the same as the plain one
+    for (auto seed = 0u; seed < 100u; ++seed)
+    {
+        dcgp::expression other(1, 1, 2, 5, 6, set(), seed);
+        if (dcgp::simple_data_fit(other, data, box) != dcgp::simple_data_fit(other, data)) return true;
+    }
+    return false;
+}
+
+/// Checks the set operations
+bool test_interval_fails()
+{
+    const double inf = std::numeric_limits<double>::infinity();
+    dcgp::interval i;
+    if (!i.is_empty() || i.has_finite()) return true;
+    i.add_range(1., inf);
+    if (!i.m_pos_inf || i.m_neg_inf || i.m_lo != 1. || i.m_hi != std::numeric_limits<double>::max()) return true;
+    if (dcgp::interval(inf).has_finite() || !dcgp::interval(inf).contains(inf) || dcgp::interval(-2., 2.).contains(3.)) return true;
+    const dcgp::interval e = dcgp::interval::entire();
+    if (!e.contains(0.) || !e.contains(-inf) || !e.contains(std::numeric_limits<double>::quiet_NaN())) return true;
+    // basis functions without an interval version can return anything
+    dcgp::basis_function f(dcgp::my_sum, dcgp::d_my_sum, dcgp::print_my_sum, "custom");
+    const dcgp::interval out = f(dcgp::interval(1.), dcgp::interval(2.));
+    return !out.m_nan || !out.m_pos_inf || !out.contains(3.);
+}
+
+/// This test checks the interval arithmetic and the pre-screening of the never finite expressions
+int main() {
+    return test_interval_fails() ||
+           test_enclosure_fails({"sum","diff","mul","div"}, 123u) ||
+           test_enclosure_fails({"sum","diff","mul","div","sqrt","pow"}, 456u) ||
+           test_enclosure_fails({"div","pow"}, 789u) ||
+           test_prescreen_fails();
+}
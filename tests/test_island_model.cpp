@@ -0,0 +1,95 @@
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <atomic>
+#include <cmath>
+
+#include "../src/dcgp.h"
+
+bool test_fails(
+        unsigned int n_islands,
+        dcgp::migration_topology topology,
+        unsigned int N) // number of samples
+{
+    dcgp::function_set basic_set({"sum","diff","mul","div"});
+    dcgp::expression prototype(1, 1, 1, 15, 16, basic_set(), 123);
+
+    // 1) we create N data points
+    std::default_random_engine re(12);
+    std::vector<std::vector<double> > in;
+    std::vector<std::vector<double> > out;
+
+    // Koza quartic polynomial x^4 + x^3 + x^2 + x
+    std::function<double(double)> f = [](double x){return x*x*x*x + x*x*x + x*x + x;};
+    for (auto i = 0u; i < N; ++i)
+    {
+        double x = std::uniform_real_distribution<double>(-1, 1)(re);
+        in.push_back({x});
+        out.push_back({f(x)});
+    }
+
+    /// 2) we evolve the islands until one fits all points (maximization problem)
+    dcgp::island_model archipelago(prototype, [&in, &out](const dcgp::expression& ex) {return dcgp::simple_data_fit(ex, in, out, dcgp::fitness_type::HITS_BASED, 1e-8);}, n_islands, topology, 4u, 10u, 123u);
+    bool solved = archipelago.evolve(200000u, N);
+
+    dcgp::expression ex = prototype;
+    ex.set(archipelago.get_best_chromosome());
+    std::vector<std::string> in_sym({"x"});
+    std::cout << "Islands: " << n_islands << ", edges: " << archipelago.get_edges().size() << std::endl;
+    std::cout << "Generations per island: " << archipelago.get_generations() << std::endl;
+    std::cout << "Migrants accepted: " << archipelago.get_accepted_migrants() << ", dropped: " << archipelago.get_dropped_migrants() << std::endl;
+    std::cout << "Final expression: " << ex(in_sym) << std::endl;
+
+    // the best chromosome must have the fitness reported
+    return !solved || dcgp::simple_data_fit(ex, in, out, dcgp::fitness_type::HITS_BASED, 1e-8) != archipelago.get_best_fitness();
+}
+
+/// An island whose offspring all have NaN fitness must keep its parent
+bool test_nan_offspring_fails()
+{
+    dcgp::function_set basic_set({"sum","diff","mul","div"});
+    dcgp::expression prototype(1, 1, 1, 15, 16, basic_set(), 123);
+    // the parent (evaluated first) has fitness -inf, all the offspring NaN
+    std::atomic<unsigned int> calls(0u);
+    auto fitness = [&calls](const dcgp::expression&) {return (calls++ == 0u) ? -std::numeric_limits<double>::infinity() : std::nan("");};
+    dcgp::island_model archipelago(prototype, fitness, 1u, dcgp::migration_topology::RING, 4u, 10u, 123u);
+    if (archipelago.evolve(20u, 1.)) return true;
+    return archipelago.get_best_chromosome().size() != prototype.get().size() || archipelago.get_best_fitness() != -std::numeric_limits<double>::infinity();
+}
+
+/// Migrants are written in place into the slots of a channel, reusing their storage
+bool test_channel_slots_fails()
+{
+    dcgp::spsc_queue<std::vector<unsigned int> > channel(2u, std::vector<unsigned int>(5u));
+    std::vector<unsigned int> chromosome = {1u, 2u, 3u, 4u, 5u};
+    for (auto k = 0u; k < 2u; ++k)
+    {
+        std::vector<unsigned int> *slot = channel.claim();
+        if (!slot) return true;
+        const unsigned int *storage = slot->data();
+        *slot = chromosome;
+        if (slot->data() != storage) return true;
+        channel.publish();
+    }
+    // full: nothing is claimed
+    if (channel.claim() != nullptr) return true;
+    unsigned int popped = 0u;
+    while (std::vector<unsigned int> *slot = channel.front())
+    {
+        if (*slot != chromosome) return true;
+        channel.release();
+        ++popped;
+    }
+    return popped != 2u || !channel.empty();
+}
+
+/// This test evolves the Koza quartic polynomial with islands connected by different topologies and
+/// passes if a solution is found
+int main() {
+    return test_channel_slots_fails() ||
+           test_nan_offspring_fails() ||
+           test_fails(4, dcgp::migration_topology::RING, 10) ||
+           test_fails(4, dcgp::migration_topology::FULLY_CONNECTED, 10) ||
+           test_fails(5, dcgp::migration_topology::RANDOM, 10) ||
+           test_fails(1, dcgp::migration_topology::RING, 10);
+}
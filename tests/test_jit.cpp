@@ -0,0 +1,101 @@
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../src/dcgp.h"
+
+// bit-for-bit equality (NaNs included)
+bool same_bits(double a, double b)
+{
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+/// Checks that in-process compiled expressions compute bit-for-bit the outputs and fitness of the interpreter
+bool test_fails(
+        unsigned int n,
+        unsigned int m,
+        unsigned int r,
+        unsigned int c,
+        unsigned int l,
+        unsigned int N, // number of points
+        unsigned int seed)
+{
+    dcgp::function_set all_set({"sum","diff","mul","div","pow","sqrt"});
+    dcgp::expression ex(n, m, r, c, l, all_set(), seed);
+    std::default_random_engine re(seed);
+    dcgp::dataset data(N, n, m);
+    for (auto i = 0u; i < N; ++i)
+    {
+        for (auto j = 0u; j < n; ++j) data.set_in(i, j, (i % 17u == 0u) ? 0. : std::uniform_real_distribution<double>(-3, 3)(re));
+        for (auto j = 0u; j < m; ++j) data.set_out(i, j, std::uniform_real_distribution<double>(-3, 3)(re));
+    }
+    dcgp::jit_fitness fit(data, dcgp::ERROR_BASED, 1e-10, 1000u);
+    dcgp::jit_fitness hits(data, dcgp::HITS_BASED, 0.5, 1000u);
+    for (auto k = 0u; k < 10u; ++k)
+    {
+        ex.mutate_active();
+        dcgp::jit_expression compiled(ex);
+        if (compiled.get_n() != n || compiled.get_m() != m || compiled.get_code_size() == 0u) return true;
+        std::vector<double> in(n);
+        for (auto i = 0u; i < N; ++i)
+        {
+            for (auto j = 0u; j < n; ++j) in[j] = data.in(i, j);
+            std::vector<double> expected = ex(in), out = compiled(in);
+            for (auto j = 0u; j < m; ++j)
+            {
+                if (!same_bits(out[j], expected[j])) return true;
+            }
+        }
+        // all the points at once, through the packed loop and (N odd) the scalar tail
+        std::vector<std::vector<double>> in_columns(n, std::vector<double>(N)), out_columns(m, std::vector<double>(N));
+        std::vector<const double*> in_pointers;
+        std::vector<double*> out_pointers;
+        for (auto j = 0u; j < n; ++j)
+        {
+            for (auto i = 0u; i < N; ++i) in_columns[j][i] = data.in(i, j);
+            in_pointers.push_back(in_columns[j].data());
+        }
+        for (auto j = 0u; j < m; ++j) out_pointers.push_back(out_columns[j].data());
+        compiled(in_pointers.data(), out_pointers.data(), N);
+        for (auto i = 0u; i < N; ++i)
+        {
+            for (auto j = 0u; j < n; ++j) in[j] = data.in(i, j);
+            std::vector<double> expected = ex(in);
+            for (auto j = 0u; j < m; ++j)
+            {
+                if (!same_bits(out_columns[j][i], expected[j])) return true;
+            }
+        }
+        if (!same_bits(fit(ex), dcgp::simple_data_fit(ex, data))) return true;
+        if (hits(ex) != dcgp::simple_data_fit(ex, data, dcgp::HITS_BASED, 0.5)) return true;
+    }
+    // expressions with the same phenotype share their code
+    dcgp::expression copy(ex);
+    if (dcgp::phenotype_hash(copy) != dcgp::phenotype_hash(ex)) return true;
+    unsigned long misses = fit.get_cache().get_misses();
+    if (misses == 0u) return true;
+    fit(copy);
+    if (fit.get_cache().get_misses() != misses) return true;
+    return false;
+}
+
+/// Checks the amortization heuristic
+bool test_amortized_fails()
+{
+    return dcgp::jit_amortized(1u, 1u, 5u) || !dcgp::jit_amortized(100000u, 1u, 5u) || !dcgp::jit_amortized(100u, 100u, 5u);
+}
+
+/// This test checks the in-process x86-64 compilation
+int main() {
+    if (!dcgp::jit_available())
+    {
+        std::cout << "In-process compilation not available, skipping" << std::endl;
+        return 0;
+    }
+    return test_fails(2, 1, 1, 20, 21, 2000, 123) ||
+           test_fails(3, 2, 2, 10, 11, 1001, 456) ||
+           test_fails(1, 3, 5, 5, 6, 3000, 789) ||
+           test_fails(4, 4, 1, 50, 51, 500, 1) ||
+           test_amortized_fails();
+}
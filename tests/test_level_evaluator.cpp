@@ -0,0 +1,93 @@
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "../src/dcgp.h"
+
+/// Checks that no node depends on a node of its own or a higher level
+bool test_levels_fails(const dcgp::expression& ex, const dcgp::level_evaluator& le)
+{
+    std::vector<int> level(ex.get_n() + ex.get_r() * ex.get_c(), -1);
+    std::size_t count = 0u;
+    for (auto l = 0u; l < le.get_levels().size(); ++l)
+    {
+        for (auto i : le.get_levels()[l])
+        {
+            level[i] = static_cast<int>(l);
+            ++count;
+        }
+    }
+    if (count != ex.get_active_nodes().size()) return true;
+    const std::vector<unsigned int>& x = ex.get();
+    for (auto i : ex.get_active_nodes())
+    {
+        if (i < ex.get_n())
+        {
+            if (level[i] != 0) return true;
+            continue;
+        }
+        const unsigned int idx = (i - ex.get_n()) * 3u;
+        if (level[i] <= level[x[idx + 1u]]) return true;
+        if (ex.get_f()[x[idx]].m_arity > 1u && level[i] <= level[x[idx + 2u]]) return true;
+    }
+    return false;
+}
+
+/// Compares the outputs with those of dcgp::expression::eval_into (bit by bit, NaNs included)
+bool test_fails(unsigned int n, unsigned int m, unsigned int r, unsigned int c, unsigned int l, std::size_t rows, unsigned int n_threads, std::size_t tile, std::size_t chunk)
+{
+    dcgp::function_set set({"sum","diff","mul","div","sqrt"});
+    std::default_random_engine re(123u);
+    std::uniform_real_distribution<double> dist(-2., 2.);
+    std::vector<double> in(rows * n), expected(rows * m), out(rows * m);
+    for (auto &v : in) v = dist(re);
+    dcgp::workspace ws;
+    for (auto seed = 0u; seed < 5u; ++seed)
+    {
+        dcgp::expression ex(n, m, r, c, l, set(), seed);
+        for (auto k = 0u; k < rows; ++k)
+        {
+            ex.eval_into(&in[k * n], &expected[k * m], ws);
+        }
+        dcgp::level_evaluator le(ex, n_threads, tile, chunk);
+        if (test_levels_fails(ex, le)) return true;
+        // the evaluator can be reused
+        for (auto run = 0u; run < 2u; ++run)
+        {
+            std::fill(out.begin(), out.end(), 0.);
+            le(in.data(), out.data(), rows);
+            if (std::memcmp(out.data(), expected.data(), out.size() * sizeof(double)) != 0) return true;
+        }
+        // and used by several threads at the same time
+        std::vector<std::vector<double> > outs(3u, std::vector<double>(rows * m));
+        std::vector<std::thread> threads;
+        for (auto t = 0u; t < outs.size(); ++t)
+        {
+            threads.emplace_back([&le, &in, &outs, t, rows]() {le(in.data(), outs[t].data(), rows);});
+        }
+        for (auto &th : threads) th.join();
+        for (const auto &o : outs)
+        {
+            if (std::memcmp(o.data(), expected.data(), o.size() * sizeof(double)) != 0) return true;
+        }
+    }
+    return false;
+}
+
+/// This test checks the level-parallel evaluation of wide expressions
+int main() {
+    try {
+        dcgp::function_set basic_set({"sum","diff"});
+        dcgp::level_evaluator le(dcgp::expression(1, 1, 1, 1, 1, basic_set(), 123), 1u, 0u);
+        return 1;
+    } catch (const dcgp::input_error&) {}
+    return test_fails(2, 4, 1, 10, 11, 100, 1, 128, 32) ||
+           test_fails(3, 2, 20, 20, 21, 1000, 1, 64, 4) ||
+           test_fails(3, 2, 20, 20, 3, 1000, 4, 64, 4) ||
+           test_fails(4, 4, 100, 20, 2, 777, 3, 16, 1) ||
+           test_fails(4, 4, 100, 20, 2, 5000, 0, 128, 32) ||
+           test_fails(2, 1, 50, 10, 11, 1, 8, 1, 7) ||
+           test_fails(2, 1, 50, 10, 11, 0, 2, 8, 8);
+}
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "../src/dcgp.h"
+
+bool close_to(double a, double b, double rtol)
+{
+    return std::abs(a - b) <= rtol * std::max(1., std::abs(b));
+}
+
+/// Checks the fused losses against a naive two-pass computation in extended precision
+bool test_fails(
+        unsigned int n,
+        unsigned int m,
+        unsigned int N, // number of points
+        unsigned int seed)
+{
+    std::default_random_engine re(seed);
+    dcgp::dataset data(N, n, m, dcgp::ROW_MAJOR);
+    for (auto i = 0u; i < N; ++i)
+    {
+        for (auto j = 0u; j < n; ++j) data.set_in(i, j, std::uniform_real_distribution<double>(-1, 1)(re));
+        for (auto j = 0u; j < m; ++j) data.set_out(i, j, std::uniform_real_distribution<double>(-1, 1)(re));
+    }
+    // div makes some outputs non finite
+    dcgp::function_set basic_set({"sum","diff","mul","div"});
+    dcgp::expression ex(n, m, 2, 10, 11, basic_set(), seed);
+
+    long double sse = 0., sae = 0., max_error = 0.;
+    std::vector<long double> sum_y(m, 0.), sum_y2(m, 0.);
+    std::vector<std::size_t> counts(m, 0u);
+    std::size_t count = 0u, non_finite = 0u;
+    std::vector<double> in(n);
+    for (auto i = 0u; i < N; ++i)
+    {
+        for (auto j = 0u; j < n; ++j) in[j] = data.in(i, j);
+        std::vector<double> out = ex(in);
+        for (auto j = 0u; j < m; ++j)
+        {
+            if (!std::isfinite(out[j]))
+            {
+                ++non_finite;
+                continue;
+            }
+            long double err = data.out(i, j) - out[j];
+            sse += err * err;
+            sae += std::abs(err);
+            max_error = std::max(max_error, std::abs(err));
+            sum_y[j] += data.out(i, j);
+            sum_y2[j] += static_cast<long double>(data.out(i, j)) * data.out(i, j);
+            ++counts[j];
+            ++count;
+        }
+    }
+    long double sst = 0.;
+    for (auto j = 0u; j < m; ++j)
+    {
+        if (counts[j] > 0u) sst += sum_y2[j] - sum_y[j] * sum_y[j] / counts[j];
+    }
+
+    for (auto n_threads : {1u, 3u, 8u})
+    {
+        if (count == 0u || non_finite > 0u)
+        {
+            const double inf = std::numeric_limits<double>::infinity();
+            if (dcgp::data_loss(ex, data, dcgp::MSE, n_threads) != inf || dcgp::data_loss(ex, data, dcgp::MAX_ERROR, n_threads) != inf) return true;
+            if (dcgp::data_loss(ex, data, dcgp::R2, n_threads) != -inf) return true;
+            continue;
+        }
+        if (!close_to(dcgp::data_loss(ex, data, dcgp::MSE, n_threads), static_cast<double>(sse / count), 1e-13)) return true;
+        if (!close_to(dcgp::data_loss(ex, data, dcgp::RMSE, n_threads), std::sqrt(static_cast<double>(sse / count)), 1e-13)) return true;
+        if (!close_to(dcgp::data_loss(ex, data, dcgp::MAE, n_threads), static_cast<double>(sae / count), 1e-13)) return true;
+        if (dcgp::data_loss(ex, data, dcgp::MAX_ERROR, n_threads) != static_cast<double>(max_error)) return true;
+        if (!close_to(dcgp::data_loss(ex, data, dcgp::R2, n_threads), static_cast<double>(1. - sse / sst), 1e-10)) return true;
+    }
+    return false;
+}
+
+/// A perfect model has zero error and R2 = 1, also on many points
+bool test_exact_fails(unsigned int N)
+{
+    dcgp::function_set sum_set({"sum"});
+    dcgp::expression ex(1, 1, 1, 1, 1, sum_set(), 123);
+    ex.set({0, 0, 0, 1}); // 2 * x
+    dcgp::dataset data(N, 1, 1);
+    for (auto i = 0u; i < N; ++i)
+    {
+        data.set_in(i, 0, 0.5 * i);
+        data.set_out(i, 0, i);
+    }
+    if (dcgp::data_loss(ex, data, dcgp::MSE, 4) != 0. || dcgp::data_loss(ex, data, dcgp::R2, 4) != 1.) return true;
+    // a constant error is recovered exactly
+    for (auto i = 0u; i < N; ++i)
+    {
+        data.set_out(i, 0, data.out(i, 0) + 0.125);
+    }
+    return dcgp::data_loss(ex, data, dcgp::MAE, 4) != 0.125 || dcgp::data_loss(ex, data, dcgp::RMSE, 2) != 0.125 || dcgp::data_loss(ex, data, dcgp::MAX_ERROR, 3) != 0.125;
+}
+
+/// A candidate which is mostly NaN loses to a finite mediocre one, however good its few finite outputs are
+bool test_non_finite_fails(unsigned int N)
+{
+    dcgp::function_set set({"sum", "div"});
+    dcgp::expression nan_ex(1, 1, 1, 1, 1, set(), 123), mediocre_ex(1, 1, 1, 1, 1, set(), 123);
+    nan_ex.set({1, 0, 0, 1}); // x / x, NaN at 0 and exact elsewhere
+    mediocre_ex.set({0, 0, 0, 1}); // 2 * x
+    dcgp::dataset data(N, 1, 1);
+    for (auto i = 0u; i < N; ++i)
+    {
+        data.set_in(i, 0, (i % 10u == 0u) ? 1. : 0.);
+        data.set_out(i, 0, 1.);
+    }
+    for (auto type : {dcgp::MSE, dcgp::RMSE, dcgp::MAE, dcgp::MAX_ERROR})
+    {
+        if (!(dcgp::data_loss(mediocre_ex, data, type, 3) < dcgp::data_loss(nan_ex, data, type, 3))) return true;
+    }
+    return !(dcgp::data_loss(mediocre_ex, data, dcgp::R2, 3) > dcgp::data_loss(nan_ex, data, dcgp::R2, 3));
+}
+
+/// This test checks the fused losses
+int main() {
+    return test_fails(1, 1, 1000, 123) ||
+           test_fails(2, 3, 10001, 456) ||
+           test_fails(3, 1, 7, 789) ||
+           test_fails(2, 2, 100000, 1) ||
+           test_exact_fails(1000000) ||
+           test_non_finite_fails(1000);
+}
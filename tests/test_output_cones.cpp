@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "../src/dcgp.h"
+
+/// Checks the cones, and that any subset of the outputs matches dcgp::expression::eval_into
+bool test_fails(unsigned int n, unsigned int m, unsigned int r, unsigned int c, unsigned int l, unsigned int seed)
+{
+    dcgp::function_set set({"sum","diff","mul","div","sqrt"});
+    dcgp::expression ex(n, m, r, c, l, set(), seed);
+    std::default_random_engine re(seed);
+    std::uniform_real_distribution<double> dist(-2., 2.);
+    dcgp::workspace ws;
+    std::vector<double> in(n), all(m), some(m);
+    for (auto trial = 0u; trial < 20u; ++trial)
+    {
+        // the cones are kept up to date by the mutations, and their union is the active nodes
+        ex.mutate_active();
+        std::vector<unsigned int> cones;
+        for (auto j = 0u; j < m; ++j)
+        {
+            const std::vector<unsigned int>& cone = ex.get_output_cone(j);
+            if (!std::is_sorted(cone.begin(), cone.end())) return true;
+            if (!std::binary_search(cone.begin(), cone.end(), ex.get()[3u * r * c + j])) return true;
+            cones.insert(cones.end(), cone.begin(), cone.end());
+        }
+        std::sort(cones.begin(), cones.end());
+        cones.erase(std::unique(cones.begin(), cones.end()), cones.end());
+        if (cones != ex.get_active_nodes()) return true;
+
+        for (auto &v : in) v = dist(re);
+        ex.eval_into(in.data(), all.data(), ws);
+        // a random subset of the outputs, in a random order, possibly repeated
+        std::vector<unsigned int> outputs(1u + trial % m);
+        for (auto &o : outputs) o = std::uniform_int_distribution<unsigned int>(0u, m - 1u)(re);
+        ex.eval_outputs_into(in.data(), outputs.data(), outputs.size(), some.data(), ws);
+        for (auto k = 0u; k < outputs.size(); ++k)
+        {
+            if (std::memcmp(&some[k], &all[outputs[k]], sizeof(double)) != 0) return true;
+        }
+        const std::vector<double> copy = ex.eval_outputs(in, outputs);
+        if (copy.size() != outputs.size() || std::memcmp(copy.data(), some.data(), copy.size() * sizeof(double)) != 0) return true;
+    }
+    try {
+        ex.get_output_cone(m);
+        return true;
+    } catch (const dcgp::input_error&) {}
+    try {
+        const unsigned int bad = m;
+        ex.eval_outputs_into(in.data(), &bad, 1u, some.data(), ws);
+        return true;
+    } catch (const dcgp::input_error&) {}
+    return false;
+}
+
+/// This test checks the evaluation of subsets of the outputs
+int main() {
+    return test_fails(2, 1, 2, 3, 4, 123) ||
+           test_fails(2, 4, 2, 3, 4, 123) ||
+           test_fails(2, 4, 10, 10, 11, 456) ||
+           test_fails(3, 8, 20, 20, 21, 789) ||
+           test_fails(1, 3, 1, 100, 101, 321);
+}
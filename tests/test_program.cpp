@@ -0,0 +1,76 @@
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../src/dcgp.h"
+
+// equality of the outputs, bit-for-bit if numbers (NaNs may differ in sign and payload)
+bool same(double a, double b)
+{
+    if (std::isnan(a) || std::isnan(b)) return std::isnan(a) && std::isnan(b);
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+/// Checks that optimized programs compute the outputs of the expression
+bool test_fails(
+        unsigned int n,
+        unsigned int m,
+        unsigned int r,
+        unsigned int c,
+        unsigned int l,
+        unsigned int seed)
+{
+    dcgp::function_set all_set({"sum","diff","mul","div","pow","sqrt"});
+    dcgp::expression ex(n, m, r, c, l, all_set(), seed);
+    std::default_random_engine re(seed);
+    std::vector<double> in(n);
+    for (auto k = 0u; k < 20u; ++k)
+    {
+        ex.mutate_active();
+        const std::vector<unsigned int> chromosome = ex.get();
+        dcgp::program plain(ex, dcgp::NO_OPTIMIZATION), exact(ex);
+        if (ex.get() != chromosome) return true;
+        if (exact.get_instructions().size() > plain.get_instructions().size()) return true;
+        for (auto i = 0u; i < 100u; ++i)
+        {
+            for (auto j = 0u; j < n; ++j) in[j] = (i % 10u == 0u) ? 0. : std::uniform_real_distribution<double>(-3, 3)(re);
+            std::vector<double> expected = ex(in), out_plain = plain(in), out_exact = exact(in);
+            for (auto j = 0u; j < m; ++j)
+            {
+                if (std::memcmp(&out_plain[j], &expected[j], sizeof(double)) != 0) return true;
+                if (!same(out_exact[j], expected[j])) return true;
+            }
+        }
+    }
+    return false;
+}
+
+/// Checks the rewrites on a graph with redundant work
+bool test_rewrites_fails()
+{
+    dcgp::function_set all_set({"sum","diff","mul","div","pow","sqrt"});
+    dcgp::expression ex(2, 2, 1, 7, 8, all_set(), 123);
+    // x0 - x0, x1 / x1, pow(|x0|, x1 / x1), x0 * x1, x1 * x0, x0 * x1 + x1 * x0, pow(|x0|, x1 / x1) + x0 - x0
+    ex.set({1, 0, 0, 3, 1, 1, 4, 0, 3, 2, 0, 1, 2, 1, 0, 0, 5, 6, 0, 4, 2, 7, 8});
+    dcgp::program plain(ex, dcgp::NO_OPTIMIZATION), exact(ex, dcgp::EXACT_OPTIMIZATION), algebraic(ex, dcgp::ALGEBRAIC_OPTIMIZATION);
+    if (plain.get_instructions().size() != 7u) return true;
+    // x1 * x0 is computed once
+    if (exact.get_instructions().size() != 6u) return true;
+    // |x0|, x0 * x1 and the sum remain
+    if (algebraic.get_instructions().size() != 3u) return true;
+    if (algebraic.get_outputs()[1] != 2u || algebraic.get_instructions()[0].m_op != dcgp::OP_ABS) return true;
+    std::vector<double> in = {-1.5, 2.25};
+    std::vector<double> expected = ex(in), out = algebraic(in);
+    return !same(out[0], expected[0]) || !same(out[1], expected[1]);
+}
+
+/// This test checks the graph optimization pass
+int main() {
+    return test_fails(2, 1, 1, 20, 21, 123) ||
+           test_fails(3, 2, 2, 10, 11, 456) ||
+           test_fails(1, 3, 5, 5, 6, 789) ||
+           test_fails(4, 4, 1, 50, 51, 1) ||
+           test_rewrites_fails();
+}
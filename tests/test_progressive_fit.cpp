@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "../src/dcgp.h"
+
+bool close_to(double a, double b)
+{
+    return std::abs(a - b) <= 1e-9 * std::max(1., std::abs(b));
+}
+
+/// Checks the successive halving evaluation of a batch of candidates
+bool test_fails(
+        unsigned int N, // number of points
+        std::size_t min_sample,
+        unsigned int eta,
+        unsigned int n_candidates,
+        dcgp::fitness_type type)
+{
+    std::default_random_engine re(123);
+    dcgp::dataset data(N, 2, 1);
+    for (auto i = 0u; i < N; ++i)
+    {
+        data.set_in(i, 0, std::uniform_real_distribution<double>(-1, 1)(re));
+        data.set_in(i, 1, std::uniform_real_distribution<double>(-1, 1)(re));
+        data.set_out(i, 0, data.in(i, 0) * data.in(i, 1) + data.in(i, 0));
+    }
+    dcgp::function_set basic_set({"sum","diff","mul","div"});
+    std::vector<dcgp::expression> candidates;
+    for (auto k = 0u; k < n_candidates; ++k)
+    {
+        candidates.push_back(dcgp::expression(2, 1, 1, 10, 11, basic_set(), 123 + k));
+    }
+
+    dcgp::progressive_fit fit(data, min_sample, eta, 8u, type, 0.1, 123);
+    const std::vector<std::size_t> sizes = fit.get_sample_sizes();
+    if (sizes.empty() || sizes.back() != N || sizes[0] < std::min<std::size_t>(min_sample, N)) return true;
+    for (auto k = 1u; k < sizes.size(); ++k)
+    {
+        if (sizes[k] <= sizes[k - 1]) return true;
+    }
+
+    std::vector<double> f = fit(candidates);
+    std::vector<std::size_t> evaluated = fit.get_evaluated_points();
+    // the survivors of all halvings have the fitness of simple_data_fit (up to rounding), and are the best
+    double best_full = -1.;
+    unsigned int n_full = 0u;
+    for (auto c = 0u; c < n_candidates; ++c)
+    {
+        if (evaluated[c] == N)
+        {
+            ++n_full;
+            if (!close_to(f[c], dcgp::simple_data_fit(candidates[c], data, type, 0.1))) return true;
+            if (!close_to(f[c], fit(candidates[c]))) return true;
+            best_full = std::max(best_full, f[c]);
+        } else if (evaluated[c] == 0u) {
+            return true;
+        }
+    }
+    if (n_full == 0u || n_full > std::max(1u, n_candidates)) return true;
+    if (sizes.size() > 1u && n_candidates > 1u && fit.get_point_evaluations() >= static_cast<unsigned long long>(n_candidates) * N) return true;
+
+    // subsamples are fixed within a generation
+    if (fit(candidates) != f) return true;
+    fit.new_generation();
+    std::vector<double> g = fit(candidates);
+    for (auto c = 0u; c < n_candidates; ++c)
+    {
+        if (fit.get_evaluated_points()[c] == N && !close_to(g[c], dcgp::simple_data_fit(candidates[c], data, type, 0.1))) return true;
+    }
+    return false;
+}
+
+/// The subset version of simple_data_fit on all points matches the whole-dataset version
+bool test_subset_fails()
+{
+    std::default_random_engine re(123);
+    dcgp::dataset data(1000, 1, 1);
+    for (auto i = 0u; i < 1000u; ++i)
+    {
+        data.set_in(i, 0, std::uniform_real_distribution<double>(-1, 1)(re));
+        data.set_out(i, 0, std::sin(data.in(i, 0)));
+    }
+    std::vector<std::size_t> indices(1000u);
+    std::iota(indices.begin(), indices.end(), std::size_t(0u));
+    dcgp::function_set basic_set({"sum","diff","mul","div"});
+    dcgp::expression ex(1, 1, 1, 10, 11, basic_set(), 123);
+    if (dcgp::simple_data_fit(ex, data, indices.data(), indices.size()) != dcgp::simple_data_fit(ex, data)) return true;
+    indices.push_back(1000u);
+    try {
+        dcgp::simple_data_fit(ex, data, indices.data(), indices.size());
+        return true;
+    } catch (const dcgp::input_error&) {}
+    return false;
+}
+
+/// This test checks the progressive subsampled fitness evaluation
+int main() {
+    return test_fails(20000, 500, 2, 32, dcgp::ERROR_BASED) ||
+           test_fails(20000, 500, 3, 32, dcgp::HITS_BASED) ||
+           test_fails(1000, 2000, 2, 8, dcgp::ERROR_BASED) ||
+           test_fails(777, 10, 4, 1, dcgp::ERROR_BASED) ||
+           test_fails(5000, 100, 2, 100, dcgp::HITS_BASED) ||
+           test_subset_fails();
+}
@@ -0,0 +1,99 @@
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "../src/dcgp.h"
+
+dcgp::dataset make_data(std::size_t rows)
+{
+    std::default_random_engine re(123u);
+    std::uniform_real_distribution<double> dist(-2., 2.);
+    dcgp::dataset data(rows, 2, 2);
+    for (auto i = 0u; i < rows; ++i)
+    {
+        data.set_in(i, 0, dist(re));
+        data.set_in(i, 1, dist(re));
+        data.set_out(i, 0, data.in(i, 0) * data.in(i, 1));
+        data.set_out(i, 1, data.in(i, 0) + data.in(i, 1));
+    }
+    return data;
+}
+
+/// Evaluates a lineage of mutants with and without the cache, the fitness must be the same bit by bit
+bool check_lineage(dcgp::semantic_cache& cache, const dcgp::function_set& set, unsigned int seed, unsigned int mutants)
+{
+    dcgp::expression ex(2, 2, 3, 10, 11, set(), seed);
+    for (auto k = 0u; k < mutants; ++k)
+    {
+        const double expected = dcgp::simple_data_fit(ex, cache.get_data());
+        const double cached = dcgp::simple_data_fit(ex, cache);
+        if (std::memcmp(&expected, &cached, sizeof(double)) != 0) return true;
+        ex.mutate_active();
+    }
+    return false;
+}
+
+/// Checks the cached fitness, with a cache large enough for all the columns or evicting most of them
+bool test_fails(std::size_t rows, std::size_t max_bytes, unsigned int n_threads)
+{
+    dcgp::function_set set({"sum","diff","mul","div","sqrt"});
+    dcgp::semantic_cache cache(make_data(rows), set(), max_bytes);
+    std::vector<char> failed(n_threads, 0);
+    std::vector<std::thread> threads;
+    for (auto t = 0u; t < n_threads; ++t)
+    {
+        threads.emplace_back([&, t]() {failed[t] = check_lineage(cache, set, 123u + t % 2u, 200u);});
+    }
+    for (auto &th : threads)
+    {
+        th.join();
+    }
+    for (auto f : failed)
+    {
+        if (f) return true;
+    }
+    if (cache.get_bytes() > max_bytes || cache.get_bytes() != cache.get_columns() * rows * sizeof(double)) return true;
+    // every column is reached by the keys of its nodes, and the keys are evicted with it
+    if (cache.get_keys() < cache.get_columns() || cache.get_keys() > 4u * cache.get_columns()) return true;
+    // a mutation changes few nodes: most of them are found in the cache
+    return cache.get_hits() == 0u || cache.get_misses() == 0u;
+}
+
+/// Checks that equal columns are merged: x + y and y + x are one column, and so are the products built on them
+bool test_merge_fails()
+{
+    dcgp::function_set set({"sum","mul"});
+    dcgp::semantic_cache cache(make_data(100u), set(), 1u << 20);
+    dcgp::expression ex(2, 2, 1, 2, 2, set(), 123u);
+    // node 2 = x + y, node 3 = node 2 * node 2, outputs node 3 and node 2
+    ex.set({0, 0, 1, 1, 2, 2, 3, 2});
+    cache.evaluate(ex);
+    if (cache.get_misses() != 2u || cache.get_columns() != 2u) return true;
+    // node 2 = y + x, computed again but merged, then node 3 is found
+    ex.set({0, 1, 0, 1, 2, 2, 3, 2});
+    std::vector<dcgp::semantic_cache::column> out = cache.evaluate(ex);
+    if (cache.get_misses() != 3u || cache.get_merged() != 1u || cache.get_hits() != 1u || cache.get_columns() != 2u || cache.get_keys() != 3u) return true;
+    if (out.size() != 2u || out[1]->size() != 100u || (*out[1])[7] != cache.get_data().out(7, 1)) return true;
+    cache.clear();
+    return cache.get_columns() != 0u || cache.get_keys() != 0u || cache.get_bytes() != 0u || cache.evaluate(ex).size() != 2u;
+}
+
+/// This test checks the semantic cache
+int main() {
+    dcgp::function_set set({"sum","diff"}), other({"sum","mul"});
+    try {
+        dcgp::semantic_cache cache(make_data(100u), set(), 100u);
+        return 1;
+    } catch (const dcgp::input_error&) {}
+    try {
+        dcgp::semantic_cache cache(make_data(100u), set());
+        cache.evaluate(dcgp::expression(2, 2, 1, 2, 3, other(), 123u));
+        return 1;
+    } catch (const dcgp::input_error&) {}
+    return test_merge_fails() ||
+           test_fails(1000u, 1u << 24, 1u) ||
+           test_fails(1000u, 20u * 1000u * sizeof(double), 1u) ||
+           test_fails(1000u, 1u << 24, 4u) ||
+           test_fails(1000u, 20u * 1000u * sizeof(double), 4u);
+}
@@ -0,0 +1,82 @@
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <cmath>
+
+#include "../src/dcgp.h"
+
+bool test_fails(
+        unsigned int pop_size,
+        unsigned int n_threads,
+        unsigned int N) // number of samples
+{
+    dcgp::function_set basic_set({"sum","diff","mul","div"});
+    dcgp::expression prototype(1, 1, 1, 15, 16, basic_set(), 123);
+
+    // 1) we create N data points
+    std::default_random_engine re(12);
+    std::vector<std::vector<double> > in;
+    std::vector<std::vector<double> > out;
+
+    // Koza quartic polynomial x^4 + x^3 + x^2 + x
+    std::function<double(double)> f = [](double x){return x*x*x*x + x*x*x + x*x + x;};
+    for (auto i = 0u; i < N; ++i)
+    {
+        double x = std::uniform_real_distribution<double>(-1, 1)(re);
+        in.push_back({x});
+        out.push_back({f(x)});
+    }
+
+    /// 2) we evolve the population until one individual fits all points (maximization problem)
+    /// restarting from a new population whenever it gets stuck
+    auto fitness = [&in, &out](const dcgp::expression& ex) {return dcgp::simple_data_fit(ex, in, out, dcgp::fitness_type::HITS_BASED, 1e-8);};
+    for (auto restart = 0u; restart < 10u; ++restart)
+    {
+        dcgp::steady_state engine(prototype, fitness, pop_size, n_threads, 4u, 123u + restart);
+        bool solved = engine.evolve(200000u, N);
+
+        // the population must be intact and the best chromosome must have the fitness reported
+        if (engine.get_chromosomes().size() != pop_size || engine.get_fitness().size() != pop_size) return true;
+        dcgp::expression ex = prototype;
+        ex.set(engine.get_best_chromosome());
+        if (fitness(ex) != engine.get_best_fitness()) return true;
+
+        if (solved)
+        {
+            std::vector<std::string> in_sym({"x"});
+            std::cout << "Population: " << pop_size << ", threads: " << n_threads << ", restarts: " << restart << std::endl;
+            std::cout << "Evaluations: " << engine.get_evaluations() << ", insertions: " << engine.get_insertions() << std::endl;
+            std::cout << "Final expression: " << ex(in_sym) << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/// evolve must return when the tournaments or the mutations evaluate nothing
+bool test_stuck_fails(unsigned int n_threads)
+{
+    dcgp::function_set basic_set({"sum","diff","mul","div"});
+    dcgp::expression prototype(1, 1, 1, 15, 16, basic_set(), 123);
+    // a population with NaN fitness only is still evolved, NaN ranking last
+    auto nan_fitness = [](const dcgp::expression&) {return std::nan("");};
+    dcgp::steady_state nan_engine(prototype, nan_fitness, 8u, n_threads, 4u, 123u);
+    if (nan_engine.evolve(100u, 1e300) || nan_engine.get_evaluations() == 0u || nan_engine.get_evaluations() > 100u) return true;
+
+    // no gene of a single node expression with one function can change
+    dcgp::function_set sum_set({"sum"});
+    dcgp::expression fixed(1, 1, 1, 1, 1, sum_set(), 123);
+    auto fitness = [](const dcgp::expression&) {return 0.;};
+    dcgp::steady_state fixed_engine(fixed, fitness, 8u, n_threads, 4u, 123u);
+    return fixed_engine.evolve(100u, 1.) || fixed_engine.get_evaluations() != 0u;
+}
+
+/// This test evolves the Koza quartic polynomial with a different number of workers and
+/// passes if a solution is found
+int main() {
+    return test_stuck_fails(1) ||
+           test_stuck_fails(3) ||
+           test_fails(20, 1, 10) ||
+           test_fails(20, 4, 10) ||
+           test_fails(100, 3, 10);
+}
@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "../src/dcgp.h"
+
+bool close_to(double a, double b)
+{
+    return std::abs(a - b) <= 1e-12 * std::max(1., std::abs(b));
+}
+
+/// Checks that the fitness streamed from each kind of source equals the in-memory fitness
+bool test_fails(
+        unsigned int n,
+        unsigned int m,
+        unsigned int N, // number of points
+        std::size_t chunk_rows)
+{
+    std::default_random_engine re(123);
+    dcgp::dataset data(N, n, m);
+    for (auto i = 0u; i < N; ++i)
+    {
+        for (auto j = 0u; j < n; ++j) data.set_in(i, j, std::uniform_real_distribution<double>(-1, 1)(re));
+        for (auto j = 0u; j < m; ++j) data.set_out(i, j, std::uniform_real_distribution<double>(-1, 1)(re));
+    }
+    dcgp::save_binary_dataset(data, "test_streaming_fit.bin");
+
+    dcgp::function_set basic_set({"sum","diff","mul","div"});
+    std::vector<dcgp::expression> candidates;
+    for (auto k = 0u; k < 5u; ++k)
+    {
+        candidates.push_back(dcgp::expression(n, m, 2, 10, 11, basic_set(), 123 + k));
+    }
+
+    dcgp::binary_file_source file(std::string("test_streaming_fit.bin"));
+    dcgp::dataset_source window(dcgp::load_binary_dataset("test_streaming_fit.bin"));
+    dcgp::generator_source generator(n, m, N, [&data, n, m](std::size_t i, double *point) {
+        for (auto j = 0u; j < n + m; ++j) point[j] = data.row(i)[j];
+    });
+    std::remove("test_streaming_fit.bin");
+    if (file.rows() != N) return true;
+
+    for (dcgp::chunk_source *source : {static_cast<dcgp::chunk_source*>(&file), static_cast<dcgp::chunk_source*>(&window), static_cast<dcgp::chunk_source*>(&generator)})
+    {
+        // twice, as sources are rewound
+        for (auto pass = 0u; pass < 2u; ++pass)
+        {
+            std::vector<double> batch = dcgp::streaming_data_fit(candidates, *source, chunk_rows);
+            for (auto k = 0u; k < candidates.size(); ++k)
+            {
+                if (!close_to(batch[k], dcgp::simple_data_fit(candidates[k], data))) return true;
+            }
+        }
+        double hits = dcgp::streaming_data_fit(candidates[0], *source, chunk_rows, dcgp::HITS_BASED, 0.5);
+        if (hits != dcgp::simple_data_fit(candidates[0], data, dcgp::HITS_BASED, 0.5)) return true;
+    }
+    return false;
+}
+
+/// Errors raised by the source must reach the caller
+bool test_source_error_fails()
+{
+    dcgp::generator_source generator(1, 1, 1000, [](std::size_t i, double *point) {
+        if (i == 700) throw std::runtime_error("generator failure");
+        point[0] = point[1] = 0.;
+    });
+    dcgp::function_set basic_set({"sum","diff","mul","div"});
+    dcgp::expression ex(1, 1, 1, 5, 6, basic_set(), 123);
+    try {
+        dcgp::streaming_data_fit(ex, generator, 100);
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+    return true;
+}
+
+/// This test checks the out-of-core fitness evaluation
+int main() {
+    return test_fails(2, 1, 1000, 128) ||
+           test_fails(3, 2, 10001, 1000) ||
+           test_fails(1, 1, 7, 100) ||
+           test_fails(2, 3, 0, 16) ||
+           test_source_error_fails();
+}
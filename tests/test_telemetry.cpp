@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/dcgp.h"
+
+/// Checks that every record pushed is either written or dropped, and the binary round trip
+bool test_logger_fails(std::size_t capacity, unsigned int n_records)
+{
+    const std::string filename = "test_telemetry.bin";
+    unsigned long accepted = 0u;
+    {
+        dcgp::telemetry_logger logger(filename, 2u, dcgp::TELEMETRY_BINARY, capacity);
+        for (auto k = 0u; k < n_records; ++k)
+        {
+            dcgp::telemetry_record r = dcgp::telemetry_record();
+            r.m_source = k % 2u;
+            r.m_generation = k;
+            r.m_best_fitness = 0.5 * k;
+            accepted += logger.push(k % 2u, r);
+        }
+        logger.close();
+        if (logger.get_written() != accepted || logger.get_written() + logger.get_dropped() != n_records) return true;
+        // pushing on a closed logger drops
+        if (logger.push(0u, dcgp::telemetry_record()) || logger.get_dropped() != n_records - accepted + 1u) return true;
+        try {
+            logger.push(2u, dcgp::telemetry_record());
+            return true;
+        } catch (const dcgp::input_error&) {}
+    }
+    std::vector<dcgp::telemetry_record> records = dcgp::load_telemetry(filename);
+    std::remove(filename.c_str());
+    if (records.size() != accepted) return true;
+    // the records of each producer keep their order
+    std::uint64_t last[2] = {0u, 0u};
+    bool seen[2] = {false, false};
+    for (const auto &r : records)
+    {
+        if (r.m_best_fitness != 0.5 * r.m_generation || r.m_generation % 2u != r.m_source) return true;
+        if (seen[r.m_source] && r.m_generation <= last[r.m_source]) return true;
+        seen[r.m_source] = true;
+        last[r.m_source] = r.m_generation;
+    }
+    return false;
+}
+
+/// Checks that the records accepted while the logger is being closed are written
+bool test_concurrent_close_fails(unsigned int n_producers)
+{
+    const std::string filename = "test_telemetry_close.bin";
+    std::vector<unsigned long> accepted(n_producers, 0u);
+    {
+        dcgp::telemetry_logger logger(filename, n_producers, dcgp::TELEMETRY_BINARY, 100000u);
+        std::vector<std::thread> producers;
+        for (auto i = 0u; i < n_producers; ++i)
+        {
+            producers.emplace_back([&logger, &accepted, i]() {
+                for (auto k = 0u; k < 100000u; ++k) accepted[i] += logger.push(i, dcgp::telemetry_record());
+            });
+        }
+        // closed while the producers are running
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        logger.close();
+        for (auto &t : producers) t.join();
+        unsigned long total = 0u;
+        for (auto a : accepted) total += a;
+        if (logger.get_written() != total || logger.get_written() + logger.get_dropped() != 100000u * n_producers) return true;
+    }
+    const std::size_t records = dcgp::load_telemetry(filename).size();
+    std::remove(filename.c_str());
+    unsigned long total = 0u;
+    for (auto a : accepted) total += a;
+    return records != total;
+}
+
+/// Checks that binary logs of another version or byte order are rejected
+bool test_header_fails()
+{
+    const std::string filename = "test_telemetry_header.bin";
+    {
+        dcgp::telemetry_logger logger(filename, 1u, dcgp::TELEMETRY_BINARY);
+        logger.push(0u, dcgp::telemetry_record());
+    }
+    std::vector<char> bytes;
+    {
+        std::ifstream is(filename, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+    }
+    if (dcgp::load_telemetry(filename).size() != 1u) return true;
+    // the magic takes 8 bytes, then the byte order mark, the version and the record size
+    for (std::size_t offset : {0u, 8u, 12u, 16u})
+    {
+        std::vector<char> corrupted(bytes);
+        corrupted[offset] ^= 0x40;
+        {
+            std::ofstream os(filename, std::ios::binary);
+            os.write(corrupted.data(), static_cast<std::streamsize>(corrupted.size()));
+        }
+        try {
+            dcgp::load_telemetry(filename);
+            std::remove(filename.c_str());
+            return true;
+        } catch (const dcgp::input_error&) {}
+    }
+    std::remove(filename.c_str());
+    return false;
+}
+
+/// Checks the records of the evolution drivers
+bool test_drivers_fails()
+{
+    dcgp::function_set basic_set({"sum","diff","mul","div"});
+    dcgp::expression prototype(1, 1, 1, 15, 16, basic_set(), 123);
+    std::vector<std::vector<double> > in, out;
+    for (auto i = 0u; i < 10u; ++i)
+    {
+        const double x = -1. + 0.2 * i;
+        in.push_back({x});
+        out.push_back({x * x * x * x + x * x * x + x * x + x});
+    }
+    dcgp::fitness_function fitness = [&in, &out](const dcgp::expression& ex) {return dcgp::simple_data_fit(ex, in, out);};
+
+    const std::string filename = "test_telemetry.csv";
+    std::shared_ptr<dcgp::telemetry_logger> logger = std::make_shared<dcgp::telemetry_logger>(filename, 3u, dcgp::TELEMETRY_CSV, 100000u);
+    dcgp::island_model archipelago(prototype, fitness, 3u, dcgp::RING, 4u, 10u, 123u);
+    archipelago.set_pinning(false);
+    try {
+        archipelago.set_telemetry(std::make_shared<dcgp::telemetry_logger>(filename + ".2", 2u), 1u);
+        return true;
+    } catch (const dcgp::input_error&) {}
+    std::remove((filename + ".2").c_str());
+    archipelago.set_telemetry(logger, 5u);
+    archipelago.evolve(500u, 1e10);
+    logger->close();
+    unsigned long expected = 0u;
+    for (auto g : archipelago.get_generations()) expected += g / 5u;
+    if (logger->get_written() + logger->get_dropped() != expected || logger->get_written() == 0u) return true;
+
+    std::ifstream is(filename);
+    std::string line;
+    unsigned long lines = 0u;
+    std::getline(is, line);
+    if (line.find("source,generation,time,best_fitness") != 0u) return true;
+    while (std::getline(is, line))
+    {
+        ++lines;
+        // 12 columns
+        if (std::count(line.begin(), line.end(), ',') != 11) return true;
+    }
+    is.close();
+    std::remove(filename.c_str());
+    if (lines != logger->get_written()) return true;
+
+    // steady state: one record every 50 evaluations of each worker
+    dcgp::steady_state engine(prototype, fitness, 20u, 2u, 4u, 123u);
+    std::shared_ptr<dcgp::telemetry_logger> binary = std::make_shared<dcgp::telemetry_logger>("test_telemetry.bin", 2u, dcgp::TELEMETRY_BINARY, 100000u);
+    engine.set_telemetry(binary, 50u);
+    engine.evolve(1000u, 1e10);
+    binary->close();
+    std::vector<dcgp::telemetry_record> records = dcgp::load_telemetry("test_telemetry.bin");
+    std::remove("test_telemetry.bin");
+    // the iterations evaluating nothing use some of the budget: each worker writes one record per 50 evaluations it performed
+    if (records.empty() || records.size() > engine.get_evaluations() / 50u) return true;
+    unsigned long per_worker[2] = {0u, 0u};
+    for (const auto &r : records)
+    {
+        if (r.m_source > 1u || r.m_generation != 50u * ++per_worker[r.m_source] || r.m_evaluations != r.m_generation) return true;
+        if (!(r.m_active_min <= r.m_active_mean && r.m_active_mean <= r.m_active_max) || r.m_best_fitness < r.m_mean_fitness) return true;
+    }
+    return false;
+}
+
+/// This test checks the telemetry logger
+int main() {
+    return test_logger_fails(100000u, 10000u) ||
+           test_logger_fails(1u, 10000u) ||
+           test_concurrent_close_fails(4u) ||
+           test_header_fails() ||
+           test_drivers_fails();
+}
@@ -0,0 +1,72 @@
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "../src/dcgp.h"
+
+/// Checks that expressions built from a shared topology are those built from scratch
+bool test_fails(
+        unsigned int n,
+        unsigned int m,
+        unsigned int r,
+        unsigned int c,
+        unsigned int l,
+        unsigned int seed)
+{
+    dcgp::function_set all_set({"sum","diff","mul","div","pow","sqrt"});
+    std::shared_ptr<const dcgp::expression_topology> topology = dcgp::make_topology(n, m, r, c, l, all_set());
+    dcgp::expression ex(topology, seed), reference(n, m, r, c, l, all_set(), seed);
+    if (ex.get() != reference.get() || ex.get_active_genes() != reference.get_active_genes()) return true;
+    if (ex.get_n() != n || ex.get_m() != m || ex.get_r() != r || ex.get_c() != c || ex.get_l() != l) return true;
+    if (topology->size() != reference.get().size() || topology->get_f().size() != all_set().size()) return true;
+
+    // copies and new expressions share the topology
+    std::vector<dcgp::expression> population;
+    for (auto i = 0u; i < 100u; ++i)
+    {
+        population.push_back(dcgp::expression(ex.get_topology(), seed + i));
+    }
+    dcgp::expression copy(ex);
+    if (copy.get_topology() != topology || population.back().get_topology() != topology) return true;
+    if (topology.use_count() != 103) return true;
+
+    // mutations stay within the bounds of the topology
+    for (auto i = 0u; i < 100u; ++i)
+    {
+        copy.mutate_active();
+        reference.mutate_active();
+        if (copy.get() != reference.get()) return true;
+        for (auto g = 0u; g < topology->size(); ++g)
+        {
+            if (copy.get()[g] < topology->get_lb()[g] || copy.get()[g] > topology->get_ub()[g]) return true;
+        }
+    }
+    return false;
+}
+
+/// Checks the errors
+bool test_errors_fails()
+{
+    dcgp::function_set basic_set({"sum","diff","mul","div"});
+    try {
+        dcgp::expression(std::shared_ptr<const dcgp::expression_topology>(), 123);
+        return true;
+    } catch (const dcgp::input_error&) {}
+    try {
+        dcgp::make_topology(2, 1, 0, 10, 11, basic_set());
+        return true;
+    } catch (const dcgp::input_error&) {}
+    try {
+        dcgp::make_topology(2, 1, 1, 10, 11, std::vector<dcgp::basis_function>());
+        return true;
+    } catch (const dcgp::input_error&) {}
+    return false;
+}
+
+/// This test checks the shared topology of expressions
+int main() {
+    return test_fails(2, 1, 1, 20, 21, 123) ||
+           test_fails(3, 2, 2, 10, 3, 456) ||
+           test_fails(1, 3, 5, 5, 6, 789) ||
+           test_errors_fails();
+}
@@ -0,0 +1,86 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "../src/dcgp.h"
+
+/// Streams points through a window and checks the incremental fitness against dcgp::simple_data_fit on the window
+bool test_fails(dcgp::fitness_type type, std::size_t capacity, unsigned int seed)
+{
+    dcgp::function_set set({"sum","diff","mul","div"});
+    std::default_random_engine re(seed);
+    std::uniform_real_distribution<double> dist(-1., 1.);
+    std::uniform_int_distribution<std::size_t> chunk_size(0u, capacity + capacity / 2u);
+    dcgp::data_window window(2, 2, capacity);
+    std::vector<dcgp::window_fit> fits;
+    for (auto k = 0u; k < 5u; ++k)
+    {
+        fits.emplace_back(dcgp::expression(2, 2, 2, 8, 9, set(), seed + k), type, 1e-1);
+    }
+    for (auto update = 0u; update < 300u; ++update)
+    {
+        const std::size_t pushed = chunk_size(re);
+        if (update % 2u)
+        {
+            for (auto i = 0u; i < pushed; ++i)
+            {
+                const double in[2] = {dist(re), dist(re)};
+                const double out[2] = {in[0] * in[1], in[0] + 0.1 * dist(re)};
+                window.push(in, out);
+            }
+        } else {
+            dcgp::dataset chunk(pushed, 2, 2);
+            for (auto i = 0u; i < pushed; ++i)
+            {
+                chunk.set_in(i, 0, dist(re));
+                chunk.set_in(i, 1, dist(re));
+                chunk.set_out(i, 0, chunk.in(i, 0) * chunk.in(i, 1));
+                chunk.set_out(i, 1, chunk.in(i, 0) + 0.1 * dist(re));
+            }
+            window.push(chunk);
+        }
+        if (window.rows() != std::min<unsigned long long>(window.end(), capacity)) return true;
+        const dcgp::dataset data = window.to_dataset();
+        for (auto &f : fits)
+        {
+            const unsigned long long before = f.get_evaluated();
+            const double fitness = f.update(window);
+            // only the new points are evaluated
+            if (f.get_evaluated() - before != std::min<std::size_t>(pushed, capacity)) return true;
+            const double expected = dcgp::simple_data_fit(f.get_expression(), data, type, 1e-1);
+            if (std::fabs(fitness - expected) > 1e-12 * std::max(1., std::fabs(expected))) return true;
+            if (type == dcgp::HITS_BASED && fitness != expected) return true;
+        }
+    }
+    // another window (here a copy) is followed from scratch
+    dcgp::data_window other(window);
+    const unsigned long long before = fits[0].get_evaluated();
+    fits[0].update(other);
+    if (fits[0].get_evaluated() - before != other.rows() || other.get_id() == window.get_id()) return true;
+    // as is a window assigned at the same address, with the same capacity, even if it holds fewer points
+    fits[1].update(window);
+    dcgp::data_window fewer(2, 2, capacity);
+    std::vector<double> point(4, 1.);
+    fewer.push(point.data(), point.data() + 2);
+    window = fewer;
+    const double fitness = fits[1].update(window);
+    return fitness != dcgp::simple_data_fit(fits[1].get_expression(), window.to_dataset(), type, 1e-1);
+}
+
+/// This test checks the fitness on a sliding window
+int main() {
+    try {
+        dcgp::data_window window(2, 2, 0u);
+        return 1;
+    } catch (const dcgp::input_error&) {}
+    try {
+        dcgp::function_set set({"sum"});
+        dcgp::window_fit f(dcgp::expression(1, 1, 1, 1, 1, set(), 123), dcgp::ERROR_BASED);
+        f.update(dcgp::data_window(2, 2, 10u));
+        return 1;
+    } catch (const dcgp::input_error&) {}
+    return test_fails(dcgp::ERROR_BASED, 100u, 123u) ||
+           test_fails(dcgp::HITS_BASED, 100u, 456u) ||
+           test_fails(dcgp::ERROR_BASED, 1u, 789u) ||
+           test_fails(dcgp::ERROR_BASED, 1000u, 321u);
+}